@@ -17,4 +17,13 @@ AppCliOptions::AppCliOptions()
 	addOption("connections").setType(cp::RpcValue::Type::String).setNames("--connections")
 			.setComment("Comma separated list of connection url strings. This enables option to specify predefined connections from command line. "
 						"Example: --config tcp://localhost:3755?name=conn1&user=test&password=test,wss://nirvana.elektroline.cz:37778?name=wss&user=foo&password=bar");
+	addOption("batch").setType(cp::RpcValue::Type::String).setNames("--batch")
+			.setComment("Run Cpon script file headless, without GUI, and write results to stdout. "
+						"Script: {\"connection\": \"url or saved connection name\", \"commands\": [[\"call\", path, method, params], "
+						"[\"subscribe\", path, signal, source, duration_msec], [\"crawl\", path, depth]]}, "
+						"call path segments can contain * and ? wildcards. "
+						"First --connections url is used when script does not specify connection.");
+	addOption("batchOutputFormat").setType(cp::RpcValue::Type::String).setNames("--batch-format")
+			.setDefaultValue("cpon")
+			.setComment("Format of headless mode results written to stdout, 'cpon' (one value per line) or 'chainpack'.");
 }
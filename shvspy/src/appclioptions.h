@@ -14,6 +14,8 @@ private:
 	CLIOPTION_GETTER_SETTER2(std::string, "configDir", c, setC, onfigDir)
 	// CLIOPTION_GETTER_SETTER2(int, "requestTimeout", r, setR, equestTimeout)
 	CLIOPTION_GETTER_SETTER2(std::string, "connections", c, setC, onnections)
+	CLIOPTION_GETTER_SETTER2(std::string, "batch", b, setB, atch)
+	CLIOPTION_GETTER_SETTER2(std::string, "batchOutputFormat", b, setB, atchOutputFormat)
 public:
 	AppCliOptions();
 	//~AppCliOptions() Q_DECL_OVERRIDE {}
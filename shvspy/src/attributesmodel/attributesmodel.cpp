@@ -2,6 +2,8 @@
 
 //#include "../theapp.h"
 #include "../servertreemodel/shvnodeitem.h"
+#include "../servertreemodel/shvbrokernodeitem.h"
+#include "../rpcvaluediff.h"
 
 #include <shv/chainpack/cponreader.h>
 //#include <shv/chainpack/cponwriter.h>
@@ -12,6 +14,7 @@
 #include <shv/iotqt/rpc/clientconnection.h>
 #include <shv/coreqt/rpc.h>
 
+#include <QDateTime>
 #include <QSettings>
 #include <QJsonDocument>
 #include <QJsonParseError>
@@ -46,52 +49,24 @@ QVariant AttributesModel::data(const QModelIndex &ix, int role) const
 {
 	if(m_shvTreeNodeItem.isNull())
 		return QVariant();
-	const QVector<ShvMetaMethod> &mms = m_shvTreeNodeItem->methods();
-	if(ix.row() < 0 || ix.row() >= mms.count())
+	if(ix.row() < 0 || ix.row() >= static_cast<int>(m_rows.size()))
 		return QVariant();
 	if(ix.column() < 0 || ix.column() >= ColCnt)
 		return QVariant();
 
+	const Row &row = m_rows[static_cast<unsigned>(ix.row())];
 	switch (role) {
 	case Qt::DisplayRole: {
 		switch (ix.column()) {
-		case ColMethodName:
-		case ColParamType:
-		case ColResultType: {
-			cp::RpcValue rv = m_rows[ix.row()][ix.column()];
-			return rv.isValid()? QString::fromStdString(rv.asString()): QVariant();
-		}
-		case ColSignals: {
-			cp::RpcValue rv = m_rows[ix.row()][ix.column()];
-			return rv.isValid()? QString::fromStdString(rv.toCpon()): QVariant();
-		}
-		case ColParams: {
-			//QVariant v = m_rows.value(ix.row()).value(ix.column());
-			cp::RpcValue rv = m_rows[ix.row()][ix.column()];
-			return rv.isValid()? QString::fromStdString(rv.toCpon()): QVariant();
-		}
-		case ColResult: {
-			if(m_rows[ix.row()][ColError].isIMap()) {
-				auto err = cp::RpcResponse::Error::fromRpcValue(m_rows[ix.row()][ColError].asIMap());
-				return QString::fromStdString(err.message());
-			}
-			{
-				cp::RpcValue rv = m_rows[ix.row()][ColResult];
-				if(!rv.isValid())
-					return QVariant();
-
-				static constexpr int MAX_TT_SIZE = 1024;
-				std::string tts = rv.toCpon();
-				if(tts.size() > MAX_TT_SIZE)
-					tts = tts.substr(0, MAX_TT_SIZE) + " < ... " + std::to_string(tts.size() - MAX_TT_SIZE) + " more bytes >";
-
-				//shvWarning() << tts << tts.length();
-				return QString::fromStdString(tts);
-			}
-		}
-		case ColFlags:
-		case ColAccessLevel:
-			return QString::fromStdString(m_rows[ix.row()][ix.column()].toString());
+		case ColMethodName: return row.methodName;
+		case ColParamType: return row.paramType;
+		case ColResultType: return row.resultType;
+		case ColSignals: return row.signalsStr;
+		case ColFlags: return row.flags;
+		case ColAccessLevel: return row.accessLevel;
+		case ColParams: return row.params;
+		case ColResult: return row.result;
+		case ColLatency: return row.latency;
 		default:
 			break;
 		}
@@ -99,9 +74,13 @@ QVariant AttributesModel::data(const QModelIndex &ix, int role) const
 	}
 	case Qt::EditRole: {
 		switch (ix.column()) {
-		case ColResult:
-		case ColParams: {
-			cp::RpcValue rv = m_rows[ix.row()][ix.column()];
+		case ColParams:
+			return row.params;
+		case ColResult: {
+			const ShvMetaMethod *mtd = metaMethodAt(static_cast<unsigned>(ix.row()));
+			if(!mtd)
+				return QVariant();
+			cp::RpcValue rv = mtd->response.isError()? mtd->response.error().toRpcValue(): mtd->response.result();
 			return rv.isValid()? QString::fromStdString(rv.toCpon()): QVariant();
 		}
 		default:
@@ -110,10 +89,14 @@ QVariant AttributesModel::data(const QModelIndex &ix, int role) const
 		break;
 	}
 	case RpcValueRole: {
+		const ShvMetaMethod *mtd = metaMethodAt(static_cast<unsigned>(ix.row()));
+		if(!mtd)
+			return QVariant();
 		switch (ix.column()) {
-		case ColResult:
-		case ColParams: {
-			cp::RpcValue rv = m_rows[ix.row()][ix.column()];
+		case ColParams:
+			return QVariant::fromValue(mtd->params);
+		case ColResult: {
+			cp::RpcValue rv = mtd->response.isError()? mtd->response.error().toRpcValue(): mtd->response.result();
 			return QVariant::fromValue(rv);
 		}
 		default:
@@ -123,12 +106,10 @@ QVariant AttributesModel::data(const QModelIndex &ix, int role) const
 	}
 	case Qt::DecorationRole: {
 		if(ix.column() == ColBtRun) {
-			bool is_notify = m_rows[ix.row()][ColFlags].toBool();
-			if(!is_notify) {
+			if(row.isCallable) {
 				static QIcon ico_run = QIcon(QStringLiteral(":/shvspy/images/run"));
 				static QIcon ico_reload = QIcon(QStringLiteral(":/shvspy/images/reload"));
-				auto v = m_rows[ix.row()][ColBtRun];
-				return (v.toUInt() > 0)? ico_reload: ico_run;
+				return (row.rpcRequestId > 0)? ico_reload: ico_run;
 			}
 		}
 		break;
@@ -138,16 +119,21 @@ QVariant AttributesModel::data(const QModelIndex &ix, int role) const
 			return tr("Call remote method");
 		}
 		if(ix.column() == ColResult) {
-			return data(ix, Qt::DisplayRole);
+			return row.result;
+		}
+		if(ix.column() == ColLatency) {
+			return row.latencyStats;
 		}
 		if(ix.column() == ColFlags) {
-			bool is_notify = m_rows[static_cast<unsigned>(ix.row())][ColFlags].toUInt() & cp::MetaMethod::Flag::IsSignal;
-			return is_notify? tr("Method is notify signal"): QVariant();
+			const ShvMetaMethod *mtd = metaMethodAt(static_cast<unsigned>(ix.row()));
+			return (mtd && mtd->isSignal())? tr("Method is notify signal"): QVariant();
 		}
 		if(ix.column() == ColMethodName) {
-			auto mm = shv::chainpack::MetaMethod::fromRpcValue(m_rows[static_cast<unsigned>(ix.row())][ColMetaMethod]);
+			const ShvMetaMethod *mtd = metaMethodAt(static_cast<unsigned>(ix.row()));
+			if(!mtd)
+				return QVariant();
 			QStringList lines;
-			for(const auto &[k, v] : mm.toMap()) {
+			for(const auto &[k, v] : mtd->metamethod.toMap()) {
 				lines << tr("%1: %2").arg(k.c_str(), v.toCpon().c_str());
 			}
 			return lines.join('\n');
@@ -175,7 +161,7 @@ bool AttributesModel::setData(const QModelIndex &ix, const QVariant &val, int ro
 						shvError() << "cannot set invalid cpon data:" << cpon << "error:" << err;
 				}
 				m_shvTreeNodeItem->setMethodParams(ix.row(), params);
-				loadRow(ix.row());
+				loadRowParams(ix.row());
 				emit dataChanged(ix, ix);
 				return true;
 			}
@@ -205,10 +191,14 @@ QVariant AttributesModel::headerData(int section, Qt::Orientation o, int role) c
 				ret = tr("Params");
 			else if(section == ColResult)
 				ret = tr("Result");
+			else if(section == ColLatency)
+				ret = tr("Latency");
 		}
 		else if(role == Qt::ToolTipRole) {
 			if(section == ColAccessLevel)
 				ret = tr("Acess Grant");
+			else if(section == ColLatency)
+				ret = tr("Method call round-trip time");
 		}
 	}
 	return ret;
@@ -224,6 +214,7 @@ void AttributesModel::load(ShvNodeItem *nd)
 		// Clazy false positive https://invent.kde.org/sdk/clazy/-/issues/22
 		connect(nd, &ShvNodeItem::methodsLoaded, this, &AttributesModel::onMethodsLoaded, Qt::UniqueConnection); // clazy:exclude=lambda-unique-connection
 		connect(nd, &ShvNodeItem::rpcMethodCallFinished, this, &AttributesModel::onRpcMethodCallFinished, Qt::UniqueConnection); // clazy:exclude=lambda-unique-connection
+		connect(nd, &ShvNodeItem::rpcMethodCallProgress, this, &AttributesModel::onRpcMethodCallProgress, Qt::UniqueConnection); // clazy:exclude=lambda-unique-connection
 		nd->checkMethodsLoaded();
 	}
 	loadRows();
@@ -233,9 +224,25 @@ void AttributesModel::callMethod(unsigned method_ix, bool throw_exc)
 {
 	if(m_shvTreeNodeItem.isNull())
 		return;
+	if(method_ix >= m_rows.size())
+		return;
 	unsigned rqid = m_shvTreeNodeItem->callMethod(method_ix, throw_exc);
-	m_rows[method_ix][ColBtRun] = rqid;
-	emitRowChanged(method_ix);
+	m_rows[method_ix].rpcRequestId = rqid;
+	emitCellsChanged(method_ix, ColBtRun, ColBtRun);
+}
+
+void AttributesModel::abortMethodCall(unsigned method_ix)
+{
+	if(m_shvTreeNodeItem.isNull())
+		return;
+	m_shvTreeNodeItem->abortMethodCall(method_ix);
+}
+
+bool AttributesModel::isMethodCallRunning(int row) const
+{
+	if(row < 0 || row >= static_cast<int>(m_rows.size()))
+		return false;
+	return m_rows[row].rpcRequestId > 0;
 }
 
 QString AttributesModel::path() const
@@ -246,6 +253,14 @@ QString AttributesModel::path() const
 	return QString::fromStdString(m_shvTreeNodeItem->shvPath());
 }
 
+std::string AttributesModel::brokerName() const
+{
+	if (m_shvTreeNodeItem.isNull()) {
+		return std::string();
+	}
+	return m_shvTreeNodeItem->serverNode()->nodeId();
+}
+
 QString AttributesModel::method(int row) const
 {
 	if (m_shvTreeNodeItem.isNull()) {
@@ -254,6 +269,35 @@ QString AttributesModel::method(int row) const
 	return QString::fromStdString(m_shvTreeNodeItem->methods()[row].metamethod.name());
 }
 
+QString AttributesModel::paramType(int row) const
+{
+	if (row < 0 || static_cast<size_t>(row) >= m_rows.size()) {
+		return QString();
+	}
+	return m_rows[static_cast<size_t>(row)].paramType;
+}
+
+QString AttributesModel::resultDiff(int row) const
+{
+	const ShvMetaMethod *mtd = metaMethodAt(static_cast<unsigned>(row));
+	if(!mtd)
+		return QString();
+	const MethodCallHistory &history = mtd->history;
+	if(history.count() < 2)
+		return tr("At least two results are needed to show a difference.");
+	const auto &prev = history.at(1);
+	const auto &curr = history.at(0);
+	auto lines = rpcValueDiff::diff(history.previousValue(), history.lastValue());
+	QStringList ret;
+	ret << tr("%1 -> %2").arg(QDateTime::fromMSecsSinceEpoch(prev.receivedMsec).toString(Qt::ISODateWithMs),
+							  QDateTime::fromMSecsSinceEpoch(curr.receivedMsec).toString(Qt::ISODateWithMs));
+	if(lines.empty())
+		ret << tr("Results are equal.");
+	for(const auto &line : lines)
+		ret << QString::fromStdString(line);
+	return ret.join('\n');
+}
+
 void AttributesModel::onMethodsLoaded()
 {
 	loadRows();
@@ -261,16 +305,24 @@ void AttributesModel::onMethodsLoaded()
 
 void AttributesModel::onRpcMethodCallFinished(int method_ix)
 {
-	loadRow(method_ix);
-	emitRowChanged(method_ix);
+	if(method_ix < 0 || method_ix >= static_cast<int>(m_rows.size()))
+		return;
+	loadRowResult(method_ix);
+	emitCellsChanged(method_ix, ColResult, ColBtRun);
 	emit methodCallResultChanged(method_ix);
 }
 
-void AttributesModel::emitRowChanged(int row_ix)
+void AttributesModel::onRpcMethodCallProgress(int method_ix)
 {
-	QModelIndex ix1 = index(row_ix, 0);
-	QModelIndex ix2 = ix1.siblingAtColumn(columnCount() - 1);
-	emit dataChanged(ix1, ix2);
+	if(method_ix < 0 || method_ix >= static_cast<int>(m_rows.size()))
+		return;
+	loadRowResult(method_ix);
+	emitCellsChanged(method_ix, ColResult, ColResult);
+}
+
+void AttributesModel::emitCellsChanged(int row_ix, int first_col, int last_col)
+{
+	emit dataChanged(index(row_ix, first_col), index(row_ix, last_col));
 }
 
 void AttributesModel::callGetters()
@@ -285,7 +337,7 @@ void AttributesModel::callGetters()
 	}
 }
 
-const ShvMetaMethod *AttributesModel::metaMethodAt(unsigned method_ix)
+const ShvMetaMethod *AttributesModel::metaMethodAt(unsigned method_ix) const
 {
 	if(method_ix >= m_rows.size() || m_shvTreeNodeItem.isNull())
 		return nullptr;
@@ -300,25 +352,69 @@ void AttributesModel::loadRow(unsigned method_ix)
 	const ShvMetaMethod * mtd = metaMethodAt(method_ix);
 	if(!mtd)
 		return;
-	RowVals &rv = m_rows[method_ix];
+	Row &row = m_rows[method_ix];
 	shvDebug() << "load row:" << mtd->metamethod.name() << "flags:" << mtd->metamethod.flags() << mtd->flagsStr();
-	rv[ColMethodName] = mtd->metamethod.name();
-	rv[ColResultType] = mtd->metamethod.resultType();
-	rv[ColParamType] = mtd->metamethod.paramType();
-	rv[ColSignals] = mtd->metamethod.methodSignals();
-	rv[ColFlags] = mtd->flagsStr();
-	rv[ColAccessLevel] = mtd->accessLevelStr();
-	rv[ColParams] = mtd->params;
-	rv[ColMetaMethod] = mtd->metamethod.toRpcValue();
+	row.methodName = QString::fromStdString(mtd->metamethod.name());
+	row.resultType = QString::fromStdString(mtd->metamethod.resultType());
+	row.paramType = QString::fromStdString(mtd->metamethod.paramType());
+	cp::RpcValue method_signals = mtd->metamethod.methodSignals();
+	row.signalsStr = method_signals.isValid()? QString::fromStdString(method_signals.toCpon()): QString();
+	row.flags = QString::fromStdString(mtd->flagsStr());
+	row.accessLevel = QString::fromStdString(mtd->accessLevelStr());
+	// run icon is shown for the same rows as when flags string was tested with RpcValue::toBool()
+	row.isCallable = !cp::RpcValue(mtd->flagsStr()).toBool();
+	loadRowParams(method_ix);
+	loadRowResult(method_ix);
+}
+
+void AttributesModel::loadRowParams(unsigned method_ix)
+{
+	const ShvMetaMethod * mtd = metaMethodAt(method_ix);
+	if(!mtd)
+		return;
+	m_rows[method_ix].params = mtd->params.isValid()? QString::fromStdString(mtd->params.toCpon()): QString();
+}
+
+void AttributesModel::loadRowResult(unsigned method_ix)
+{
+	const ShvMetaMethod * mtd = metaMethodAt(method_ix);
+	if(!mtd)
+		return;
+	Row &row = m_rows[method_ix];
 	shvDebug() << "\t response:" << mtd->response.toCpon() << "is valid:" << mtd->response.isValid();
-	if(mtd->response.isError()) {
-		rv[ColResult] = mtd->response.error().toRpcValue();
+	row.rpcRequestId = static_cast<unsigned>(mtd->rpcRequestId);
+	const MethodCallHistory &history = mtd->history;
+	if(history.callCount() > 0) {
+		row.latency = tr("%1 ms").arg(history.lastLatency());
+		row.latencyStats = tr("last: %1 ms, avg: %2 ms, p99: %3 ms, calls: %4")
+				.arg(history.lastLatency())
+				.arg(history.averageLatency())
+				.arg(history.percentileLatency(0.99))
+				.arg(history.callCount());
 	}
 	else {
-		shv::chainpack::RpcValue result = mtd->response.result();
-		rv[ColResult] = result;
+		row.latency.clear();
+		row.latencyStats.clear();
+	}
+	if(mtd->rpcRequestId > 0 && mtd->progress.has_value()) {
+		row.result = tr("Running ... %1 %").arg(static_cast<int>(mtd->progress.value() * 100));
+		return;
+	}
+	const bool is_error = mtd->response.isError();
+	if(is_error) {
+		row.result = QString::fromStdString(mtd->response.error().message());
+		return;
+	}
+	cp::RpcValue rv = mtd->response.result();
+	if(!rv.isValid()) {
+		row.result.clear();
+		return;
 	}
-	rv[ColBtRun] = mtd->rpcRequestId;
+	static constexpr size_t MAX_TT_SIZE = 1024;
+	std::string tts = rv.toCpon();
+	if(tts.size() > MAX_TT_SIZE)
+		tts = tts.substr(0, MAX_TT_SIZE) + " < ... " + std::to_string(tts.size() - MAX_TT_SIZE) + " more bytes >";
+	row.result = QString::fromStdString(tts);
 }
 
 void AttributesModel::loadRows()
@@ -326,11 +422,9 @@ void AttributesModel::loadRows()
 	m_rows.clear();
 	if(!m_shvTreeNodeItem.isNull()) {
 		const QVector<ShvMetaMethod> &mm = m_shvTreeNodeItem->methods();
-		for (int i = 0; i < mm.count(); ++i) {
-			RowVals rv;
-			rv.resize(ColCnt);
-			m_rows.push_back(rv);
-			loadRow(static_cast<unsigned>(m_rows.size() - 1));
+		m_rows.resize(static_cast<size_t>(mm.count()));
+		for (unsigned i = 0; i < m_rows.size(); ++i) {
+			loadRow(i);
 		}
 	}
 	emit layoutChanged();
@@ -17,14 +17,14 @@ class AttributesModel : public QAbstractTableModel
 private:
 	typedef QAbstractTableModel Super;
 public:
-	enum Columns {ColMethodName = 0, ColParamType, ColResultType, ColSignals, ColFlags, ColAccessLevel, ColParams, ColResult, ColBtRun, ColError, ColMetaMethod, ColCnt};
+	enum Columns {ColMethodName = 0, ColParamType, ColResultType, ColSignals, ColFlags, ColAccessLevel, ColParams, ColResult, ColLatency, ColBtRun, ColCnt};
 	enum Roles {RpcValueRole = Qt::UserRole };
 public:
 	AttributesModel(QObject *parent = nullptr);
 	~AttributesModel() override = default;
 public:
 	int rowCount(const QModelIndex &parent) const override;
-	int columnCount(const QModelIndex &parent = {}) const override { Q_UNUSED(parent); return ColBtRun + 1; }
+	int columnCount(const QModelIndex &parent = {}) const override { Q_UNUSED(parent); return ColCnt; }
 	Qt::ItemFlags flags(const QModelIndex &ix) const Q_DECL_OVERRIDE;
 	QVariant data( const QModelIndex & index, int role = Qt::DisplayRole ) const Q_DECL_OVERRIDE;
 	bool setData(const QModelIndex &ix, const QVariant &val, int role = Qt::EditRole) Q_DECL_OVERRIDE;
@@ -32,22 +32,46 @@ public:
 
 	void load(ShvNodeItem *nd);
 	void callMethod(unsigned row, bool throw_exc = false);
+	void abortMethodCall(unsigned row);
+	bool isMethodCallRunning(int row) const;
 
 	QString path() const;
+	/// Node id of broker of loaded node, empty when no node is loaded.
+	std::string brokerName() const;
 	QString method(int row) const;
+	QString paramType(int row) const;
+	QString resultDiff(int row) const;
 
 	Q_SIGNAL void reloaded();
 	Q_SIGNAL void methodCallResultChanged(int method_ix);
 private:
 	void onMethodsLoaded();
 	void onRpcMethodCallFinished(int method_ix);
-	const ShvMetaMethod *metaMethodAt(unsigned method_ix);
+	void onRpcMethodCallProgress(int method_ix);
+	const ShvMetaMethod *metaMethodAt(unsigned method_ix) const;
 	void loadRow(unsigned method_ix);
+	void loadRowParams(unsigned method_ix);
+	void loadRowResult(unsigned method_ix);
 	void loadRows();
-	void emitRowChanged(int row_ix);
+	void emitCellsChanged(int row_ix, int first_col, int last_col);
 	void callGetters();
 private:
 	QPointer<ShvNodeItem> m_shvTreeNodeItem;
-	using RowVals = shv::chainpack::RpcValue::List;
-	std::vector<RowVals> m_rows;
+	/// display strings are converted once on load, data() only hands them out
+	struct Row
+	{
+		QString methodName;
+		QString paramType;
+		QString resultType;
+		QString signalsStr;
+		QString flags;
+		QString accessLevel;
+		QString params;
+		QString result;
+		QString latency;
+		QString latencyStats;
+		unsigned rpcRequestId = 0;
+		bool isCallable = false;
+	};
+	std::vector<Row> m_rows;
 };
@@ -0,0 +1,38 @@
+#include "bandwidthlimiter.h"
+
+#include <algorithm>
+
+namespace {
+// bucket holds at most 200 ms worth of data, so the rate cannot be exceeded by long bursts
+constexpr qint64 BURST_MSEC = 200;
+}
+
+void BandwidthLimiter::setBytesPerSec(qint64 bytes_per_sec)
+{
+	m_bytesPerSec = std::max(bytes_per_sec, qint64(0));
+	m_tokens = 0;
+	m_lastRefill.start();
+}
+
+void BandwidthLimiter::refill()
+{
+	if (!m_lastRefill.isValid()) {
+		m_lastRefill.start();
+		return;
+	}
+	auto msec = m_lastRefill.restart();
+	m_tokens = std::min(m_tokens + msec * m_bytesPerSec / 1000, std::max(m_bytesPerSec * BURST_MSEC / 1000, qint64(1)));
+}
+
+qint64 BandwidthLimiter::acquire(qint64 bytes)
+{
+	if (m_bytesPerSec <= 0) {
+		return 0;
+	}
+	refill();
+	if (m_tokens < 0) {
+		return -m_tokens * 1000 / m_bytesPerSec + 1;
+	}
+	m_tokens -= bytes;
+	return 0;
+}
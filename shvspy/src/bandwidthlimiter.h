@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QElapsedTimer>
+
+/// Token bucket shared by concurrent transfers to cap their total rate.
+/// Request may overdraw the bucket, following requests wait until it is refilled.
+class BandwidthLimiter
+{
+public:
+	BandwidthLimiter() = default;
+
+	qint64 bytesPerSec() const {return m_bytesPerSec;}
+	/// 0 means unlimited
+	void setBytesPerSec(qint64 bytes_per_sec);
+
+	/// Returns 0 when bytes can be sent now, otherwise msec to wait before asking again.
+	qint64 acquire(qint64 bytes);
+private:
+	void refill();
+private:
+	qint64 m_bytesPerSec = 0;
+	qint64 m_tokens = 0;
+	QElapsedTimer m_lastRefill;
+};
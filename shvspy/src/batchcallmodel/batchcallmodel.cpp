@@ -0,0 +1,118 @@
+#include "batchcallmodel.h"
+#include "../batchcallrunner.h"
+
+#include <QColor>
+
+namespace {
+// long results are shown shortened, whole result is in tooltip and in export
+constexpr qsizetype MAX_DISPLAYED_RESULT_LENGTH = 256;
+constexpr qsizetype MAX_TOOLTIP_RESULT_LENGTH = 4096;
+
+QString shortened(const std::string &s, qsizetype max_length)
+{
+	auto ret = QString::fromStdString(s.substr(0, static_cast<size_t>(max_length)));
+	if (static_cast<qsizetype>(s.size()) > max_length) {
+		ret += QStringLiteral("...");
+	}
+	return ret;
+}
+}
+
+BatchCallModel::BatchCallModel(BatchCallRunner *runner, QObject *parent)
+	: Super(parent)
+	, m_runner(runner)
+{
+	connect(runner, &BatchCallRunner::aboutToClear, this, &BatchCallModel::beginResetModel);
+	connect(runner, &BatchCallRunner::cleared, this, [this]() {
+		m_texts.clear();
+		endResetModel();
+	});
+	connect(runner, &BatchCallRunner::callsAdded, this, [this](int first, int last) {
+		beginInsertRows(QModelIndex(), first, last);
+		m_texts.resize(static_cast<size_t>(last) + 1);
+		for (int row = first; row <= last; ++row) {
+			const auto &params = m_runner->calls()[static_cast<size_t>(row)].params;
+			m_texts[static_cast<size_t>(row)].params = params.isValid()? shortened(params.toCpon(), MAX_DISPLAYED_RESULT_LENGTH): QString();
+		}
+		endInsertRows();
+	});
+	connect(runner, &BatchCallRunner::callChanged, this, [this](int row) {
+		updateResultText(row);
+		emit dataChanged(index(row, ColStatus), index(row, ColResult));
+	});
+}
+
+void BatchCallModel::updateResultText(int row)
+{
+	const auto &call = m_runner->calls()[static_cast<size_t>(row)];
+	auto &text = m_texts[static_cast<size_t>(row)];
+	const auto s = call.status == BatchCallRunner::Status::Finished? call.result.toCpon(): call.error;
+	text.result = shortened(s, MAX_DISPLAYED_RESULT_LENGTH);
+	text.resultToolTip = shortened(s, MAX_TOOLTIP_RESULT_LENGTH);
+}
+
+int BatchCallModel::rowCount(const QModelIndex &parent) const
+{
+	return parent.isValid()? 0: static_cast<int>(m_runner->calls().size());
+}
+
+int BatchCallModel::columnCount(const QModelIndex &parent) const
+{
+	return parent.isValid()? 0: ColCount;
+}
+
+QVariant BatchCallModel::data(const QModelIndex &index, int role) const
+{
+	if (!index.isValid() || index.row() >= rowCount()) {
+		return {};
+	}
+	const auto &call = m_runner->calls()[static_cast<size_t>(index.row())];
+	const auto &text = m_texts[static_cast<size_t>(index.row())];
+	switch (role) {
+	case Qt::DisplayRole:
+		switch (index.column()) {
+		case ColPath: return QString::fromStdString(call.shvPath);
+		case ColMethod: return QString::fromStdString(call.method);
+		case ColParams: return text.params;
+		case ColStatus: return BatchCallRunner::statusToString(call.status);
+		case ColLatency: return call.latencyMsec < 0? QString(): QString::number(call.latencyMsec);
+		case ColResult: return text.result;
+		default: break;
+		}
+		break;
+	case Qt::ToolTipRole:
+		if (index.column() == ColResult) {
+			return text.resultToolTip;
+		}
+		break;
+	case Qt::TextAlignmentRole:
+		if (index.column() == ColLatency) {
+			return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+		}
+		break;
+	case Qt::ForegroundRole:
+		if (call.status == BatchCallRunner::Status::Failed) {
+			return QColor(Qt::red);
+		}
+		break;
+	default:
+		break;
+	}
+	return {};
+}
+
+QVariant BatchCallModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+		switch (section) {
+		case ColPath: return tr("Path");
+		case ColMethod: return tr("Method");
+		case ColParams: return tr("Params");
+		case ColStatus: return tr("Status");
+		case ColLatency: return tr("Latency [ms]");
+		case ColResult: return tr("Result");
+		default: break;
+		}
+	}
+	return Super::headerData(section, orientation, role);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QAbstractTableModel>
+
+#include <vector>
+
+class BatchCallRunner;
+
+/// Results of batch calls, rows are appended and updated as BatchCallRunner streams them.
+class BatchCallModel : public QAbstractTableModel
+{
+	Q_OBJECT
+
+	using Super = QAbstractTableModel;
+public:
+	enum Columns {ColPath = 0, ColMethod, ColParams, ColStatus, ColLatency, ColResult, ColCount};
+
+	explicit BatchCallModel(BatchCallRunner *runner, QObject *parent = nullptr);
+
+	int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+	int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+private:
+	/// Cpon of params and result is shortened once, when call is added or changed, not on every repaint.
+	struct RowText
+	{
+		QString params;
+		QString result;
+		QString resultToolTip;
+	};
+
+	void updateResultText(int row);
+private:
+	BatchCallRunner *m_runner;
+	std::vector<RowText> m_texts;
+};
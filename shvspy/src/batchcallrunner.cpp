@@ -0,0 +1,291 @@
+#include "batchcallrunner.h"
+
+#include <shv/chainpack/rpc.h>
+#include <shv/core/utils.h>
+#include <shv/coreqt/log.h>
+#include <shv/iotqt/rpc/clientconnection.h>
+#include <shv/iotqt/rpc/rpccall.h>
+
+#include <QRegularExpression>
+
+namespace cp = shv::chainpack;
+
+namespace {
+bool is_wildcard(const std::string &segment)
+{
+	return segment.find_first_of("*?[") != std::string::npos;
+}
+
+std::deque<std::string> split_shv_path(const std::string &path)
+{
+	std::deque<std::string> ret;
+	size_t from = 0;
+	while (from <= path.size()) {
+		auto to = path.find('/', from);
+		if (to == std::string::npos) {
+			to = path.size();
+		}
+		if (to > from) {
+			ret.push_back(path.substr(from, to - from));
+		}
+		from = to + 1;
+	}
+	return ret;
+}
+}
+
+BatchCallRunner::BatchCallRunner(shv::iotqt::rpc::ClientConnection *connection, QObject *parent)
+	: Super(parent)
+	, m_connection(connection)
+{
+	if (connection) {
+		// calls in flight are never answered when connection is deleted
+		connect(connection, &QObject::destroyed, this, &BatchCallRunner::schedule);
+	}
+}
+
+QString BatchCallRunner::statusToString(Status status)
+{
+	switch (status) {
+	case Status::Queued: return tr("Queued");
+	case Status::Running: return tr("Running");
+	case Status::Finished: return tr("Finished");
+	case Status::Failed: return tr("Failed");
+	case Status::Aborted: return tr("Aborted");
+	}
+	return {};
+}
+
+bool BatchCallRunner::start(const cp::RpcValue &script, int concurrency, std::string &error)
+{
+	// single call does not need to be wrapped in list
+	cp::RpcValue::List entries;
+	if (script.isMap() || (script.isList() && !script.asList().empty() && script.asList().front().isString())) {
+		entries.push_back(script);
+	}
+	else if (script.isList()) {
+		entries = script.asList();
+	}
+	else {
+		error = tr("Script must be list of calls.").toStdString();
+		return false;
+	}
+	struct Entry
+	{
+		std::string path;
+		std::string method;
+		cp::RpcValue params;
+	};
+	std::vector<Entry> parsed;
+	for (size_t i = 0; i < entries.size(); ++i) {
+		const auto &entry = entries[i];
+		Entry e;
+		if (entry.isList()) {
+			const auto &lst = entry.asList();
+			e.path = lst.valref(0).asString();
+			e.method = lst.valref(1).asString();
+			e.params = lst.value(2);
+		}
+		else if (entry.isMap()) {
+			const auto &map = entry.asMap();
+			e.path = map.valref("path").asString();
+			e.method = map.valref("method").asString();
+			e.params = map.value("params");
+		}
+		if (e.method.empty()) {
+			error = tr("Call #%1 has no method: %2").arg(i + 1).arg(QString::fromStdString(entry.toCpon())).toStdString();
+			return false;
+		}
+		parsed.push_back(std::move(e));
+	}
+
+	abort();
+	emit aboutToClear();
+	m_calls.clear();
+	m_queue.clear();
+	m_templates.clear();
+	m_error.clear();
+	emit cleared();
+	m_concurrency = std::max(concurrency, 1);
+	m_timer.start();
+	for (auto &e : parsed) {
+		addTemplate(Template{{}, split_shv_path(e.path), std::move(e.method), std::move(e.params)});
+	}
+	schedule();
+	return true;
+}
+
+void BatchCallRunner::abort()
+{
+	stop(Status::Aborted, {});
+}
+
+void BatchCallRunner::stop(Status status, const std::string &error)
+{
+	m_generation++;
+	m_running = 0;
+	m_runningListings = 0;
+	m_queue.clear();
+	m_templates.clear();
+	m_error = error;
+	for (size_t i = 0; i < m_calls.size(); ++i) {
+		if (auto &call = m_calls[i]; call.status == Status::Queued || call.status == Status::Running) {
+			call.status = status;
+			call.error = error;
+			emit callChanged(static_cast<int>(i));
+		}
+	}
+	checkFinished();
+}
+
+void BatchCallRunner::addCall(const std::string &shv_path, const std::string &method, const cp::RpcValue &params)
+{
+	const auto index = m_calls.size();
+	m_calls.push_back(Call{shv_path, method, params});
+	m_queue.push_back(index);
+	emit callsAdded(static_cast<int>(index), static_cast<int>(index));
+}
+
+void BatchCallRunner::addTemplate(Template &&tmpl)
+{
+	while (!tmpl.segments.empty() && !is_wildcard(tmpl.segments.front())) {
+		tmpl.prefix = shv::core::utils::joinPath(tmpl.prefix, tmpl.segments.front());
+		tmpl.segments.pop_front();
+	}
+	if (tmpl.segments.empty()) {
+		addCall(tmpl.prefix, tmpl.method, tmpl.params);
+	}
+	else {
+		m_templates.push_back(std::move(tmpl));
+	}
+}
+
+void BatchCallRunner::schedule()
+{
+	if (!m_connection) {
+		if (isRunning()) {
+			stop(Status::Failed, tr("Broker connection does not exist.").toStdString());
+		}
+		else {
+			checkFinished();
+		}
+		return;
+	}
+	// queued calls go first, so results are streamed while templates are still being expanded
+	while (m_running < m_concurrency) {
+		if (!m_queue.empty()) {
+			const auto index = m_queue.front();
+			m_queue.pop_front();
+			startCall(index);
+		}
+		else if (!m_templates.empty()) {
+			auto tmpl = std::move(m_templates.front());
+			m_templates.pop_front();
+			listTemplate(std::move(tmpl));
+		}
+		else {
+			break;
+		}
+	}
+	checkFinished();
+}
+
+void BatchCallRunner::startCall(size_t index)
+{
+	auto &call = m_calls[index];
+	call.status = Status::Running;
+	emit callChanged(static_cast<int>(index));
+	m_running++;
+	const auto start_msec = m_timer.elapsed();
+	const int generation = m_generation;
+	auto *rpc_call = shv::iotqt::rpc::RpcCall::create(m_connection)->setShvPath(call.shvPath)->setMethod(call.method)->setParams(call.params);
+	connect(rpc_call, &shv::iotqt::rpc::RpcCall::maybeResult, this, [this, index, start_msec, generation](const cp::RpcValue &result, const cp::RpcError &error) {
+		if (generation != m_generation) {
+			return;
+		}
+		m_running--;
+		auto &c = m_calls[index];
+		c.latencyMsec = m_timer.elapsed() - start_msec;
+		if (error.isValid()) {
+			c.status = Status::Failed;
+			c.error = error.toString();
+		}
+		else {
+			c.status = Status::Finished;
+			c.result = result;
+		}
+		emit callChanged(static_cast<int>(index));
+		schedule();
+	});
+	rpc_call->start();
+}
+
+void BatchCallRunner::listTemplate(Template &&tmpl)
+{
+	m_running++;
+	m_runningListings++;
+	const int generation = m_generation;
+	auto *rpc_call = shv::iotqt::rpc::RpcCall::create(m_connection)->setShvPath(tmpl.prefix)->setMethod(cp::Rpc::METH_LS);
+	connect(rpc_call, &shv::iotqt::rpc::RpcCall::maybeResult, this, [this, tmpl = std::move(tmpl), generation](const cp::RpcValue &result, const cp::RpcError &error) mutable {
+		if (generation != m_generation) {
+			return;
+		}
+		m_running--;
+		m_runningListings--;
+		if (error.isValid()) {
+			shvWarning() << "Batch call, cannot list:" << tmpl.prefix << "error:" << error.toString();
+		}
+		else {
+			const auto segment = QString::fromStdString(tmpl.segments.front());
+			tmpl.segments.pop_front();
+			const QRegularExpression rx(QRegularExpression::wildcardToRegularExpression(segment));
+			for (const auto &child : result.asList()) {
+				// ls of SHV API v2 can return [name, has_children] pairs
+				const auto &name = child.isList()? child.asList().valref(0).asString(): child.asString();
+				if (rx.match(QString::fromStdString(name)).hasMatch()) {
+					addTemplate(Template{shv::core::utils::joinPath(tmpl.prefix, name), tmpl.segments, tmpl.method, tmpl.params});
+				}
+			}
+		}
+		schedule();
+	});
+	rpc_call->start();
+}
+
+void BatchCallRunner::checkFinished()
+{
+	if (!isRunning() && m_timer.isValid()) {
+		m_timer.invalidate();
+		emit finished();
+	}
+}
+
+cp::RpcValue BatchCallRunner::toRpcValue() const
+{
+	cp::RpcValue::List ret;
+	for (const auto &call : m_calls) {
+		ret.push_back(callToRpcValue(call));
+	}
+	return ret;
+}
+
+cp::RpcValue BatchCallRunner::callToRpcValue(const Call &call)
+{
+	cp::RpcValue::Map map;
+	map["path"] = call.shvPath;
+	map["method"] = call.method;
+	if (call.params.isValid()) {
+		map["params"] = call.params;
+	}
+	map["status"] = statusToString(call.status).toStdString();
+	if (call.latencyMsec >= 0) {
+		map["latency"] = call.latencyMsec;
+	}
+	if (call.status == Status::Finished) {
+		map["result"] = call.result;
+	}
+	else if (!call.error.empty()) {
+		map["error"] = call.error;
+	}
+	return map;
+}
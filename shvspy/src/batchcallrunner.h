@@ -0,0 +1,95 @@
+#pragma once
+
+#include <shv/chainpack/rpcvalue.h>
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace shv::iotqt::rpc { class ClientConnection; }
+
+/// Runs list of method calls with limited number of requests in flight.
+/// Script is Cpon list of calls, every call is [path, method, params] or {"path", "method", "params"},
+/// params are optional. Path segments containing * or ? are expanded by ls of the parent node,
+/// so one template call can address hundreds of devices.
+class BatchCallRunner : public QObject
+{
+	Q_OBJECT
+
+	using Super = QObject;
+public:
+	static constexpr int DEFAULT_CONCURRENCY = 8;
+
+	enum class Status {Queued, Running, Finished, Failed, Aborted};
+	struct Call
+	{
+		std::string shvPath;
+		std::string method;
+		shv::chainpack::RpcValue params;
+		Status status = Status::Queued;
+		int64_t latencyMsec = -1;
+		shv::chainpack::RpcValue result;
+		std::string error;
+	};
+
+	explicit BatchCallRunner(shv::iotqt::rpc::ClientConnection *connection, QObject *parent = nullptr);
+
+	/// Aborts running batch and starts new one, returns false and sets error for invalid script.
+	bool start(const shv::chainpack::RpcValue &script, int concurrency, std::string &error);
+	void abort();
+	/// Error that stopped the batch before all calls were run, for example lost connection, empty otherwise.
+	const std::string& error() const {return m_error;}
+	bool isRunning() const {return m_running > 0 || !m_queue.empty() || !m_templates.empty();}
+
+	const std::vector<Call>& calls() const {return m_calls;}
+	/// Unresolved path templates, they are listed before calls are queued.
+	int pendingTemplateCount() const {return static_cast<int>(m_templates.size()) + m_runningListings;}
+	/// List of maps with call, status, latency and result or error, suitable for ChainPack export.
+	shv::chainpack::RpcValue toRpcValue() const;
+	/// Map with call, status, latency and result or error.
+	static shv::chainpack::RpcValue callToRpcValue(const Call &call);
+
+	static QString statusToString(Status status);
+
+	Q_SIGNAL void aboutToClear();
+	Q_SIGNAL void cleared();
+	Q_SIGNAL void callsAdded(int first, int last);
+	Q_SIGNAL void callChanged(int index);
+	Q_SIGNAL void finished();
+private:
+	struct Template
+	{
+		/// Resolved part of path.
+		std::string prefix;
+		/// Path segments still to be resolved.
+		std::deque<std::string> segments;
+		std::string method;
+		shv::chainpack::RpcValue params;
+	};
+
+	void addCall(const std::string &shv_path, const std::string &method, const shv::chainpack::RpcValue &params);
+	void addTemplate(Template &&tmpl);
+	/// Pending calls get status and error, responses of calls in flight are ignored.
+	void stop(Status status, const std::string &error);
+	void schedule();
+	void startCall(size_t index);
+	void listTemplate(Template &&tmpl);
+	void checkFinished();
+private:
+	QPointer<shv::iotqt::rpc::ClientConnection> m_connection;
+	std::vector<Call> m_calls;
+	/// Indexes of queued calls.
+	std::deque<size_t> m_queue;
+	std::deque<Template> m_templates;
+	int m_concurrency = DEFAULT_CONCURRENCY;
+	int m_running = 0;
+	int m_runningListings = 0;
+	int m_generation = 0;
+	QElapsedTimer m_timer;
+	std::string m_error;
+};
@@ -0,0 +1,193 @@
+#include "brokerconnection.h"
+#include "brokerproperty.h"
+
+#include <shv/chainpack/rpc.h>
+#include <shv/coreqt/log.h>
+#include <shv/iotqt/rpc/clientconnection.h>
+#include <shv/iotqt/rpc/deviceappclioptions.h>
+#include <shv/iotqt/rpc/deviceconnection.h>
+#include <shv/iotqt/rpc/rpccall.h>
+
+#include <QCoreApplication>
+#include <QUrl>
+#include <QUrlQuery>
+
+#include <algorithm>
+
+namespace cp = shv::chainpack;
+
+namespace brokerConnection {
+
+shv::iotqt::rpc::ClientConnection* create(const QVariantMap &props, bool is_raw_rpc_message_log)
+{
+	QString conn_type = props.value(brokerProperty::CONNECTIONTYPE).toString();
+
+	shv::iotqt::rpc::DeviceAppCliOptions opts;
+	{
+		QVariant v = props.value(brokerProperty::RPC_RECONNECTINTERVAL);
+		if(v.isValid())
+			opts.setReconnectInterval(v.toInt());
+	}
+	{
+		QVariant v = props.value(brokerProperty::RPC_HEARTBEATINTERVAL);
+		if(v.isValid())
+			opts.setHeartBeatInterval(v.toInt());
+	}
+	{
+		QVariant v = props.value(brokerProperty::RPC_RPCTIMEOUT);
+		if(v.isValid())
+			opts.setRpcTimeout(v.toInt());
+	}
+	{
+		QString dev_id = props.value(brokerProperty::DEVICE_ID).toString();
+		if(!dev_id.isEmpty())
+			opts.setDeviceId(dev_id.toStdString());
+	}
+	{
+		QString mount_point = props.value(brokerProperty::DEVICE_MOUNTPOINT).toString();
+		if(!mount_point.isEmpty())
+			opts.setMountPoint(mount_point.toStdString());
+	}
+	shv::iotqt::rpc::ClientConnection *ret;
+	if(conn_type == "device") {
+		auto *c = new shv::iotqt::rpc::DeviceConnection("shvspy " + QCoreApplication::applicationVersion().toStdString());
+		c->setCliOptions(&opts);
+		ret = c;
+	}
+	else {
+		ret = new shv::iotqt::rpc::ClientConnection("shvspy " + QCoreApplication::applicationVersion().toStdString());
+		ret->setCliOptions(&opts);
+	}
+	if(props.value(brokerProperty::MUTEHEARTBEATS).toBool()) {
+		ret->muteShvPathInLog(shv::chainpack::Rpc::DIR_BROKER_APP, shv::chainpack::Rpc::METH_PING);
+	}
+	ret->setRawRpcMessageLog(is_raw_rpc_message_log);
+	return ret;
+}
+
+shv::iotqt::rpc::Socket::Scheme configure(shv::iotqt::rpc::ClientConnection *cli, const QVariantMap &props)
+{
+	auto scheme = props.value(brokerProperty::SCHEME).toString().toStdString();
+	auto scheme_enum = shv::iotqt::rpc::Socket::schemeFromString(scheme);
+	if(scheme_enum == shv::iotqt::rpc::Socket::Scheme::Tcp && props.value(brokerProperty::SECURITYTYPE).toString() == "SSL")
+		scheme_enum = shv::iotqt::rpc::Socket::Scheme::Ssl;
+	scheme = shv::iotqt::rpc::Socket::schemeToString(scheme_enum);
+	auto host = props.value(brokerProperty::HOST).toString().toStdString();
+	auto port = props.value(brokerProperty::PORT).toInt();
+	std::string pwd = props.value(brokerProperty::PASSWORD).toString().toStdString();
+	if(scheme_enum == shv::iotqt::rpc::Socket::Scheme::LocalSocket || scheme_enum == shv::iotqt::rpc::Socket::Scheme::LocalSocketSerial || scheme_enum == shv::iotqt::rpc::Socket::Scheme::SerialPort) {
+		host = scheme + ":" + host;
+	}
+	else {
+		host = scheme + "://" + host;
+		if(port > 0) {
+			host += ':' + QString::number(port).toStdString();
+		}
+	}
+	bool skip_login = props.value(brokerProperty::SKIPLOGINPHASE).toBool();
+	if (skip_login) {
+		cli->setLoginType(shv::iotqt::rpc::ClientConnection::LoginType::None);
+	}
+	else {
+		if(scheme_enum == shv::iotqt::rpc::Socket::Scheme::Ssl) {
+			// SSL encryption is enough
+			// plain text password can be used for LDAP authentication on broker if enabled
+			cli->setLoginType(cp::IRpcConnection::LoginType::Plain);
+		}
+		else {
+			if(props.value(brokerProperty::PLAIN_TEXT_PASSWORD).toBool()) {
+				cli->setLoginType(cp::IRpcConnection::LoginType::Plain);
+			}
+			else {
+				// do not send plain text password over not encrypted socket
+				cli->setLoginType(cp::IRpcConnection::LoginType::Sha1);
+			}
+		}
+	}
+	cli->setHost(host);
+	cli->setPeerVerify(props.value(brokerProperty::PEERVERIFY).toBool());
+	cli->setUser(props.value(brokerProperty::USER).toString().toStdString());
+	cli->setPassword(pwd);
+
+	auto protocol_type = static_cast<shv::chainpack::Rpc::ProtocolType>(props.value(brokerProperty::RPC_PROTOCOLTYPE, static_cast<int>(shv::chainpack::Rpc::ProtocolType::ChainPack)).toInt());
+	cli->setProtocolType(protocol_type);
+	return scheme_enum;
+}
+
+QVariantMap propertiesFromUrl(const QUrl &url)
+{
+	QUrlQuery query(url);
+	QVariantMap conprops;
+	auto set_conprop_from_query = [&query, &conprops](const char *key) {
+		if (query.hasQueryItem(key)) {
+			conprops[key] = query.queryItemValue(key);
+		}
+	};
+	using namespace brokerProperty;
+	conprops[NAME] = query.queryItemValue(NAME);
+	conprops[SCHEME] = url.scheme();
+	auto host = url.host();
+	if (host.isEmpty()) {
+		host = url.path();
+	}
+	if (host.isEmpty()) {
+		host = "localhost";
+	}
+	conprops[HOST] = host;
+	conprops[PORT] = url.port(3755);
+	set_conprop_from_query(DEVICE_ID);
+	set_conprop_from_query(DEVICE_MOUNTPOINT);
+	set_conprop_from_query(USER);
+	conprops[PASSWORD] = query.queryItemValue(PASSWORD);
+	set_conprop_from_query(CONNECTIONTYPE);
+	set_conprop_from_query(PLAIN_TEXT_PASSWORD);
+	set_conprop_from_query(AZURELOGIN);
+	set_conprop_from_query(SECURITYTYPE);
+	set_conprop_from_query(PEERVERIFY);
+	set_conprop_from_query(RPC_RECONNECTINTERVAL);
+	set_conprop_from_query(RPC_HEARTBEATINTERVAL);
+	set_conprop_from_query(RPC_RPCTIMEOUT);
+	set_conprop_from_query(MUTEHEARTBEATS);
+	set_conprop_from_query(SHVROOT);
+	return conprops;
+}
+
+void checkShvApiVersion(shv::iotqt::rpc::ClientConnection *connection, QObject *context, std::function<void ()> on_success, std::function<void (const shv::chainpack::RpcError &)> on_error)
+{
+	auto *rpc_call = shv::iotqt::rpc::RpcCall::create(connection)->setShvPath(".broker")->setMethod("ls");
+	QObject::connect(rpc_call, &shv::iotqt::rpc::RpcCall::maybeResult, context, [connection, on_success, on_error](const ::shv::chainpack::RpcValue &result, const shv::chainpack::RpcError &error) {
+		if (error.isValid()) {
+			if (on_error) {
+				on_error(error);
+			}
+			else {
+				shvError() << "SHV API version discovery error:" << error.toString();
+			}
+		}
+		else {
+			using ShvApiVersion = shv::iotqt::rpc::ClientConnection::ShvApiVersion;
+			const auto &dirs = result.asList();
+			if (std::find(dirs.begin(), dirs.end(), "app") != dirs.end()) {
+				shvInfo() << "Setting SHV API to ver 2";
+				connection->setShvApiVersion(ShvApiVersion::V2);
+				on_success();
+			}
+			else if (std::find(dirs.begin(), dirs.end(), "client") != dirs.end()) {
+				shvInfo() << "Setting SHV API to ver 3";
+				connection->setShvApiVersion(ShvApiVersion::V3);
+				on_success();
+			}
+			else {
+				if (on_error) {
+					on_error(error);
+				}
+				else {
+					shvError() << "SHV API version cannot be discovered from ls result.";
+				}
+			}
+		}
+	});
+	rpc_call->start();
+}
+
+}
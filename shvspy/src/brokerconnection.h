@@ -0,0 +1,29 @@
+#pragma once
+
+#include <shv/iotqt/rpc/socket.h>
+
+#include <QVariantMap>
+
+#include <functional>
+
+class QObject;
+class QUrl;
+
+namespace shv::chainpack { class RpcError; }
+namespace shv::iotqt::rpc { class ClientConnection; }
+
+/// Connection setup from broker properties, shared by broker node in server tree and by headless mode.
+namespace brokerConnection {
+
+/// Creates client or device connection with reconnect, heartbeat and timeout options from properties.
+shv::iotqt::rpc::ClientConnection* create(const QVariantMap &props, bool is_raw_rpc_message_log);
+/// Sets host, login type, credentials and protocol from properties, password is expected decrypted.
+/// Returns scheme the connection will use.
+shv::iotqt::rpc::Socket::Scheme configure(shv::iotqt::rpc::ClientConnection *connection, const QVariantMap &props);
+/// Broker properties from connection url, for example tcp://localhost:3755?user=test&password=test,
+/// password is not encrypted and name is empty when url does not contain it.
+QVariantMap propertiesFromUrl(const QUrl &url);
+/// Sets SHV API version of connection according to broker directories.
+void checkShvApiVersion(shv::iotqt::rpc::ClientConnection *connection, QObject *context, std::function<void ()> on_success, std::function<void (const shv::chainpack::RpcError &e)> on_error = {});
+
+}
@@ -0,0 +1,55 @@
+#include "bytesearch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <string>
+
+namespace byteSearch {
+
+qint64 find(const char *data, qint64 size, const QByteArray &pattern, qint64 from)
+{
+	const qint64 n = pattern.size();
+	if (n == 0 || from < 0 || from + n > size) {
+		return -1;
+	}
+	const char *needle = pattern.constData();
+	const char *p = data + from;
+	const char *last = data + size - n;
+	while (p <= last) {
+		// memchr is vectorized by C library, candidates are verified by memcmp
+		p = static_cast<const char*>(std::memchr(p, needle[0], static_cast<size_t>(last - p + 1)));
+		if (!p) {
+			return -1;
+		}
+		if (std::memcmp(p, needle, static_cast<size_t>(n)) == 0) {
+			return p - data;
+		}
+		p++;
+	}
+	return -1;
+}
+
+qint64 findBackward(const char *data, qint64 size, const QByteArray &pattern, qint64 from)
+{
+	const qint64 n = pattern.size();
+	if (n == 0 || from <= 0) {
+		return -1;
+	}
+	auto end = std::min(from - 1 + n, size);
+	if (end < n) {
+		return -1;
+	}
+	// search reversed pattern in reversed data
+	const std::string reversed_pattern(pattern.crbegin(), pattern.crend());
+	std::reverse_iterator<const char*> rbegin(data + end);
+	std::reverse_iterator<const char*> rend(data);
+	auto it = std::search(rbegin, rend, std::boyer_moore_horspool_searcher(reversed_pattern.cbegin(), reversed_pattern.cend()));
+	if (it == rend) {
+		return -1;
+	}
+	return it.base() - data - n;
+}
+
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QByteArray>
+
+namespace byteSearch {
+
+/// Returns offset of the first pattern occurrence at or after from, or -1.
+qint64 find(const char *data, qint64 size, const QByteArray &pattern, qint64 from);
+/// Returns offset of the last pattern occurrence before from, or -1.
+qint64 findBackward(const char *data, qint64 size, const QByteArray &pattern, qint64 from);
+
+}
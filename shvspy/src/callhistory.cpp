@@ -0,0 +1,296 @@
+#include "callhistory.h"
+#include "rpcvaluesize.h"
+
+#include <shv/chainpack/chainpackreader.h>
+#include <shv/chainpack/rpcvalue.h>
+#include <shv/coreqt/log.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <set>
+#include <sstream>
+#include <unordered_set>
+
+namespace cp = shv::chainpack;
+
+namespace {
+// broker is the last field, records written before it was added are loaded with empty broker
+enum Field : size_t {FieldPath = 0, FieldMethod, FieldParams, FieldCallMsec, FieldLatency, FieldResultSize, FieldBroker};
+
+std::string to_chainpack(const CallHistory::Entry &entry)
+{
+	cp::RpcValue::List rec {
+		entry.shvPath,
+		entry.method,
+		entry.params,
+		entry.callMsec,
+		entry.latencyMsec,
+		entry.resultSize,
+		entry.broker,
+	};
+	return cp::RpcValue(rec).toChainPack();
+}
+
+std::string entry_text(const CallHistory::Entry &entry)
+{
+	return entry.shvPath + ' ' + entry.method + ' ' + entry.params;
+}
+
+bool is_subsequence(const QString &pattern, const QString &text)
+{
+	qsizetype pos = 0;
+	for (const QChar c : pattern) {
+		pos = text.indexOf(c, pos, Qt::CaseInsensitive);
+		if (pos < 0) {
+			return false;
+		}
+		pos++;
+	}
+	return true;
+}
+}
+
+CallHistory::CallHistory(const QString &file_name, QObject *parent)
+	: Super(parent)
+	, m_fileName(file_name)
+{
+	load();
+}
+
+void CallHistory::load()
+{
+	QFile f(m_fileName);
+	if (!f.open(QFile::ReadOnly)) {
+		return;
+	}
+	std::istringstream in(f.readAll().toStdString());
+	cp::ChainPackReader rd(in);
+	bool is_damaged = false;
+	try {
+		while (in.peek() != std::istringstream::traits_type::eof()) {
+			const cp::RpcValue rv = rd.read();
+			const auto &rec = rv.asList();
+			if (rec.size() <= FieldResultSize) {
+				is_damaged = true;
+				continue;
+			}
+			if (static_cast<int64_t>(rec[FieldParams].asString().size()) > MAX_PARAMS_SIZE) {
+				is_damaged = true;
+				continue;
+			}
+			add(Entry{rec.value(FieldBroker).asString(), rec[FieldPath].asString(), rec[FieldMethod].asString(), rec[FieldParams].asString(),
+					  rec[FieldCallMsec].toInt64(), rec[FieldLatency].toInt64(), rec[FieldResultSize].toInt64()});
+			m_fileEntryCount++;
+		}
+	}
+	catch (const std::exception &e) {
+		// last record is incomplete when application was killed while writing it
+		shvWarning() << "Call history" << m_fileName << "is damaged:" << e.what();
+		is_damaged = true;
+	}
+	if (is_damaged || m_fileEntryCount > 2 * CAPACITY) {
+		compact();
+	}
+}
+
+void CallHistory::add(Entry &&entry)
+{
+	const uint64_t id = m_firstId + m_entries.size();
+	m_index[entry.broker][entry.shvPath][entry.method].push_back(id);
+	m_entries.push_back(std::move(entry));
+	if (m_entries.size() > CAPACITY) {
+		const Entry &oldest = m_entries.front();
+		auto broker_it = m_index.find(oldest.broker);
+		auto path_it = broker_it->second.find(oldest.shvPath);
+		auto method_it = path_it->second.find(oldest.method);
+		// ids are increasing, the oldest one is always at front
+		method_it->second.pop_front();
+		if (method_it->second.empty()) {
+			path_it->second.erase(method_it);
+			if (path_it->second.empty()) {
+				broker_it->second.erase(path_it);
+				if (broker_it->second.empty()) {
+					m_index.erase(broker_it);
+				}
+			}
+		}
+		m_entries.pop_front();
+		m_firstId++;
+	}
+}
+
+std::optional<std::string> CallHistory::paramsToCpon(const cp::RpcValue &params)
+{
+	if (!params.isValid()) {
+		return std::string();
+	}
+	// bounded walk first, so huge blob is not serialized just to be thrown away
+	if (rpcValueSize::chainPackSize(params, MAX_PARAMS_SIZE) < 0) {
+		return std::nullopt;
+	}
+	auto cpon = params.toCpon();
+	if (static_cast<int64_t>(cpon.size()) > MAX_PARAMS_SIZE) {
+		return std::nullopt;
+	}
+	return cpon;
+}
+
+int64_t CallHistory::resultSize(const cp::RpcValue &result)
+{
+	return rpcValueSize::chainPackSize(result, MAX_MEASURED_RESULT_SIZE);
+}
+
+void CallHistory::record(Entry &&entry)
+{
+	if (static_cast<int64_t>(entry.params.size()) > MAX_PARAMS_SIZE) {
+		return;
+	}
+	appendToFile(entry);
+	add(std::move(entry));
+	if (m_fileEntryCount > 2 * CAPACITY) {
+		compact();
+	}
+	emit recorded();
+}
+
+void CallHistory::appendToFile(const Entry &entry)
+{
+	QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+	QFile f(m_fileName);
+	if (!f.open(QFile::Append)) {
+		shvWarning() << "Cannot write call history" << m_fileName << f.errorString();
+		return;
+	}
+	const std::string data = to_chainpack(entry);
+	f.write(data.data(), static_cast<qint64>(data.size()));
+	m_fileEntryCount++;
+}
+
+void CallHistory::compact()
+{
+	QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+	QSaveFile f(m_fileName);
+	if (!f.open(QFile::WriteOnly)) {
+		shvWarning() << "Cannot write call history" << m_fileName << f.errorString();
+		return;
+	}
+	std::string data;
+	for (const auto &entry : m_entries) {
+		data += to_chainpack(entry);
+	}
+	f.write(data.data(), static_cast<qint64>(data.size()));
+	if (f.commit()) {
+		m_fileEntryCount = m_entries.size();
+	}
+}
+
+QStringList CallHistory::paths(const std::string &broker, const std::string &prefix, int limit) const
+{
+	QStringList ret;
+	auto broker_it = m_index.find(broker);
+	if (broker_it == m_index.end()) {
+		return ret;
+	}
+	const auto &path_index = broker_it->second;
+	std::vector<std::pair<uint64_t, const std::string*>> found;
+	for (auto it = path_index.lower_bound(prefix); it != path_index.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+		uint64_t last_id = 0;
+		for (const auto &[method, ids] : it->second) {
+			last_id = std::max(last_id, ids.back());
+		}
+		found.emplace_back(last_id, &it->first);
+	}
+	std::sort(found.begin(), found.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+	for (const auto &[id, path] : found) {
+		if (ret.size() >= limit) {
+			break;
+		}
+		ret << QString::fromStdString(*path);
+	}
+	return ret;
+}
+
+QStringList CallHistory::methods(const std::string &broker, const std::string &path, int limit) const
+{
+	QStringList ret;
+	auto broker_it = m_index.find(broker);
+	if (broker_it == m_index.end()) {
+		return ret;
+	}
+	auto path_it = broker_it->second.find(path);
+	if (path_it == broker_it->second.end()) {
+		return ret;
+	}
+	std::vector<std::pair<uint64_t, const std::string*>> found;
+	for (const auto &[method, ids] : path_it->second) {
+		found.emplace_back(ids.back(), &method);
+	}
+	std::sort(found.begin(), found.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+	for (const auto &[id, method] : found) {
+		if (ret.size() >= limit) {
+			break;
+		}
+		ret << QString::fromStdString(*method);
+	}
+	return ret;
+}
+
+QStringList CallHistory::params(const std::string &broker, const std::string &path, const std::string &method, int limit) const
+{
+	QStringList ret;
+	auto broker_it = m_index.find(broker);
+	if (broker_it == m_index.end()) {
+		return ret;
+	}
+	auto path_it = broker_it->second.find(path);
+	if (path_it == broker_it->second.end()) {
+		return ret;
+	}
+	auto method_it = path_it->second.find(method);
+	if (method_it == path_it->second.end()) {
+		return ret;
+	}
+	std::set<std::string> seen;
+	const auto &ids = method_it->second;
+	for (auto it = ids.crbegin(); it != ids.crend() && ret.size() < limit; ++it) {
+		const auto &params = m_entries[static_cast<size_t>(*it - m_firstId)].params;
+		if (seen.insert(params).second) {
+			ret << QString::fromStdString(params);
+		}
+	}
+	return ret;
+}
+
+std::vector<CallHistory::Entry> CallHistory::find(const std::string &broker, const QString &pattern, size_t limit) const
+{
+	std::vector<Entry> substring_matches;
+	std::vector<Entry> fuzzy_matches;
+	std::unordered_set<std::string> seen;
+	for (auto it = m_entries.crbegin(); it != m_entries.crend() && substring_matches.size() < limit; ++it) {
+		if (it->broker != broker) {
+			continue;
+		}
+		auto key = entry_text(*it);
+		if (!seen.insert(key).second) {
+			continue;
+		}
+		const auto text = QString::fromStdString(key);
+		if (text.contains(pattern, Qt::CaseInsensitive)) {
+			substring_matches.push_back(*it);
+		}
+		else if (fuzzy_matches.size() < limit && is_subsequence(pattern, text)) {
+			fuzzy_matches.push_back(*it);
+		}
+	}
+	for (auto &entry : fuzzy_matches) {
+		if (substring_matches.size() >= limit) {
+			break;
+		}
+		substring_matches.push_back(std::move(entry));
+	}
+	return substring_matches;
+}
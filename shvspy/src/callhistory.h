@@ -0,0 +1,82 @@
+#pragma once
+
+#include <shv/chainpack/rpcvalue.h>
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+/// Persistent, bounded history of method calls shared by all dialogs.
+/// Every call is appended to ChainPack file, so nothing is lost when application crashes,
+/// the file is compacted when it holds twice the capacity. Entries are indexed by broker, path and method
+/// in ordered maps, so path prefix lookup and recall of params for a method do not scan the history
+/// and the same path on different brokers does not mix.
+class CallHistory : public QObject
+{
+	Q_OBJECT
+
+	using Super = QObject;
+public:
+	static constexpr size_t CAPACITY = 50000;
+	/// Calls with bigger params are not recorded, history is loaded to memory as a whole.
+	static constexpr int64_t MAX_PARAMS_SIZE = 4096;
+	/// Results bigger than this are recorded with size -1.
+	static constexpr int64_t MAX_MEASURED_RESULT_SIZE = 1024 * 1024;
+
+	struct Entry
+	{
+		/// Node id of broker in server tree.
+		std::string broker;
+		std::string shvPath;
+		std::string method;
+		/// Cpon, empty when called without params.
+		std::string params;
+		int64_t callMsec = 0;
+		int64_t latencyMsec = 0;
+		/// Estimated ChainPack size of result, -1 for error response or result bigger than MAX_MEASURED_RESULT_SIZE.
+		int64_t resultSize = 0;
+	};
+
+	/// Cpon of params to be stored in entry, nullopt when params are bigger than MAX_PARAMS_SIZE.
+	static std::optional<std::string> paramsToCpon(const shv::chainpack::RpcValue &params);
+	static int64_t resultSize(const shv::chainpack::RpcValue &result);
+
+	explicit CallHistory(const QString &file_name, QObject *parent = nullptr);
+
+	void record(Entry &&entry);
+	size_t count() const {return m_entries.size();}
+
+	/// Distinct paths on broker starting with prefix, most recently used first.
+	QStringList paths(const std::string &broker, const std::string &prefix = {}, int limit = 100) const;
+	/// Methods called on path, most recently used first.
+	QStringList methods(const std::string &broker, const std::string &path, int limit = 100) const;
+	/// Distinct params the method was called with, most recently used first.
+	QStringList params(const std::string &broker, const std::string &path, const std::string &method, int limit = 100) const;
+	/// Distinct calls on broker matching pattern, most recent first. Calls containing pattern as substring
+	/// of "path method params" go before calls containing its characters in the same order.
+	std::vector<Entry> find(const std::string &broker, const QString &pattern, size_t limit = 200) const;
+
+	Q_SIGNAL void recorded();
+private:
+	void load();
+	void add(Entry &&entry);
+	void appendToFile(const Entry &entry);
+	void compact();
+private:
+	QString m_fileName;
+	/// Oldest first, id of front entry is m_firstId.
+	std::deque<Entry> m_entries;
+	uint64_t m_firstId = 0;
+	using MethodIndex = std::map<std::string, std::deque<uint64_t>>;
+	using PathIndex = std::map<std::string, MethodIndex>;
+	/// broker -> path -> method -> ids of calls, oldest first
+	std::map<std::string, PathIndex> m_index;
+	size_t m_fileEntryCount = 0;
+};
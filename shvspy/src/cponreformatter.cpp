@@ -0,0 +1,367 @@
+#include "cponreformatter.h"
+
+namespace {
+bool is_atom_char(char c)
+{
+	return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '.' || c == '+' || c == '-';
+}
+
+bool is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool is_letter(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+}
+
+CponReformatter::CponReformatter(bool is_pretty, std::string indent)
+	: m_isPretty(is_pretty)
+	, m_indent(std::move(indent))
+{
+}
+
+bool CponReformatter::error(const std::string &message)
+{
+	m_errorString = message + " at offset " + std::to_string(m_offset);
+	return false;
+}
+
+bool CponReformatter::acceptValue()
+{
+	switch (m_expect) {
+	case Expect::Value:
+	case Expect::MetaValue:
+	case Expect::Item:
+		return true;
+	case Expect::Key:
+		return error(m_containers.back().type == 'i'? "Integer key expected": "String key expected");
+	case Expect::Separator:
+		return error("',' expected");
+	case Expect::Colon:
+		return error("':' expected");
+	case Expect::End:
+		return error("Unexpected data after value");
+	}
+	return false;
+}
+
+void CponReformatter::valueDone()
+{
+	m_expect = m_containers.empty()? Expect::End: Expect::Separator;
+}
+
+void CponReformatter::newLine(std::string &out, size_t depth) const
+{
+	out += '\n';
+	for (size_t i = 0; i < depth; ++i) {
+		out += m_indent;
+	}
+}
+
+void CponReformatter::beginItem(std::string &out)
+{
+	// value after key or meta data belongs to already started item
+	if (m_isItemStarted) {
+		return;
+	}
+	m_isItemStarted = true;
+	if (m_containers.empty()) {
+		return;
+	}
+	if (m_containers.back().itemCount++ > 0) {
+		out += ',';
+	}
+	// meta data is kept on one line
+	if (m_isPretty && m_metaDepth == 0) {
+		newLine(out, m_depth);
+	}
+}
+
+void CponReformatter::endValue()
+{
+	if (!m_containers.empty() && m_containers.back().isKeyExpected) {
+		// key is written, value follows after colon
+		m_containers.back().isKeyExpected = false;
+		return;
+	}
+	m_isItemStarted = false;
+	if (!m_containers.empty() && m_containers.back().type != '[') {
+		m_containers.back().isKeyExpected = true;
+	}
+}
+
+bool CponReformatter::openContainer(char type, std::string &out)
+{
+	if (type == '<' && m_expect == Expect::MetaValue) {
+		return error("Value expected after meta data");
+	}
+	if (!acceptValue()) {
+		return false;
+	}
+	m_expect = type == '['? Expect::Item: Expect::Key;
+	beginItem(out);
+	if (type == 'i') {
+		out += "i{";
+	}
+	else {
+		out += type;
+	}
+	m_containers.push_back(Container{type, type != '['});
+	if (type == '<') {
+		m_metaDepth++;
+	}
+	else {
+		m_depth++;
+	}
+	m_isItemStarted = false;
+	return true;
+}
+
+bool CponReformatter::closeContainer(char c, std::string &out)
+{
+	const char open = c == ']'? '[': c == '>'? '<': '{';
+	if (m_containers.empty() || !(m_containers.back().type == open || (open == '{' && m_containers.back().type == 'i'))
+			|| !(m_expect == Expect::Item || m_expect == Expect::Key || m_expect == Expect::Separator)) {
+		return error(std::string("Unexpected '") + c + '\'');
+	}
+	if (open == '<') {
+		m_metaDepth--;
+	}
+	else {
+		m_depth--;
+	}
+	if (m_isPretty && m_metaDepth == 0 && open != '<' && m_containers.back().itemCount > 0) {
+		newLine(out, m_depth);
+	}
+	out += c;
+	m_containers.pop_back();
+	if (open == '<') {
+		// meta data is followed by value of the same item
+		m_isItemStarted = true;
+		m_expect = Expect::MetaValue;
+	}
+	else {
+		endValue();
+		valueDone();
+	}
+	return true;
+}
+
+bool CponReformatter::flushAtom(char next, std::string &out)
+{
+	m_lex = Lex::Default;
+	const bool is_identifier = is_letter(m_atom.front());
+	if (next == '{' && m_atom == "i") {
+		// prefix is written by openContainer
+		m_isIMapPrefix = true;
+	}
+	else if (next == '"' && (m_atom == "b" || m_atom == "x" || m_atom == "d")) {
+		// string prefix, value ends with the string
+		if (!acceptValue()) {
+			return false;
+		}
+		m_isStringKey = false;
+		beginItem(out);
+		out += m_atom;
+	}
+	else {
+		if (is_identifier && m_atom != "null" && m_atom != "true" && m_atom != "false") {
+			return error("Unknown literal '" + m_atom + '\'');
+		}
+		if (m_expect == Expect::Key) {
+			if (is_identifier || m_containers.back().type == '{') {
+				return error(m_containers.back().type == 'i'? "Integer key expected": "String key expected");
+			}
+			m_expect = Expect::Colon;
+		}
+		else if (!acceptValue()) {
+			return false;
+		}
+		else {
+			valueDone();
+		}
+		beginItem(out);
+		out += m_atom;
+		endValue();
+	}
+	m_atom.clear();
+	return true;
+}
+
+bool CponReformatter::processChar(char c, std::string &out)
+{
+	switch (m_lex) {
+	case Lex::String:
+		out += c;
+		if (c == '\\') {
+			m_lex = Lex::StringEscape;
+		}
+		else if (c == '"') {
+			m_lex = Lex::Default;
+			if (m_isStringKey) {
+				m_expect = Expect::Colon;
+			}
+			else {
+				valueDone();
+			}
+			endValue();
+		}
+		return true;
+	case Lex::StringEscape:
+		out += c;
+		m_lex = Lex::String;
+		return true;
+	case Lex::Atom:
+		if (is_atom_char(c)) {
+			m_atom += c;
+			return true;
+		}
+		if (!flushAtom(c, out)) {
+			return false;
+		}
+		break;
+	case Lex::Slash:
+		if (c == '*') {
+			m_lex = Lex::BlockComment;
+			return true;
+		}
+		if (c == '/') {
+			m_lex = Lex::LineComment;
+			return true;
+		}
+		return error("Unexpected '/'");
+	case Lex::BlockComment:
+		if (c == '*') {
+			m_lex = Lex::BlockCommentStar;
+		}
+		return true;
+	case Lex::BlockCommentStar:
+		if (c == '/') {
+			m_lex = Lex::Default;
+		}
+		else if (c != '*') {
+			m_lex = Lex::BlockComment;
+		}
+		return true;
+	case Lex::LineComment:
+		if (c == '\n') {
+			m_lex = Lex::Default;
+		}
+		return true;
+	case Lex::Default:
+		break;
+	}
+	if (is_space(c)) {
+		return true;
+	}
+	if (m_isIMapPrefix && c != '{') {
+		return error("'{' expected after 'i'");
+	}
+	switch (c) {
+	case ',':
+		// commas are written by beginItem
+		if (m_expect != Expect::Separator) {
+			return error("Unexpected ','");
+		}
+		m_expect = m_containers.back().type == '['? Expect::Item: Expect::Key;
+		return true;
+	case ':':
+		if (m_expect != Expect::Colon) {
+			return error("Unexpected ':'");
+		}
+		m_expect = Expect::Value;
+		out += ':';
+		return true;
+	case '/':
+		m_lex = Lex::Slash;
+		return true;
+	case '"':
+		if (m_expect == Expect::Key) {
+			if (m_containers.back().type == 'i') {
+				return error("Integer key expected");
+			}
+			m_isStringKey = true;
+		}
+		else if (!acceptValue()) {
+			return false;
+		}
+		else {
+			m_isStringKey = false;
+		}
+		beginItem(out);
+		out += '"';
+		m_lex = Lex::String;
+		return true;
+	case '{': {
+		const bool ok = openContainer(m_isIMapPrefix? 'i': '{', out);
+		m_isIMapPrefix = false;
+		return ok;
+	}
+	case '[':
+	case '<':
+		return openContainer(c, out);
+	case ']':
+	case '}':
+	case '>':
+		return closeContainer(c, out);
+	default:
+		break;
+	}
+	if (is_atom_char(c)) {
+		m_lex = Lex::Atom;
+		m_atom = c;
+		return true;
+	}
+	return error(std::string("Unexpected character '") + c + '\'');
+}
+
+bool CponReformatter::feed(const char *data, size_t size, std::string &out)
+{
+	if (!m_errorString.empty()) {
+		return false;
+	}
+	for (size_t i = 0; i < size; ++i) {
+		if (m_lex == Lex::String) {
+			// string content is copied at once up to next quote or escape
+			size_t j = i;
+			while (j < size && data[j] != '"' && data[j] != '\\') {
+				++j;
+			}
+			out.append(data + i, j - i);
+			if (j == size) {
+				break;
+			}
+			i = j;
+		}
+		m_offset = m_consumed + i;
+		if (!processChar(data[i], out)) {
+			return false;
+		}
+	}
+	m_consumed += size;
+	m_offset = m_consumed;
+	return true;
+}
+
+bool CponReformatter::finish(std::string &out)
+{
+	if (!m_errorString.empty()) {
+		return false;
+	}
+	if (m_lex == Lex::Atom && !flushAtom(0, out)) {
+		return false;
+	}
+	if (m_lex != Lex::Default && m_lex != Lex::LineComment) {
+		return error("Unexpected end of document");
+	}
+	if (!m_containers.empty() || m_isIMapPrefix) {
+		return error("Unexpected end of document, unclosed container");
+	}
+	if (m_expect != Expect::End && m_expect != Expect::Value) {
+		return error("Unexpected end of document, value expected");
+	}
+	return true;
+}
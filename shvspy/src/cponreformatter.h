@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Reformats Cpon text without building RpcValue tree. Input is fed in chunks of UTF-8 text
+/// and formatted output is appended for every chunk, reformatter state grows only with nesting depth.
+/// Grammar is checked as strictly as in CponTokenizer, so malformed input is refused, not repaired.
+/// Comments are dropped, strings and scalars are copied verbatim.
+class CponReformatter
+{
+public:
+	explicit CponReformatter(bool is_pretty, std::string indent = "  ");
+
+	bool feed(const char *data, size_t size, std::string &out);
+	/// Flushes last token and checks that all containers are closed.
+	bool finish(std::string &out);
+	const std::string& errorString() const {return m_errorString;}
+private:
+	enum class Lex : uint8_t {Default, String, StringEscape, Atom, Slash, BlockComment, BlockCommentStar, LineComment};
+	/// Next expected token, Separator is ',' or end of container after an item.
+	enum class Expect : uint8_t {Value, MetaValue, Item, Separator, Key, Colon, End};
+	struct Container
+	{
+		/// One of [ { i <
+		char type;
+		bool isKeyExpected;
+		size_t itemCount = 0;
+	};
+	bool processChar(char c, std::string &out);
+	bool acceptValue();
+	void valueDone();
+	void beginItem(std::string &out);
+	void endValue();
+	bool openContainer(char type, std::string &out);
+	bool closeContainer(char c, std::string &out);
+	bool flushAtom(char next, std::string &out);
+	void newLine(std::string &out, size_t depth) const;
+	bool error(const std::string &message);
+private:
+	bool m_isPretty;
+	std::string m_indent;
+	Lex m_lex = Lex::Default;
+	Expect m_expect = Expect::Value;
+	bool m_isStringKey = false;
+	std::string m_atom;
+	bool m_isIMapPrefix = false;
+	std::vector<Container> m_containers;
+	bool m_isItemStarted = false;
+	size_t m_depth = 0;
+	size_t m_metaDepth = 0;
+	/// Offset of processed character in input, used in error messages.
+	uint64_t m_offset = 0;
+	uint64_t m_consumed = 0;
+	std::string m_errorString;
+};
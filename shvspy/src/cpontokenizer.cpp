@@ -0,0 +1,301 @@
+#include "cpontokenizer.h"
+
+namespace {
+using State = CponTokenizer::State;
+using Expect = State::Expect;
+
+bool is_number_char(QChar c)
+{
+	return c.isDigit() || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F')
+		|| c == 'x' || c == 'X' || c == 'u' || c == '.' || c == '+' || c == '-';
+}
+
+class LineParser
+{
+public:
+	LineParser(QStringView line, State &state) : m_line(line), m_state(state) {}
+
+	CponTokenizer::Error parse();
+private:
+	bool error(int column, const QString &message);
+	void valueDone();
+	bool acceptValue(int column);
+	bool openContainer(char type, int column);
+	bool closeContainer(char type, int column);
+	bool startString(char type, int column);
+	bool scanString();
+	bool scanBlockComment();
+	bool scanIdentifier();
+	bool scanNumber();
+private:
+	QStringView m_line;
+	State &m_state;
+	qsizetype m_pos = 0;
+	CponTokenizer::Error m_error;
+};
+
+bool LineParser::error(int column, const QString &message)
+{
+	m_state.hasError = true;
+	m_error.column = column;
+	m_error.message = message;
+	return false;
+}
+
+void LineParser::valueDone()
+{
+	m_state.expect = m_state.containers.empty()? Expect::End: Expect::Separator;
+}
+
+bool LineParser::acceptValue(int column)
+{
+	switch (m_state.expect) {
+	case Expect::Value:
+	case Expect::MetaValue:
+	case Expect::Item:
+		return true;
+	case Expect::Key:
+		return error(column, m_state.containers.back() == 'i'? QStringLiteral("Integer key expected"): QStringLiteral("String key expected"));
+	case Expect::Separator:
+		return error(column, QStringLiteral("',' expected"));
+	case Expect::Colon:
+		return error(column, QStringLiteral("':' expected"));
+	case Expect::End:
+		return error(column, QStringLiteral("Unexpected data after value"));
+	}
+	return false;
+}
+
+bool LineParser::openContainer(char type, int column)
+{
+	if (type == '<' && m_state.expect == Expect::MetaValue) {
+		return error(column, QStringLiteral("Value expected after meta data"));
+	}
+	if (!acceptValue(column)) {
+		return false;
+	}
+	m_state.containers.push_back(type);
+	m_state.expect = type == '['? Expect::Item: Expect::Key;
+	return true;
+}
+
+bool LineParser::closeContainer(char type, int column)
+{
+	const char open = type == ']'? '[': type == '>'? '<': '{';
+	const bool is_close_allowed = !m_state.containers.empty()
+			&& (m_state.containers.back() == open || (open == '{' && m_state.containers.back() == 'i'))
+			&& (m_state.expect == Expect::Item || m_state.expect == Expect::Key || m_state.expect == Expect::Separator);
+	if (!is_close_allowed) {
+		return error(column, QStringLiteral("Unexpected '%1'").arg(QLatin1Char(type)));
+	}
+	m_state.containers.pop_back();
+	if (open == '<') {
+		m_state.expect = Expect::MetaValue;
+	}
+	else {
+		valueDone();
+	}
+	return true;
+}
+
+bool LineParser::startString(char type, int column)
+{
+	if (m_state.expect == Expect::Key) {
+		if (type != '"' || m_state.containers.back() == 'i') {
+			return error(column, QStringLiteral("Invalid key type"));
+		}
+		m_state.isStringKey = true;
+	}
+	else if (!acceptValue(column)) {
+		return false;
+	}
+	else {
+		m_state.isStringKey = false;
+	}
+	m_state.stringType = type;
+	m_state.isStringEscape = false;
+	return true;
+}
+
+bool LineParser::scanString()
+{
+	for (; m_pos < m_line.size(); ++m_pos) {
+		const QChar c = m_line[m_pos];
+		if (m_state.isStringEscape) {
+			m_state.isStringEscape = false;
+		}
+		else if (c == '\\') {
+			m_state.isStringEscape = true;
+		}
+		else if (c == '"') {
+			m_pos++;
+			m_state.stringType = 0;
+			if (m_state.isStringKey) {
+				m_state.expect = Expect::Colon;
+			}
+			else {
+				valueDone();
+			}
+			return true;
+		}
+	}
+	// string continues on next line
+	return true;
+}
+
+bool LineParser::scanBlockComment()
+{
+	for (; m_pos + 1 < m_line.size(); ++m_pos) {
+		if (m_line[m_pos] == '*' && m_line[m_pos + 1] == '/') {
+			m_pos += 2;
+			m_state.isBlockComment = false;
+			return true;
+		}
+	}
+	m_pos = m_line.size();
+	return true;
+}
+
+bool LineParser::scanIdentifier()
+{
+	const auto start = m_pos;
+	while (m_pos < m_line.size() && m_line[m_pos].isLetter()) {
+		m_pos++;
+	}
+	const auto ident = m_line.mid(start, m_pos - start);
+	const auto column = static_cast<int>(start);
+	const bool is_quote_next = m_pos < m_line.size() && m_line[m_pos] == '"';
+	if (is_quote_next && ident.size() == 1 && (ident[0] == 'b' || ident[0] == 'x' || ident[0] == 'd')) {
+		m_pos++;
+		return startString(ident[0].toLatin1(), column);
+	}
+	if (ident == QLatin1String("i") && m_pos < m_line.size() && m_line[m_pos] == '{') {
+		m_pos++;
+		return openContainer('i', column);
+	}
+	if (ident == QLatin1String("null") || ident == QLatin1String("true") || ident == QLatin1String("false")) {
+		if (!acceptValue(column)) {
+			return false;
+		}
+		valueDone();
+		return true;
+	}
+	return error(column, QStringLiteral("Unknown literal '%1'").arg(ident.toString()));
+}
+
+bool LineParser::scanNumber()
+{
+	const auto start = m_pos;
+	bool has_digit = false;
+	while (m_pos < m_line.size() && is_number_char(m_line[m_pos])) {
+		has_digit = has_digit || m_line[m_pos].isDigit();
+		m_pos++;
+	}
+	const auto column = static_cast<int>(start);
+	if (!has_digit) {
+		return error(column, QStringLiteral("Malformed number"));
+	}
+	if (m_state.expect == Expect::Key) {
+		if (m_state.containers.back() == '{') {
+			return error(column, QStringLiteral("String key expected"));
+		}
+		m_state.expect = Expect::Colon;
+		return true;
+	}
+	if (!acceptValue(column)) {
+		return false;
+	}
+	valueDone();
+	return true;
+}
+
+CponTokenizer::Error LineParser::parse()
+{
+	bool ok = true;
+	while (ok && m_pos < m_line.size()) {
+		if (m_state.stringType) {
+			ok = scanString();
+			continue;
+		}
+		if (m_state.isBlockComment) {
+			ok = scanBlockComment();
+			continue;
+		}
+		const QChar c = m_line[m_pos];
+		const auto column = static_cast<int>(m_pos);
+		if (c.isSpace()) {
+			m_pos++;
+		}
+		else if (c == ',') {
+			if (m_state.expect != Expect::Separator) {
+				ok = error(column, QStringLiteral("Unexpected ','"));
+			}
+			m_state.expect = m_state.containers.empty() || m_state.containers.back() == '['? Expect::Item: Expect::Key;
+			m_pos++;
+		}
+		else if (c == ':') {
+			if (m_state.expect != Expect::Colon) {
+				ok = error(column, QStringLiteral("Unexpected ':'"));
+			}
+			m_state.expect = Expect::Value;
+			m_pos++;
+		}
+		else if (c == '/' && m_pos + 1 < m_line.size() && m_line[m_pos + 1] == '*') {
+			m_state.isBlockComment = true;
+			m_pos += 2;
+		}
+		else if (c == '/' && m_pos + 1 < m_line.size() && m_line[m_pos + 1] == '/') {
+			m_pos = m_line.size();
+		}
+		else if (c == '[' || c == '{' || c == '<') {
+			m_pos++;
+			ok = openContainer(c.toLatin1(), column);
+		}
+		else if (c == ']' || c == '}' || c == '>') {
+			m_pos++;
+			ok = closeContainer(c.toLatin1(), column);
+		}
+		else if (c == '"') {
+			m_pos++;
+			ok = startString('"', column);
+		}
+		else if (c.isLetter()) {
+			ok = scanIdentifier();
+		}
+		else if (c.isDigit() || c == '-' || c == '+' || c == '.') {
+			ok = scanNumber();
+		}
+		else {
+			ok = error(column, QStringLiteral("Unexpected character '%1'").arg(c));
+		}
+	}
+	return m_error;
+}
+}
+
+bool CponTokenizer::State::operator==(const State &o) const
+{
+	return containers == o.containers
+			&& expect == o.expect
+			&& stringType == o.stringType
+			&& isStringKey == o.isStringKey
+			&& isStringEscape == o.isStringEscape
+			&& isBlockComment == o.isBlockComment
+			&& hasError == o.hasError;
+}
+
+CponTokenizer::Error CponTokenizer::tokenizeLine(QStringView line, State &state)
+{
+	if (state.hasError) {
+		return {};
+	}
+	return LineParser(line, state).parse();
+}
+
+bool CponTokenizer::isComplete(const State &state)
+{
+	if (state.hasError || state.stringType || state.isBlockComment || !state.containers.empty()) {
+		return false;
+	}
+	return state.expect == State::Expect::End || state.expect == State::Expect::Value;
+}
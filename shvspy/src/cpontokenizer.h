@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QString>
+#include <QStringView>
+
+#include <vector>
+
+/// Resumable Cpon syntax checker. Text is fed line by line and the whole parser state
+/// is kept in State, so parsing can continue from any line whose start state is known.
+class CponTokenizer
+{
+public:
+	struct State
+	{
+		/// Separator is ',' or end of container after an item.
+		enum class Expect : quint8 {Value, MetaValue, Item, Separator, Key, Colon, End};
+
+		/// Open containers, one of [ { i <
+		std::vector<char> containers;
+		Expect expect = Expect::Value;
+		/// Type of string continuing on next line, one of " b x d, 0 when none.
+		char stringType = 0;
+		bool isStringKey = false;
+		bool isStringEscape = false;
+		bool isBlockComment = false;
+		/// Error was found on this or some previous line.
+		bool hasError = false;
+
+		bool operator==(const State &o) const;
+		bool operator!=(const State &o) const {return !(*this == o);}
+	};
+	struct Error
+	{
+		int column = -1;
+		QString message;
+	};
+
+	/// Advances state over one line, returns first error found on it.
+	static Error tokenizeLine(QStringView line, State &state);
+	/// True when state after last line is a complete document or the document is empty.
+	static bool isComplete(const State &state);
+};
@@ -0,0 +1,134 @@
+#include "cponvalidator.h"
+#include "cpontokenizer.h"
+
+#include <QElapsedTimer>
+#include <QTextBlock>
+#include <QTextDocument>
+#include <QTimer>
+
+#include <algorithm>
+
+namespace {
+// parsing is interrupted after this time to let GUI paint
+constexpr qint64 TIME_SLICE_MSEC = 8;
+
+class CponBlockData : public QTextBlockUserData
+{
+public:
+	CponTokenizer::State endState;
+	CponTokenizer::Error error;
+};
+
+CponBlockData* block_data(const QTextBlock &block)
+{
+	return static_cast<CponBlockData*>(block.userData());
+}
+}
+
+CponValidator::CponValidator(QTextDocument *document, QObject *parent)
+	: Super(parent)
+	, m_document(document)
+	, m_processTimer(new QTimer(this))
+{
+	m_processTimer->setSingleShot(true);
+	m_processTimer->setInterval(0);
+	connect(m_processTimer, &QTimer::timeout, this, &CponValidator::processDirtyBlocks);
+	connect(m_document, &QTextDocument::contentsChange, this, &CponValidator::onContentsChange);
+
+	m_blockCount = m_document->blockCount();
+	m_dirtyBlock = 0;
+	m_dirtyEndBlock = m_blockCount - 1;
+	m_processTimer->start();
+}
+
+void CponValidator::onContentsChange(int position, int chars_removed, int chars_added)
+{
+	Q_UNUSED(chars_removed)
+	const int first = m_document->findBlock(position).blockNumber();
+	const int last = m_document->findBlock(position + chars_added).blockNumber();
+	const int delta = m_document->blockCount() - m_blockCount;
+	m_blockCount = m_document->blockCount();
+	if (m_dirtyBlock < 0) {
+		m_dirtyBlock = first;
+		m_dirtyEndBlock = last;
+	}
+	else {
+		// pending range is shifted by lines inserted or removed before its end
+		if (m_dirtyEndBlock >= first) {
+			m_dirtyEndBlock = std::max(m_dirtyEndBlock + delta, first);
+		}
+		m_dirtyBlock = std::min(m_dirtyBlock, first);
+		m_dirtyEndBlock = std::max(m_dirtyEndBlock, last);
+	}
+	m_processTimer->start();
+}
+
+void CponValidator::processDirtyBlocks()
+{
+	if (m_dirtyBlock < 0) {
+		return;
+	}
+	QElapsedTimer elapsed;
+	elapsed.start();
+	QTextBlock block = m_document->findBlockByNumber(m_dirtyBlock);
+	CponTokenizer::State state;
+	if (auto *prev_data = block_data(block.previous())) {
+		state = prev_data->endState;
+	}
+	while (block.isValid()) {
+		auto *data = block_data(block);
+		const bool had_data = data != nullptr;
+		if (!data) {
+			data = new CponBlockData();
+			block.setUserData(data);
+		}
+		data->error = CponTokenizer::tokenizeLine(block.text(), state);
+		const bool is_unchanged = had_data && data->endState == state;
+		data->endState = state;
+		if (is_unchanged && block.blockNumber() >= m_dirtyEndBlock) {
+			// following blocks were parsed from the same state already
+			break;
+		}
+		block = block.next();
+		if (block.isValid() && elapsed.elapsed() > TIME_SLICE_MSEC) {
+			m_dirtyBlock = block.blockNumber();
+			m_processTimer->start();
+			return;
+		}
+	}
+	m_dirtyBlock = -1;
+	m_dirtyEndBlock = -1;
+	reportResult();
+}
+
+void CponValidator::reportResult()
+{
+	const QTextBlock last_block = m_document->lastBlock();
+	const auto *last_data = block_data(last_block);
+	if (!last_data) {
+		return;
+	}
+	if (last_data->endState.hasError) {
+		// error flag is kept in all states after the first error, find its block by bisection
+		int lo = 0;
+		int hi = last_block.blockNumber();
+		while (lo < hi) {
+			const int mid = (lo + hi) / 2;
+			const auto *data = block_data(m_document->findBlockByNumber(mid));
+			if (data && data->endState.hasError) {
+				hi = mid;
+			}
+			else {
+				lo = mid + 1;
+			}
+		}
+		const auto *data = block_data(m_document->findBlockByNumber(lo));
+		emit validated(data->error.message, lo, data->error.column);
+	}
+	else if (!CponTokenizer::isComplete(last_data->endState)) {
+		emit validated(tr("Unexpected end of document"), last_block.blockNumber(), last_block.length() - 1);
+	}
+	else {
+		emit validated({}, -1, -1);
+	}
+}
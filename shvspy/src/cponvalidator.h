@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QObject>
+
+class QTextDocument;
+class QTimer;
+
+/// Validates Cpon in text document incrementally. Tokenizer state is stored at the end
+/// of every text block, so after an edit parsing restarts at the edited block and stops
+/// as soon as the state after a block matches the stored one.
+/// Large documents are processed in short time slices to keep the GUI responsive.
+class CponValidator : public QObject
+{
+	Q_OBJECT
+
+	using Super = QObject;
+public:
+	explicit CponValidator(QTextDocument *document, QObject *parent = nullptr);
+
+	/// Error is empty when document is valid, line and column are zero based.
+	Q_SIGNAL void validated(const QString &error, int line, int column);
+private:
+	void onContentsChange(int position, int chars_removed, int chars_added);
+	void processDirtyBlocks();
+	void reportResult();
+private:
+	QTextDocument *m_document;
+	QTimer *m_processTimer;
+	int m_blockCount = 0;
+	/// Range of blocks which must be parsed again, -1 when document is up to date.
+	int m_dirtyBlock = -1;
+	int m_dirtyEndBlock = -1;
+};
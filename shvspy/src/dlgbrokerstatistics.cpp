@@ -0,0 +1,124 @@
+#include "dlgbrokerstatistics.h"
+#include "ui_dlgbrokerstatistics.h"
+
+#include "servertreemodel/shvbrokernodeitem.h"
+
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QSettings>
+#include <QTimer>
+
+#include <fstream>
+
+namespace {
+enum Columns {ColMethod = 0, ColCount, ColErrors, ColTimeouts, ColMin, ColAvg, ColP50, ColP90, ColP99, ColMax, ColCnt};
+}
+
+DlgBrokerStatistics::DlgBrokerStatistics(ShvBrokerNodeItem *broker, QWidget *parent)
+	: Super(parent)
+	, ui(new Ui::DlgBrokerStatistics)
+	, m_broker(broker)
+	, m_refreshTimer(new QTimer(this))
+{
+	ui->setupUi(this);
+	setWindowTitle(tr("RPC statistics - %1").arg(QString::fromStdString(broker->nodeId())));
+
+	ui->tblMethods->setColumnCount(ColCnt);
+	ui->tblMethods->setHorizontalHeaderLabels({
+		tr("Method"), tr("Count"), tr("Errors"), tr("Timeouts"),
+		tr("Min [ms]"), tr("Avg [ms]"), tr("p50 [ms]"), tr("p90 [ms]"), tr("p99 [ms]"), tr("Max [ms]"),
+	});
+
+	ui->chkMeasurePayloadSize->setChecked(broker->rpcStatistics().isMeasurePayloadSize());
+	connect(ui->chkMeasurePayloadSize, &QCheckBox::toggled, this, [this](bool checked) {
+		if(m_broker)
+			m_broker->rpcStatistics().setMeasurePayloadSize(checked);
+		refresh();
+	});
+	connect(ui->btReset, &QPushButton::clicked, this, [this]() {
+		if(m_broker)
+			m_broker->rpcStatistics().reset();
+		refresh();
+	});
+	connect(ui->btSaveCpon, &QPushButton::clicked, this, &DlgBrokerStatistics::saveCpon);
+
+	connect(m_refreshTimer, &QTimer::timeout, this, &DlgBrokerStatistics::refresh);
+	m_refreshTimer->start(1000);
+
+	QSettings settings;
+	restoreGeometry(settings.value(QStringLiteral("ui/DlgBrokerStatistics/geometry")).toByteArray());
+
+	refresh();
+	ui->tblMethods->resizeColumnsToContents();
+}
+
+DlgBrokerStatistics::~DlgBrokerStatistics()
+{
+	QSettings settings;
+	settings.setValue(QStringLiteral("ui/DlgBrokerStatistics/geometry"), saveGeometry());
+	delete ui;
+}
+
+void DlgBrokerStatistics::refresh()
+{
+	if(!m_broker) {
+		ui->lblSummary->setText(tr("Connection was removed."));
+		m_refreshTimer->stop();
+		return;
+	}
+	const RpcStatistics &stats = m_broker->rpcStatistics();
+	QString summary = tr("In flight: %1, requests: %2, responses: %3, errors: %4, timeouts: %5")
+			.arg(m_broker->runningRpcRequestCount())
+			.arg(stats.requestCount())
+			.arg(stats.responseCount())
+			.arg(stats.errorCount())
+			.arg(stats.timeoutCount());
+	if(stats.isMeasurePayloadSize()) {
+		summary += tr(", bytes out: %1, bytes in: %2").arg(stats.bytesSent()).arg(stats.bytesReceived());
+	}
+	ui->lblSummary->setText(summary);
+
+	QTableWidget *tbl = ui->tblMethods;
+	tbl->setSortingEnabled(false);
+	tbl->setRowCount(static_cast<int>(stats.methods().size()));
+	int row = 0;
+	auto set_cell = [tbl, &row](int col, const QVariant &val) {
+		QTableWidgetItem *it = tbl->item(row, col);
+		if(!it) {
+			it = new QTableWidgetItem();
+			tbl->setItem(row, col, it);
+		}
+		it->setData(Qt::DisplayRole, val);
+	};
+	for(const auto &[method, ms] : stats.methods()) {
+		const LatencyHistogram &h = ms.latency;
+		set_cell(ColMethod, QString::fromStdString(method));
+		set_cell(ColCount, static_cast<qulonglong>(h.count()));
+		set_cell(ColErrors, static_cast<qulonglong>(ms.errorCount));
+		set_cell(ColTimeouts, static_cast<qulonglong>(ms.timeoutCount));
+		set_cell(ColMin, static_cast<qlonglong>(h.min()));
+		set_cell(ColAvg, static_cast<qlonglong>(h.average()));
+		set_cell(ColP50, static_cast<qlonglong>(h.percentile(0.5)));
+		set_cell(ColP90, static_cast<qlonglong>(h.percentile(0.9)));
+		set_cell(ColP99, static_cast<qlonglong>(h.percentile(0.99)));
+		set_cell(ColMax, static_cast<qlonglong>(h.max()));
+		row++;
+	}
+	tbl->setSortingEnabled(true);
+}
+
+void DlgBrokerStatistics::saveCpon()
+{
+	if(!m_broker)
+		return;
+	std::string cpon = m_broker->rpcStatisticsSnapshot().toCpon("  ");
+	QString fn = QFileDialog::getSaveFileName(this, tr("Save RPC statistics"), QString(), tr("Cpon files (*.cpon)"));
+	if(fn.isEmpty())
+		return;
+	std::ofstream os(fn.toStdString(), std::ios::binary);
+	if(!os) {
+		QMessageBox::warning(this, tr("Warning"), tr("Cannot open file ") + fn);
+		return;
+	}
+	os.write(cpon.data(), static_cast<std::streamsize>(cpon.size()));
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QDialog>
+#include <QPointer>
+
+namespace Ui {
+class DlgBrokerStatistics;
+}
+
+class ShvBrokerNodeItem;
+class QTimer;
+
+class DlgBrokerStatistics : public QDialog
+{
+	Q_OBJECT
+
+	using Super = QDialog;
+public:
+	explicit DlgBrokerStatistics(ShvBrokerNodeItem *broker, QWidget *parent = nullptr);
+	~DlgBrokerStatistics() override;
+private:
+	void refresh();
+	void saveCpon();
+private:
+	Ui::DlgBrokerStatistics *ui;
+	QPointer<ShvBrokerNodeItem> m_broker;
+	QTimer *m_refreshTimer;
+};
@@ -1,58 +1,105 @@
 #include "dlgcallshvmethod.h"
 #include "ui_dlgcallshvmethod.h"
+#include "rpcrequestabort.h"
+#include "theapp.h"
+#include "callhistory.h"
+#include "batchcallrunner.h"
+#include "batchcallmodel/batchcallmodel.h"
 
 #include <shv/chainpack/rpcmessage.h>
 #include <shv/iotqt/rpc/clientconnection.h>
-#include <shv/iotqt/rpc/rpccall.h>
 
-#include <QCoreApplication>
+#include <QDateTime>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QHeaderView>
 #include <QLineEdit>
+#include <QMessageBox>
+#include <QSaveFile>
+#include <QSettings>
+#include <QSignalBlocker>
 
 using namespace shv::chainpack;
 
 namespace {
-const auto Key_shvPaths = "DlgCallShvMethod/shvPaths";
-const auto Key_methods = "DlgCallShvMethod/methods";
-const auto Key_params = "DlgCallShvMethod/params";
+enum HistoryRole {PathRole = Qt::UserRole, MethodRole, ParamsRole};
+
+const auto Key_batchConcurrency = QStringLiteral("batchCall/concurrency");
+const auto Key_batchScript = QStringLiteral("batchCall/script");
+const auto Key_batchExportDir = QStringLiteral("batchCall/exportDir");
+// status line is not recounted for every streamed result
+constexpr int BATCH_STATUS_DELAY_MSEC = 200;
+// same default as broker node uses
+constexpr int DEFAULT_RPC_TIMEOUT_MSEC = 5000;
+
+/// Replaces combo items and keeps the edited text.
+void set_items(QComboBox *combo, const QStringList &items)
+{
+	QSignalBlocker blocker(combo);
+	const auto text = combo->currentText();
+	combo->clear();
+	combo->addItems(items);
+	combo->setEditText(text);
+}
 }
 
-DlgCallShvMethod::DlgCallShvMethod(shv::iotqt::rpc::ClientConnection *connection, QWidget *parent)
+DlgCallShvMethod::DlgCallShvMethod(shv::iotqt::rpc::ClientConnection *connection, const std::string &broker, int rpc_timeout_msec, QWidget *parent)
 	: QDialog(parent)
 	, ui(new Ui::DlgCallShvMethod)
 	, m_connection(connection)
+	, m_broker(broker)
+	, m_batchRunner(new BatchCallRunner(connection, this))
+	, m_batchModel(new BatchCallModel(m_batchRunner, this))
 {
 	ui->setupUi(this);
 	connect(ui->btCall, &QPushButton::clicked, this, &DlgCallShvMethod::callShvMethod);
+	connect(m_connection, &shv::iotqt::rpc::ClientConnection::rpcMessageReceived, this, &DlgCallShvMethod::onRpcMessageReceived);
+	m_rpcTimeoutTimer.setInterval(rpc_timeout_msec > 0? rpc_timeout_msec: DEFAULT_RPC_TIMEOUT_MSEC);
+	m_rpcTimeoutTimer.setSingleShot(true);
+	connect(&m_rpcTimeoutTimer, &QTimer::timeout, this, &DlgCallShvMethod::onRpcCallTimeout);
 
-	QCoreApplication *app = QCoreApplication::instance();
-	ui->edShvPath->addItems(app->property(Key_shvPaths).toStringList());
 	ui->edShvPath->lineEdit()->setClearButtonEnabled(true);
-	ui->edMethod->addItems(app->property(Key_methods).toStringList());
 	ui->edMethod->lineEdit()->setClearButtonEnabled(true);
-	ui->edParams->addItems(app->property(Key_params).toStringList());
 	ui->edParams->lineEdit()->setClearButtonEnabled(true);
+	set_items(ui->edShvPath, TheApp::instance()->callHistory()->paths(m_broker));
+	ui->edShvPath->setEditText({});
+	connect(ui->edShvPath, &QComboBox::currentTextChanged, this, &DlgCallShvMethod::loadMethods);
+	connect(ui->edMethod, &QComboBox::currentTextChanged, this, &DlgCallShvMethod::loadParams);
+
+	connect(ui->edHistoryFilter, &QLineEdit::textChanged, this, &DlgCallShvMethod::filterHistory);
+	connect(TheApp::instance()->callHistory(), &CallHistory::recorded, this, &DlgCallShvMethod::filterHistory);
+	connect(ui->lstHistory, &QListWidget::itemActivated, this, [this](QListWidgetItem *item) {
+		ui->edShvPath->setEditText(item->data(PathRole).toString());
+		ui->edMethod->setEditText(item->data(MethodRole).toString());
+		ui->edParams->setEditText(item->data(ParamsRole).toString());
+	});
+	filterHistory();
+
+	QSettings settings;
+	ui->edConcurrency->setValue(settings.value(Key_batchConcurrency, BatchCallRunner::DEFAULT_CONCURRENCY).toInt());
+	ui->edBatchScript->setPlainText(settings.value(Key_batchScript).toString());
+	ui->tblBatchResults->setModel(m_batchModel);
+	ui->tblBatchResults->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+	ui->btAbortBatch->setEnabled(false);
+	ui->btExportBatch->setEnabled(false);
+	connect(ui->btRunBatch, &QPushButton::clicked, this, &DlgCallShvMethod::runBatch);
+	connect(ui->btAbortBatch, &QPushButton::clicked, m_batchRunner, &BatchCallRunner::abort);
+	connect(ui->btExportBatch, &QPushButton::clicked, this, &DlgCallShvMethod::exportBatch);
+	m_batchStatusTimer.setInterval(BATCH_STATUS_DELAY_MSEC);
+	m_batchStatusTimer.setSingleShot(true);
+	connect(&m_batchStatusTimer, &QTimer::timeout, this, &DlgCallShvMethod::updateBatchStatus);
+	connect(m_batchRunner, &BatchCallRunner::callChanged, &m_batchStatusTimer, [this]() {
+		if (!m_batchStatusTimer.isActive()) {
+			m_batchStatusTimer.start();
+		}
+	});
+	connect(m_batchRunner, &BatchCallRunner::finished, this, &DlgCallShvMethod::updateBatchStatus);
 }
 
 DlgCallShvMethod::~DlgCallShvMethod()
 {
-	auto save_list = [](const char *prop_name, QComboBox *combo)
-	{
-		QCoreApplication *app = QCoreApplication::instance();
-		QStringList sl;
-		if (auto s = combo->currentText().trimmed(); !s.isEmpty()) {
-			sl << s;
-		}
-		for (int i = 0; i < combo->count(); ++i) {
-			auto s = combo->itemText(i);
-			if (!sl.contains(s)) {
-				sl << s;
-			}
-		}
-		app->setProperty(prop_name, sl);
-	};
-	save_list(Key_shvPaths, ui->edShvPath);
-	save_list(Key_methods, ui->edMethod);
-	save_list(Key_params, ui->edParams);
+	abortShvMethodCall();
+	m_batchRunner->abort();
 	delete ui;
 }
 
@@ -74,19 +121,153 @@ void DlgCallShvMethod::callShvMethod()
 		ui->txtResponse->setPlainText(QString::fromStdString(err));
 		return;
 	}
-	auto *rpc_call = shv::iotqt::rpc::RpcCall::create(m_connection)
-			->setShvPath(shv_path)
-			->setMethod(method)
-			->setParams(params);
-	if (ui->cbxUserId->isChecked()) {
-		rpc_call->setUserId("");
+	abortShvMethodCall();
+	m_rpcShvPath = shv_path;
+	m_rpcMethod = method;
+	m_rpcParams = CallHistory::paramsToCpon(params);
+	m_rpcCallTimer.start();
+	m_rpcRequestId = m_connection->callShvMethod(shv_path, method, params, ui->cbxUserId->isChecked()? RpcValue(""): RpcValue());
+	m_rpcTimeoutTimer.start();
+	ui->txtResponse->setPlainText(tr("Waiting for response ..."));
+}
+
+void DlgCallShvMethod::abortShvMethodCall()
+{
+	m_rpcTimeoutTimer.stop();
+	if (m_rpcRequestId > 0) {
+		rpcRequest::sendAbort(m_connection, m_rpcRequestId, m_rpcShvPath, m_rpcMethod);
+		m_rpcRequestId = 0;
+	}
+}
+
+void DlgCallShvMethod::onRpcMessageReceived(const RpcMessage &msg)
+{
+	if (!msg.isResponse() || m_rpcRequestId == 0 || msg.requestId().toInt() != m_rpcRequestId) {
+		return;
+	}
+	RpcResponse resp(msg);
+	if (auto delay = resp.delay(); delay.has_value()) {
+		ui->txtResponse->setPlainText(tr("Waiting for response ... %1 %").arg(static_cast<int>(delay.value() * 100)));
+		// progress report means the call is alive
+		m_rpcTimeoutTimer.start();
+		return;
+	}
+	m_rpcTimeoutTimer.stop();
+	m_rpcRequestId = 0;
+	const auto latency = m_rpcCallTimer.elapsed();
+	if (resp.isError()) {
+		ui->txtResponse->setPlainText(tr("RPC request error: %1").arg(QString::fromStdString(resp.error().toString())));
+	} else {
+		ui->txtResponse->setPlainText(QString::fromStdString(resp.result().toCpon()));
+	}
+	if (m_rpcParams.has_value()) {
+		TheApp::instance()->callHistory()->record(CallHistory::Entry{
+			m_broker,
+			m_rpcShvPath,
+			m_rpcMethod,
+			m_rpcParams.value(),
+			QDateTime::currentMSecsSinceEpoch() - latency,
+			latency,
+			resp.isError()? -1: CallHistory::resultSize(resp.result()),
+		});
 	}
-	connect(rpc_call, &shv::iotqt::rpc::RpcCall::maybeResult, this, [this](const RpcValue &result, const RpcError &error) {
-		if (error.isValid()) {
-			ui->txtResponse->setPlainText(tr("RPC request error: %1").arg(QString::fromStdString(error.toString())));
-		} else {
-			ui->txtResponse->setPlainText(QString::fromStdString(result.toCpon()));
+}
+
+void DlgCallShvMethod::onRpcCallTimeout()
+{
+	if (m_rpcRequestId == 0) {
+		return;
+	}
+	const auto latency = m_rpcCallTimer.elapsed();
+	abortShvMethodCall();
+	ui->txtResponse->setPlainText(tr("RPC request timeout expired after %1 ms, request was aborted.").arg(latency));
+}
+
+void DlgCallShvMethod::loadMethods()
+{
+	const auto path = ui->edShvPath->currentText().trimmed().toStdString();
+	set_items(ui->edMethod, TheApp::instance()->callHistory()->methods(m_broker, path));
+	loadParams();
+}
+
+void DlgCallShvMethod::loadParams()
+{
+	const auto path = ui->edShvPath->currentText().trimmed().toStdString();
+	const auto method = ui->edMethod->currentText().trimmed().toStdString();
+	set_items(ui->edParams, TheApp::instance()->callHistory()->params(m_broker, path, method));
+}
+
+void DlgCallShvMethod::filterHistory()
+{
+	ui->lstHistory->clear();
+	for (const auto &entry : TheApp::instance()->callHistory()->find(m_broker, ui->edHistoryFilter->text().trimmed())) {
+		const auto path = QString::fromStdString(entry.shvPath);
+		const auto method = QString::fromStdString(entry.method);
+		const auto params = QString::fromStdString(entry.params);
+		auto *item = new QListWidgetItem(params.isEmpty()? path + ':' + method: path + ':' + method + ' ' + params);
+		item->setData(PathRole, path);
+		item->setData(MethodRole, method);
+		item->setData(ParamsRole, params);
+		item->setToolTip(tr("%1, %2 ms").arg(QDateTime::fromMSecsSinceEpoch(entry.callMsec).toString(Qt::ISODate)).arg(entry.latencyMsec));
+		ui->lstHistory->addItem(item);
+	}
+}
+
+void DlgCallShvMethod::runBatch()
+{
+	const auto script = ui->edBatchScript->toPlainText();
+	std::string err;
+	const auto calls = RpcValue::fromCpon(script.toStdString(), &err);
+	if (err.empty()) {
+		m_batchRunner->start(calls, ui->edConcurrency->value(), err);
+	}
+	if (!err.empty()) {
+		ui->lblBatchStatus->setText(tr("Invalid script: %1").arg(QString::fromStdString(err)));
+		return;
+	}
+	QSettings settings;
+	settings.setValue(Key_batchConcurrency, ui->edConcurrency->value());
+	settings.setValue(Key_batchScript, script);
+	updateBatchStatus();
+}
+
+void DlgCallShvMethod::exportBatch()
+{
+	QSettings settings;
+	auto file_name = QFileDialog::getSaveFileName(this, tr("Export batch results"), settings.value(Key_batchExportDir).toString(), tr("ChainPack files (*.chpk);;All files (*)"));
+	if (file_name.isEmpty()) {
+		return;
+	}
+	settings.setValue(Key_batchExportDir, QFileInfo(file_name).absolutePath());
+	const auto data = m_batchRunner->toRpcValue().toChainPack();
+	QSaveFile f(file_name);
+	if (!f.open(QFile::WriteOnly) || f.write(data.data(), static_cast<qint64>(data.size())) != static_cast<qint64>(data.size()) || !f.commit()) {
+		QMessageBox::warning(this, tr("Warning"), tr("Cannot write file %1: %2").arg(file_name, f.errorString()));
+	}
+}
+
+void DlgCallShvMethod::updateBatchStatus()
+{
+	int finished = 0;
+	int failed = 0;
+	for (const auto &call : m_batchRunner->calls()) {
+		if (call.status == BatchCallRunner::Status::Finished) {
+			finished++;
 		}
-	});
-	rpc_call->start();
+		else if (call.status == BatchCallRunner::Status::Failed) {
+			failed++;
+		}
+	}
+	const bool is_running = m_batchRunner->isRunning();
+	auto status = tr("%1 of %2 calls finished, %3 failed").arg(finished + failed).arg(m_batchRunner->calls().size()).arg(failed);
+	if (is_running && m_batchRunner->pendingTemplateCount() > 0) {
+		status += tr(", expanding %1 paths").arg(m_batchRunner->pendingTemplateCount());
+	}
+	if (!m_batchRunner->error().empty()) {
+		status += tr(", stopped: %1").arg(QString::fromStdString(m_batchRunner->error()));
+	}
+	ui->lblBatchStatus->setText(status);
+	ui->btRunBatch->setEnabled(!is_running);
+	ui->btAbortBatch->setEnabled(is_running);
+	ui->btExportBatch->setEnabled(!m_batchRunner->calls().empty());
 }
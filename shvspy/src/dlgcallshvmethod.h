@@ -2,27 +2,58 @@
 #define DLGCALLSHVMETHOD_H
 
 #include <QDialog>
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <optional>
+#include <string>
 
 namespace Ui {
 class DlgCallShvMethod;
 }
 
 namespace shv::iotqt::rpc { class ClientConnection; }
+namespace shv::chainpack { class RpcMessage; }
+
+class BatchCallRunner;
+class BatchCallModel;
 
 class DlgCallShvMethod : public QDialog
 {
 	Q_OBJECT
 
 public:
-	explicit DlgCallShvMethod(shv::iotqt::rpc::ClientConnection *connection, QWidget *parent = nullptr);
+	/// Call without response or progress for rpc_timeout_msec is reported as timed out and aborted.
+	explicit DlgCallShvMethod(shv::iotqt::rpc::ClientConnection *connection, const std::string &broker, int rpc_timeout_msec, QWidget *parent = nullptr);
 	~DlgCallShvMethod() override;
 
 	void setShvPath(const std::string &path);
 private:
 	void callShvMethod();
+	void abortShvMethodCall();
+	void onRpcMessageReceived(const shv::chainpack::RpcMessage &msg);
+	void onRpcCallTimeout();
+	void loadMethods();
+	void loadParams();
+	void filterHistory();
+	void runBatch();
+	void exportBatch();
+	void updateBatchStatus();
 private:
 	Ui::DlgCallShvMethod *ui;
 	shv::iotqt::rpc::ClientConnection *m_connection;
+	/// Broker node id, call history is kept per broker.
+	std::string m_broker;
+	int m_rpcRequestId = 0;
+	std::string m_rpcShvPath;
+	std::string m_rpcMethod;
+	/// Not recorded to history when params are too big.
+	std::optional<std::string> m_rpcParams;
+	QElapsedTimer m_rpcCallTimer;
+	QTimer m_rpcTimeoutTimer;
+	BatchCallRunner *m_batchRunner;
+	BatchCallModel *m_batchModel;
+	QTimer m_batchStatusTimer;
 };
 
 #endif // DLGCALLSHVMETHOD_H
@@ -0,0 +1,104 @@
+#include "dlgrpcvaluetree.h"
+#include "ui_dlgrpcvaluetree.h"
+
+#include "rpcvaluetreemodel/rpcvaluetreemodel.h"
+#include "texteditdialog.h"
+
+#include <shv/chainpack/rpcvalue.h>
+
+#include <QApplication>
+#include <QClipboard>
+#include <QMenu>
+#include <QSettings>
+
+namespace cp = shv::chainpack;
+
+DlgRpcValueTree::DlgRpcValueTree(QWidget *parent)
+	: Super(parent)
+	, ui(new Ui::DlgRpcValueTree)
+	, m_model(new RpcValueTreeModel(this))
+{
+	ui->setupUi(this);
+	ui->lblError->hide();
+	ui->treeValue->setModel(m_model);
+
+	connect(ui->treeValue->selectionModel(), &QItemSelectionModel::currentChanged, this, [this](const QModelIndex &current) {
+		ui->edPath->setText(m_model->path(current));
+		ui->lblError->hide();
+	});
+	connect(ui->treeValue, &QTreeView::customContextMenuRequested, this, &DlgRpcValueTree::onTreeContextMenu);
+	connect(ui->edPath, &QLineEdit::returnPressed, this, &DlgRpcValueTree::goToPath);
+	connect(ui->btGoToPath, &QPushButton::clicked, this, &DlgRpcValueTree::goToPath);
+	connect(ui->btShowCpon, &QPushButton::clicked, this, &DlgRpcValueTree::showCpon);
+
+	QSettings settings;
+	restoreGeometry(settings.value(QStringLiteral("ui/DlgRpcValueTree/geometry")).toByteArray());
+}
+
+DlgRpcValueTree::~DlgRpcValueTree()
+{
+	QSettings settings;
+	settings.setValue(QStringLiteral("ui/DlgRpcValueTree/geometry"), saveGeometry());
+	delete ui;
+}
+
+void DlgRpcValueTree::setValue(const cp::RpcValue &val)
+{
+	m_model->setValue(val);
+	auto root = m_model->index(0, 0);
+	ui->treeValue->expand(root);
+	ui->treeValue->setCurrentIndex(root);
+	ui->treeValue->resizeColumnToContents(RpcValueTreeModel::ColKey);
+}
+
+void DlgRpcValueTree::goToPath()
+{
+	QString error;
+	auto ix = m_model->indexForPath(ui->edPath->text().trimmed(), &error);
+	if (!ix.isValid()) {
+		ui->lblError->setText(error);
+		ui->lblError->show();
+		return;
+	}
+	ui->lblError->hide();
+	ui->treeValue->setCurrentIndex(ix);
+	ui->treeValue->scrollTo(ix);
+	ui->treeValue->setFocus();
+}
+
+void DlgRpcValueTree::showCpon()
+{
+	auto ix = ui->treeValue->currentIndex();
+	auto val = m_model->value(ix.isValid()? ix: m_model->index(0, 0));
+	auto *view = new CponEditDialog(this);
+	view->setModal(false);
+	view->setAttribute(Qt::WA_DeleteOnClose);
+	view->setWindowTitle(m_model->path(ix));
+	view->setReadOnly(true);
+	view->setValidateContent(false);
+	view->setText(QString::fromStdString(val.toCpon("  ")));
+	view->show();
+}
+
+void DlgRpcValueTree::onTreeContextMenu(const QPoint &pos)
+{
+	auto ix = ui->treeValue->indexAt(pos);
+	if (!ix.isValid()) {
+		return;
+	}
+	QMenu menu(this);
+	auto *a_copy_cpon = menu.addAction(tr("Copy as Cpon"));
+	auto *a_copy_value = menu.addAction(tr("Copy value"));
+	auto *a_copy_path = menu.addAction(tr("Copy path"));
+	auto *a = menu.exec(ui->treeValue->viewport()->mapToGlobal(pos));
+	if (a == a_copy_cpon) {
+		QApplication::clipboard()->setText(QString::fromStdString(m_model->value(ix).toCpon()));
+	}
+	else if (a == a_copy_value) {
+		auto val = m_model->value(ix);
+		QApplication::clipboard()->setText(val.isString()? QString::fromStdString(val.asString()): QString::fromStdString(val.toCpon()));
+	}
+	else if (a == a_copy_path) {
+		QApplication::clipboard()->setText(m_model->path(ix));
+	}
+}
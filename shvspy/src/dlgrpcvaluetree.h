@@ -0,0 +1,30 @@
+#pragma once
+
+#include <QDialog>
+
+namespace shv::chainpack { class RpcValue; }
+
+namespace Ui {
+class DlgRpcValueTree;
+}
+
+class RpcValueTreeModel;
+
+class DlgRpcValueTree : public QDialog
+{
+	Q_OBJECT
+
+	using Super = QDialog;
+public:
+	explicit DlgRpcValueTree(QWidget *parent = nullptr);
+	~DlgRpcValueTree() override;
+
+	void setValue(const shv::chainpack::RpcValue &val);
+private:
+	void goToPath();
+	void showCpon();
+	void onTreeContextMenu(const QPoint &pos);
+private:
+	Ui::DlgRpcValueTree *ui;
+	RpcValueTreeModel *m_model;
+};
@@ -0,0 +1,126 @@
+#include "dlgtransfermanager.h"
+#include "ui_dlgtransfermanager.h"
+
+#include "transfermanager.h"
+
+#include <QLocale>
+#include <QSettings>
+#include <QTimer>
+
+namespace {
+enum Columns {ColDirection = 0, ColBroker, ColShvPath, ColLocalPath, ColStatus, ColProgress, ColRate, ColCnt};
+
+QString status_to_string(TransferManager::Status status)
+{
+	switch (status) {
+	case TransferManager::Status::Queued: return DlgTransferManager::tr("Queued");
+	case TransferManager::Status::Running: return DlgTransferManager::tr("Running");
+	case TransferManager::Status::Finished: return DlgTransferManager::tr("Finished");
+	case TransferManager::Status::Failed: return DlgTransferManager::tr("Failed");
+	case TransferManager::Status::Aborted: return DlgTransferManager::tr("Aborted");
+	}
+	return {};
+}
+}
+
+DlgTransferManager::DlgTransferManager(TransferManager *manager, QWidget *parent)
+	: Super(parent)
+	, ui(new Ui::DlgTransferManager)
+	, m_manager(manager)
+	, m_refreshTimer(new QTimer(this))
+{
+	ui->setupUi(this);
+
+	ui->tblTransfers->setColumnCount(ColCnt);
+	ui->tblTransfers->setHorizontalHeaderLabels({
+		tr("Direction"), tr("Broker"), tr("Shv path"), tr("Local path"), tr("Status"), tr("Progress"), tr("Rate"),
+	});
+
+	ui->edMaxConcurrent->setValue(m_manager->maxConcurrentPerBroker());
+	connect(ui->edMaxConcurrent, QOverload<int>::of(&QSpinBox::valueChanged), m_manager, &TransferManager::setMaxConcurrentPerBroker);
+	ui->edBandwidthLimit->setValue(static_cast<int>(m_manager->bandwidthLimit() / 1024));
+	connect(ui->edBandwidthLimit, QOverload<int>::of(&QSpinBox::valueChanged), m_manager, [this](int kib_per_sec) {
+		m_manager->setBandwidthLimit(qint64(kib_per_sec) * 1024);
+	});
+	connect(ui->btAbortSelected, &QPushButton::clicked, this, &DlgTransferManager::abortSelected);
+	connect(ui->btAbortAll, &QPushButton::clicked, m_manager, &TransferManager::abortAll);
+	connect(ui->btClearFinished, &QPushButton::clicked, m_manager, &TransferManager::clearFinished);
+
+	connect(m_refreshTimer, &QTimer::timeout, this, &DlgTransferManager::refresh);
+	m_refreshTimer->start(500);
+
+	QSettings settings;
+	restoreGeometry(settings.value(QStringLiteral("ui/DlgTransferManager/geometry")).toByteArray());
+
+	refresh();
+}
+
+DlgTransferManager::~DlgTransferManager()
+{
+	QSettings settings;
+	settings.setValue(QStringLiteral("ui/DlgTransferManager/geometry"), saveGeometry());
+	delete ui;
+}
+
+void DlgTransferManager::refresh()
+{
+	QLocale locale;
+	const auto &transfers = m_manager->transfers();
+	int queued = 0;
+	int running = 0;
+	int finished = 0;
+	int failed = 0;
+
+	QTableWidget *tbl = ui->tblTransfers;
+	tbl->setRowCount(static_cast<int>(transfers.size()));
+	int row = 0;
+	auto set_cell = [tbl, &row](int col, const QString &text, const QString &tool_tip = {}) {
+		QTableWidgetItem *it = tbl->item(row, col);
+		if(!it) {
+			it = new QTableWidgetItem();
+			tbl->setItem(row, col, it);
+		}
+		it->setText(text);
+		it->setToolTip(tool_tip);
+	};
+	for(const auto &[id, t] : transfers) {
+		switch (t.status) {
+		case TransferManager::Status::Queued: queued++; break;
+		case TransferManager::Status::Running: running++; break;
+		case TransferManager::Status::Finished: finished++; break;
+		case TransferManager::Status::Failed:
+		case TransferManager::Status::Aborted: failed++; break;
+		}
+		set_cell(ColDirection, t.direction == TransferManager::Direction::Download? tr("Download"): tr("Upload"));
+		tbl->item(row, ColDirection)->setData(Qt::UserRole, id);
+		set_cell(ColBroker, t.brokerName);
+		set_cell(ColShvPath, t.shvPath);
+		set_cell(ColLocalPath, t.localPath);
+		set_cell(ColStatus, status_to_string(t.status), t.error);
+		set_cell(ColProgress, t.total < 0? QString(): QStringLiteral("%1 / %2").arg(locale.formattedDataSize(t.bytes), locale.formattedDataSize(t.total)));
+		set_cell(ColRate, t.status == TransferManager::Status::Running? locale.formattedDataSize(t.bytesPerSec) + "/s": QString());
+		row++;
+	}
+	QString summary = tr("Running: %1, queued: %2, finished: %3, failed: %4, total rate: %5/s")
+			.arg(running)
+			.arg(queued)
+			.arg(finished)
+			.arg(failed)
+			.arg(locale.formattedDataSize(m_manager->totalBytesPerSec()));
+	if(m_manager->runningListingCount() > 0) {
+		summary += tr(", listing remote directories ...");
+	}
+	const QStringList &listing_errors = m_manager->listingErrors();
+	if(!listing_errors.isEmpty()) {
+		summary += tr(", listing errors: %1 (see tooltip)").arg(listing_errors.size());
+	}
+	ui->lblSummary->setText(summary);
+	ui->lblSummary->setToolTip(listing_errors.join('\n'));
+}
+
+void DlgTransferManager::abortSelected()
+{
+	for (const auto &ix : ui->tblTransfers->selectionModel()->selectedRows(ColDirection)) {
+		m_manager->abort(ix.data(Qt::UserRole).toInt());
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QDialog>
+
+namespace Ui {
+class DlgTransferManager;
+}
+
+class TransferManager;
+class QTimer;
+
+class DlgTransferManager : public QDialog
+{
+	Q_OBJECT
+
+	using Super = QDialog;
+public:
+	explicit DlgTransferManager(TransferManager *manager, QWidget *parent = nullptr);
+	~DlgTransferManager() override;
+private:
+	void refresh();
+	void abortSelected();
+private:
+	Ui::DlgTransferManager *ui;
+	TransferManager *m_manager;
+	QTimer *m_refreshTimer;
+};
@@ -1,12 +1,103 @@
 #include "fileloader.h"
+#include "bandwidthlimiter.h"
+#include "rpcrequestabort.h"
 
-#include <shv/iotqt/rpc/rpccall.h>
+#include <shv/chainpack/metamethod.h>
+#include <shv/chainpack/rpc.h>
+#include <shv/chainpack/rpcmessage.h>
+#include <shv/iotqt/rpc/clientconnection.h>
 #include <shv/coreqt/log.h>
 
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
 using namespace shv::chainpack;
 
 namespace {
 constexpr qsizetype DEFAULT_CHUNK_SIZE = 16 * 1024;
+constexpr qsizetype MAX_READ_CHUNK_SIZE = 64 * 1024;
+constexpr int RPC_TIMEOUT_MSEC = 5000;
+constexpr int MAX_CHUNK_ATTEMPTS = 3;
+
+// optional read variant with the same params as read, returning zlib (RFC 1950) compressed blob
+constexpr auto COMPRESSED_READ_METHOD = "readCompressed";
+
+// ranges compared when device does not provide file hash
+constexpr int VERIFY_SAMPLE_COUNT = 16;
+constexpr qint64 VERIFY_SAMPLE_SIZE = 4 * 1024;
+
+constexpr int MIN_WINDOW_SIZE = 1;
+constexpr int INITIAL_WINDOW_SIZE = 2;
+constexpr int MAX_WINDOW_SIZE = 16;
+// RTT above 2 * min RTT + slack means that requests are queued in the link or device
+constexpr int64_t RTT_SLACK_MSEC = 20;
+// do not grow chunk size when chunk RTT is already long, to stay far from RPC timeout
+constexpr int64_t CHUNK_GROW_MAX_RTT_MSEC = RPC_TIMEOUT_MSEC / 5;
+
+/// Wraps part of a buffer without copy, sizes over 2 GB are possible in Qt 6.
+QByteArray rawData(const char *data, qint64 size)
+{
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+	return QByteArray::fromRawData(data, static_cast<int>(size));
+#else
+	return QByteArray::fromRawData(data, size);
+#endif
+}
+
+qint64 bytesPerSec(qint64 bytes, const QElapsedTimer &timer)
+{
+	auto msec = timer.elapsed();
+	return msec > 0? bytes * 1000 / msec: 0;
+}
+}
+
+//=========================================================
+// TransferWindow
+//=========================================================
+TransferWindow::TransferWindow(qsizetype chunk_size, qsizetype max_chunk_size)
+	: m_size(INITIAL_WINDOW_SIZE)
+	, m_chunkSize(std::min(chunk_size, max_chunk_size))
+	, m_maxChunkSize(max_chunk_size)
+{
+}
+
+void TransferWindow::setMaxChunkSize(qsizetype n)
+{
+	m_maxChunkSize = n;
+	m_chunkSize = std::min(m_chunkSize, m_maxChunkSize);
+}
+
+void TransferWindow::chunkDone(int64_t rtt_msec)
+{
+	if (m_minRtt < 0 || rtt_msec < m_minRtt) {
+		m_minRtt = rtt_msec;
+	}
+	if (rtt_msec > 2 * m_minRtt + RTT_SLACK_MSEC) {
+		if (m_size > MIN_WINDOW_SIZE) {
+			m_size--;
+		}
+		return;
+	}
+	if (m_size < MAX_WINDOW_SIZE) {
+		m_size++;
+	}
+	else if (m_chunkSize < m_maxChunkSize && rtt_msec < CHUNK_GROW_MAX_RTT_MSEC) {
+		m_chunkSize = std::min(m_chunkSize * 2, m_maxChunkSize);
+		// bigger chunks take longer, RTT baseline has to be measured again
+		m_minRtt = -1;
+	}
+}
+
+void TransferWindow::chunkFailed()
+{
+	m_size = std::max(m_size / 2, MIN_WINDOW_SIZE);
 }
 
 //=========================================================
@@ -16,8 +107,273 @@ AbstractFileLoader::AbstractFileLoader(shv::iotqt::rpc::ClientConnection *conn,
 	: QObject(parent)
 	, m_connection(conn)
 	, m_shvPath(shv_path)
+	, m_timeoutTimer(new QTimer(this))
+	, m_throttleTimer(new QTimer(this))
+{
+	connect(this, &AbstractFileLoader::finished, this, &QObject::deleteLater);
+	connect(m_connection, &shv::iotqt::rpc::ClientConnection::rpcMessageReceived, this, &AbstractFileLoader::onRpcMessageReceived);
+	connect(m_connection, &shv::iotqt::rpc::ClientConnection::brokerConnectedChanged, this, &AbstractFileLoader::onBrokerConnectedChanged);
+	connect(m_timeoutTimer, &QTimer::timeout, this, &AbstractFileLoader::checkPendingCallsTimeout);
+	m_timeoutTimer->start(1000);
+	m_throttleTimer->setSingleShot(true);
+	connect(m_throttleTimer, &QTimer::timeout, this, [this]() {
+		if (!m_isFinished && !m_isSuspended) {
+			requestChunks();
+		}
+	});
+}
+
+bool AbstractFileLoader::isMethodPresent(const RpcValue &dir_result, const std::string &method)
 {
-	connect(this, &FileDownloader::finished, this, &FileDownloader::deleteLater);
+	if (dir_result.isBool()) {
+		return dir_result.toBool();
+	}
+	auto describes_method = [&method](const RpcValue &desc) {
+		if (desc.isString()) {
+			return desc.asString() == method;
+		}
+		if (desc.isList()) {
+			return desc.asList().valref(0).asString() == method;
+		}
+		return MetaMethod::fromRpcValue(desc).name() == method;
+	};
+	if (dir_result.isList()) {
+		const auto &lst = dir_result.asList();
+		return std::any_of(lst.begin(), lst.end(), describes_method);
+	}
+	return describes_method(dir_result);
+}
+
+bool AbstractFileLoader::acquireBandwidth(qsizetype bytes)
+{
+	if (!m_bandwidthLimiter) {
+		return true;
+	}
+	if (m_throttleTimer->isActive()) {
+		return false;
+	}
+	if (auto wait_msec = m_bandwidthLimiter->acquire(bytes); wait_msec > 0) {
+		m_throttleTimer->start(static_cast<int>(wait_msec));
+		return false;
+	}
+	return true;
+}
+
+void AbstractFileLoader::abort()
+{
+	if (m_isFinished) {
+		return;
+	}
+	m_isFinished = true;
+	m_isAborted = true;
+	abortPendingCalls();
+	deleteLater();
+}
+
+int AbstractFileLoader::callShvMethod(const std::string &method, const RpcValue &params, ResponseHandler &&handler)
+{
+	int rqid = m_connection->callShvMethod(m_shvPath.toStdString(), method, params);
+	PendingCall &call = m_pendingCalls[rqid];
+	call.method = method;
+	call.handler = std::move(handler);
+	call.lastActivity.start();
+	return rqid;
+}
+
+void AbstractFileLoader::finish(const QByteArray &data, const QString &error)
+{
+	if (m_isFinished) {
+		return;
+	}
+	m_isFinished = true;
+	abortPendingCalls();
+	emit finished(data, error);
+}
+
+void AbstractFileLoader::onBrokerConnectedChanged(bool is_connected)
+{
+	if (m_isFinished) {
+		return;
+	}
+	if (!is_connected) {
+		if (!m_isSuspended) {
+			shvInfo() << "Broker disconnected, suspending transfer of:" << m_shvPath;
+			m_isSuspended = true;
+			// responses will never come, requests are sent again after reconnect
+			m_pendingCalls.clear();
+			emit suspendedChanged(true);
+		}
+	}
+	else if (m_isSuspended) {
+		shvInfo() << "Broker connected, resuming transfer of:" << m_shvPath;
+		m_isSuspended = false;
+		emit suspendedChanged(false);
+		resumeTransfer();
+	}
+}
+
+void AbstractFileLoader::onRpcMessageReceived(const RpcMessage &msg)
+{
+	if (!msg.isResponse()) {
+		return;
+	}
+	auto it = m_pendingCalls.find(msg.requestId().toInt());
+	if (it == m_pendingCalls.end()) {
+		// not our request or a late response of aborted one, drop it without further processing
+		return;
+	}
+	RpcResponse resp(msg);
+	if (resp.delay().has_value()) {
+		it->second.lastActivity.start();
+		return;
+	}
+	auto handler = std::move(it->second.handler);
+	m_pendingCalls.erase(it);
+	if (resp.isError()) {
+		handler({}, QString::fromStdString(resp.error().toString()));
+	}
+	else {
+		handler(resp.result(), {});
+	}
+}
+
+void AbstractFileLoader::checkPendingCallsTimeout()
+{
+	std::vector<int> expired;
+	for (const auto &[rqid, call] : m_pendingCalls) {
+		if (call.lastActivity.elapsed() > RPC_TIMEOUT_MSEC) {
+			expired.push_back(rqid);
+		}
+	}
+	// handlers can start new calls or finish the loader, look each request up again
+	for (int rqid : expired) {
+		if (m_isFinished) {
+			return;
+		}
+		auto it = m_pendingCalls.find(rqid);
+		if (it == m_pendingCalls.end()) {
+			continue;
+		}
+		auto method = it->second.method;
+		auto handler = std::move(it->second.handler);
+		m_pendingCalls.erase(it);
+		shvWarning() << "RPC request timeout expired for file:" << m_shvPath << "method:" << method;
+		rpcRequest::sendAbort(m_connection, rqid, m_shvPath.toStdString(), method);
+		handler({}, tr("Method call timeout: %1").arg(QString::fromStdString(method)));
+	}
+}
+
+void AbstractFileLoader::abortPendingCalls()
+{
+	for (const auto &[rqid, call] : m_pendingCalls) {
+		rpcRequest::sendAbort(m_connection, rqid, m_shvPath.toStdString(), call.method);
+	}
+	m_pendingCalls.clear();
+}
+
+void AbstractFileLoader::verifyTransfer(const QByteArray &local_sha1, qint64 file_size, const TransferCheckpoint::LocalReader &reader, VerifyHandler &&handler)
+{
+	emit verificationStarted();
+	compareWithRemote(local_sha1, file_size, reader, std::move(handler));
+}
+
+QString AbstractFileLoader::checkpointKey(const QString &direction, const QString &local_file_name) const
+{
+	return direction + ':' + m_brokerName + '|' + m_shvPath + '|' + QFileInfo(local_file_name).absoluteFilePath();
+}
+
+void AbstractFileLoader::verifyCheckpoint(TransferCheckpoint &checkpoint, std::function<void ()> &&done)
+{
+	if (checkpoint.offset() == 0) {
+		done();
+		return;
+	}
+	// remote file could be changed or replaced since the checkpoint was saved
+	compareWithRemote(checkpoint.sha1(), checkpoint.offset(), checkpoint.localReader(), [this, &checkpoint, done = std::move(done)](const QString &error) {
+		if (!error.isEmpty()) {
+			shvWarning() << "Remote file does not match transfer checkpoint, starting from zero:" << m_shvPath << error;
+			checkpoint.discard();
+		}
+		done();
+	});
+}
+
+void AbstractFileLoader::compareWithRemote(const QByteArray &local_sha1, qint64 file_size, const TransferCheckpoint::LocalReader &reader, VerifyHandler &&handler)
+{
+	RpcValue::List params{0, file_size};
+	callShvMethod("sha1", params, [this, local_sha1, file_size, reader, handler = std::move(handler)](const RpcValue &result, const QString &error) mutable {
+		QByteArray remote_sha1;
+		if (result.isBlob()) {
+			const auto &blob = result.asBlob();
+			remote_sha1 = QByteArray(reinterpret_cast<const char*>(blob.data()), static_cast<int>(blob.size()));
+		}
+		else if (result.isString()) {
+			remote_sha1 = QByteArray::fromHex(QByteArray::fromStdString(result.asString()));
+		}
+		if (!error.isEmpty() || remote_sha1.isEmpty()) {
+			shvInfo() << "Remote sha1 not available for:" << m_shvPath << error << ", comparing sampled ranges";
+			verifySampledRanges(file_size, reader, std::move(handler));
+			return;
+		}
+		if (remote_sha1 != local_sha1) {
+			handler(tr("File verification failed, local SHA1: %1, remote SHA1: %2").arg(QString::fromLatin1(local_sha1.toHex()), QString::fromLatin1(remote_sha1.toHex())));
+			return;
+		}
+		handler({});
+	});
+}
+
+void AbstractFileLoader::verifySampledRanges(qint64 file_size, const TransferCheckpoint::LocalReader &reader, VerifyHandler &&handler)
+{
+	struct State
+	{
+		int pendingCount = 0;
+		bool isDone = false;
+		VerifyHandler handler;
+	};
+	auto state = std::make_shared<State>();
+	state->handler = std::move(handler);
+
+	std::vector<std::pair<qint64, qint64>> ranges;
+	if (file_size <= VERIFY_SAMPLE_COUNT * VERIFY_SAMPLE_SIZE) {
+		for (qint64 offset = 0; offset < file_size; offset += VERIFY_SAMPLE_SIZE) {
+			ranges.emplace_back(offset, std::min(VERIFY_SAMPLE_SIZE, file_size - offset));
+		}
+	}
+	else {
+		// evenly spread over the file, first and last bytes included
+		for (int i = 0; i < VERIFY_SAMPLE_COUNT; ++i) {
+			ranges.emplace_back((file_size - VERIFY_SAMPLE_SIZE) * i / (VERIFY_SAMPLE_COUNT - 1), VERIFY_SAMPLE_SIZE);
+		}
+	}
+	if (ranges.empty()) {
+		state->handler({});
+		return;
+	}
+	state->pendingCount = static_cast<int>(ranges.size());
+	for (const auto &[offset, size] : ranges) {
+		RpcValue::List params{offset, size};
+		callShvMethod("read", params, [state, reader, offset = offset, size = size](const RpcValue &result, const QString &error) {
+			if (state->isDone) {
+				return;
+			}
+			QString err;
+			if (!error.isEmpty()) {
+				err = tr("File verification read error: %1").arg(error);
+			}
+			else {
+				const auto &blob = result.asBlob();
+				auto local = reader(offset, size);
+				if (static_cast<qint64>(blob.size()) < size || local.size() != size || std::memcmp(blob.data(), local.constData(), static_cast<size_t>(size)) != 0) {
+					err = tr("File verification failed, content differs at offset: %1").arg(offset);
+				}
+			}
+			if (!err.isEmpty() || --state->pendingCount == 0) {
+				state->isDone = true;
+				state->handler(err);
+			}
+		});
+	}
 }
 
 //=========================================================
@@ -25,67 +381,313 @@ AbstractFileLoader::AbstractFileLoader(shv::iotqt::rpc::ClientConnection *conn,
 //=========================================================
 FileDownloader::FileDownloader(shv::iotqt::rpc::ClientConnection *conn, const QString &shv_path, QObject *parent)
 	: Super(conn, shv_path, parent)
+	, m_window(DEFAULT_CHUNK_SIZE, MAX_READ_CHUNK_SIZE)
+{
+}
+
+FileDownloader::~FileDownloader()
 {
+	if (m_decompressThread) {
+		// no decompressed chunk can be posted to this object after the worker has finished
+		m_decompressThread->quit();
+		m_decompressThread->wait();
+	}
+	if (m_targetFile && !m_targetFileComplete) {
+		if (isAborted() || m_checkpoint.offset() == 0) {
+			shvInfo() << "Removing incomplete download:" << m_targetFileName;
+			m_targetFile->remove();
+			m_checkpoint.remove();
+		}
+		else if (m_targetFile->resize(m_checkpoint.offset())) {
+			// chunks beyond confirmed prefix are not trusted
+			shvInfo() << "Keeping incomplete download:" << m_targetFileName << "confirmed bytes:" << m_checkpoint.offset();
+			m_checkpoint.save();
+		}
+		else {
+			shvWarning() << "Cannot truncate incomplete download:" << m_targetFileName << m_targetFile->errorString() << ", removing it";
+			m_targetFile->remove();
+			m_checkpoint.remove();
+		}
+	}
 }
 
 void FileDownloader::start()
 {
-	auto rpc_call = shv::iotqt::rpc::RpcCall::create(m_connection)
-			->setShvPath(m_shvPath)
-			->setMethod("size");
-	connect(rpc_call, &shv::iotqt::rpc::RpcCall::maybeResult, this, [this](const ::shv::chainpack::RpcValue &result, const shv::chainpack::RpcError &error) {
-		if (error.isValid()) {
-			emit finished({}, tr("Get file size error: %1").arg(QString::fromStdString(error.toString())));
+	callShvMethod("size", {}, [this](const RpcValue &result, const QString &error) {
+		if (!error.isEmpty()) {
+			finish({}, tr("Get file size error: %1").arg(error));
 			return;
 		}
 		m_fileSize = result.toInt();
-		downloadChunk();
-	});
-	rpc_call->start();
-}
-
-void FileDownloader::downloadChunk()
-{
-	if (m_data.size() < m_fileSize) {
-		emit progress(static_cast<int>(m_data.size() / DEFAULT_CHUNK_SIZE), chunkCnt());
-		auto bytes_to_read = m_fileSize - m_data.size();
-		// Cap bytes to read by file size
-		// PLC can return more than file_size bytes if requested
-		RpcValue::List params{{m_data.size(), std::min(bytes_to_read, DEFAULT_CHUNK_SIZE)}};
-		auto rpc_call = shv::iotqt::rpc::RpcCall::create(m_connection)
-				->setShvPath(m_shvPath)
-				->setMethod("read")
-				->setParams(params);
-		connect(rpc_call, &shv::iotqt::rpc::RpcCall::maybeResult, this, [this](const ::shv::chainpack::RpcValue &result, const shv::chainpack::RpcError &error) {
-			if (error.isValid()) {
-				emit finished({}, tr("Get file chunk error: %1").arg(QString::fromStdString(error.toString())));
-				return;
+		if (m_targetFileName.isEmpty()) {
+			m_data.resize(m_fileSize);
+			if (isVerify()) {
+				// hash is computed from confirmed prefix while chunks arrive
+				m_checkpoint.setLocalReader([this](qint64 offset, qint64 size) {
+					return rawData(m_data.constData() + offset, size);
+				});
 			}
-			if (!result.isBlob()) {
-				emit finished({}, tr("Blob should be received"));
+		}
+		else if (!openTargetFile()) {
+			return;
+		}
+		const bool is_resumed = m_checkpoint.offset() > 0;
+		verifyCheckpoint(m_checkpoint, [this, is_resumed]() {
+			if (is_resumed && m_checkpoint.offset() == 0 && m_targetFile && !resetTargetFile()) {
 				return;
 			}
-			const auto &chunk = result.asBlob();
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-			auto data = QByteArray::fromRawData(reinterpret_cast<const char*>(chunk.data()), chunk.size());
-			m_data.append(data);
-#else
-			m_data.append(QByteArrayView(chunk));
-#endif
-			downloadChunk();
+			m_nextOffset = m_receivedBytes = m_checkpoint.offset();
+			callShvMethod(Rpc::METH_DIR, COMPRESSED_READ_METHOD, [this](const RpcValue &dir_result, const QString &dir_error) {
+				// compressed read is not a standard file node method, it is used only when the node lists it
+				m_useCompressedRead = dir_error.isEmpty() && isMethodPresent(dir_result, COMPRESSED_READ_METHOD);
+				if (m_useCompressedRead) {
+					startDecompressThread();
+				}
+				m_transferTimer.start();
+				requestChunks();
+			});
 		});
-		rpc_call->start();
+	});
+}
 
+void FileDownloader::startDecompressThread()
+{
+	if (m_decompressThread) {
+		return;
+	}
+	shvDebug() << "Using compressed read for:" << m_shvPath;
+	m_decompressThread = new QThread(this);
+	m_decompressWorker = new QObject();
+	m_decompressWorker->moveToThread(m_decompressThread);
+	connect(m_decompressThread, &QThread::finished, m_decompressWorker, &QObject::deleteLater);
+	m_decompressThread->start();
+}
+
+void FileDownloader::resumeTransfer()
+{
+	if (m_fileSize < 0) {
+		start();
+		return;
+	}
+	m_retryChunks.clear();
+	m_checkpoint.rewind();
+	m_nextOffset = m_receivedBytes = m_checkpoint.offset();
+	// chunks being decompressed now belong to requests before reconnect, they will be dropped
+	m_transferGeneration++;
+	requestChunks();
+}
+
+bool FileDownloader::openTargetFile()
+{
+	if (!m_targetFile) {
+		m_targetFile = new QFile(m_targetFileName, this);
+		if (!m_targetFile->open(QFile::ReadWrite)) {
+			finish({}, tr("Cannot open file %1 for writing: %2").arg(m_targetFileName, m_targetFile->errorString()));
+			return false;
+		}
+	}
+	m_checkpoint.setKey(checkpointKey(QStringLiteral("download"), m_targetFileName));
+	m_checkpoint.setLocalReader([this](qint64 offset, qint64 size) {
+		return loadChunk(offset, size);
+	});
+	if (!m_checkpoint.restore(m_fileSize)) {
+		return resetTargetFile();
+	}
+	// incomplete download was truncated to confirmed bytes
+	if (!m_targetFile->resize(m_fileSize)) {
+		finish({}, tr("Cannot resize file %1: %2").arg(m_targetFileName, m_targetFile->errorString()));
+		return false;
+	}
+	return true;
+}
+
+bool FileDownloader::resetTargetFile()
+{
+	if (!m_targetFile->resize(0) || !m_targetFile->resize(m_fileSize)) {
+		finish({}, tr("Cannot resize file %1: %2").arg(m_targetFileName, m_targetFile->errorString()));
+		return false;
+	}
+	return true;
+}
+
+void FileDownloader::requestChunks()
+{
+	while (pendingCallCount() < static_cast<size_t>(m_window.size())) {
+		Chunk chunk;
+		if (!m_retryChunks.empty()) {
+			chunk = m_retryChunks.back();
+		}
+		else if (m_nextOffset < m_fileSize) {
+			// Cap bytes to read by file size
+			// PLC can return more than file_size bytes if requested
+			chunk = Chunk{m_nextOffset, std::min(m_fileSize - m_nextOffset, m_window.chunkSize()), 1};
+		}
+		else {
+			break;
+		}
+		if (!acquireBandwidth(chunk.size)) {
+			break;
+		}
+		if (!m_retryChunks.empty()) {
+			m_retryChunks.pop_back();
+		}
+		else {
+			m_nextOffset += chunk.size;
+		}
+		readChunk(chunk.offset, chunk.size, chunk.attempt);
+	}
+	if (pendingCallCount() == 0 && m_decompressingCount == 0 && m_receivedBytes >= m_fileSize) {
+		completeTransfer();
+	}
+}
+
+void FileDownloader::completeTransfer()
+{
+	emit progress(chunkCnt(), chunkCnt());
+	auto done = [this](const QString &error) {
+		if (!error.isEmpty()) {
+			// confirmed data are wrong, do not resume from them
+			m_checkpoint.discard();
+			finish({}, error);
+			return;
+		}
+		if (m_targetFile) {
+			m_targetFile->close();
+			m_targetFileComplete = true;
+		}
+		m_checkpoint.remove();
+		finish(m_data, {});
+	};
+	if (isVerify()) {
+		verifyTransfer(m_checkpoint.sha1(), m_fileSize, m_checkpoint.localReader(), done);
 	}
 	else {
-		emit progress(chunkCnt(), chunkCnt());
-		emit finished(m_data, {});
+		done({});
+	}
+}
+
+bool FileDownloader::storeChunk(qsizetype offset, const uint8_t *data, qsizetype size)
+{
+	if (!m_targetFile) {
+		std::memcpy(m_data.data() + offset, data, static_cast<size_t>(size));
+		return true;
+	}
+	return m_targetFile->seek(offset) && m_targetFile->write(reinterpret_cast<const char*>(data), size) == size;
+}
+
+QByteArray FileDownloader::loadChunk(qint64 offset, qint64 size) const
+{
+	if (!m_targetFile->seek(offset)) {
+		return {};
+	}
+	return m_targetFile->read(size);
+}
+
+void FileDownloader::readChunk(qsizetype offset, qsizetype size, int attempt)
+{
+	auto sent_msec = m_transferTimer.elapsed();
+	bool is_compressed = m_useCompressedRead;
+	RpcValue::List params{{offset, size}};
+	callShvMethod(is_compressed? COMPRESSED_READ_METHOD: "read", params, [this, offset, size, attempt, sent_msec, is_compressed](const RpcValue &result, const QString &error) {
+		if (!error.isEmpty()) {
+			if (is_compressed) {
+				fallBackToPlainRead(offset, size, attempt, error);
+				return;
+			}
+			if (attempt >= MAX_CHUNK_ATTEMPTS) {
+				finish({}, tr("Get file chunk error: %1").arg(error));
+				return;
+			}
+			shvWarning() << "Read file chunk at offset:" << offset << "error:" << error << "retrying";
+			m_window.chunkFailed();
+			m_retryChunks.push_back(Chunk{offset, size, attempt + 1});
+			requestChunks();
+			return;
+		}
+		if (!result.isBlob()) {
+			finish({}, tr("Blob should be received"));
+			return;
+		}
+		m_window.chunkDone(m_transferTimer.elapsed() - sent_msec);
+		const auto &chunk = result.asBlob();
+		if (is_compressed) {
+			decompressChunk(offset, size, attempt, QByteArray(reinterpret_cast<const char*>(chunk.data()), static_cast<int>(chunk.size())));
+			requestChunks();
+			return;
+		}
+		if (processChunk(offset, size, attempt, chunk.data(), static_cast<qsizetype>(chunk.size()))) {
+			requestChunks();
+		}
+	});
+}
+
+void FileDownloader::decompressChunk(qsizetype offset, qsizetype size, int attempt, const QByteArray &compressed)
+{
+	m_decompressingCount++;
+	auto generation = m_transferGeneration;
+	QMetaObject::invokeMethod(m_decompressWorker, [this, offset, size, attempt, generation, compressed]() {
+		// worker thread, qUncompress expects expected length as big endian prefix
+		QByteArray prefixed(4, '\0');
+		auto expected = static_cast<quint32>(size);
+		for (int i = 3; i >= 0; --i) {
+			prefixed[i] = static_cast<char>(expected & 0xff);
+			expected >>= 8;
+		}
+		prefixed.append(compressed);
+		QByteArray data = qUncompress(prefixed);
+		QMetaObject::invokeMethod(this, [this, offset, size, attempt, generation, data]() {
+			m_decompressingCount--;
+			if (isFinished() || isSuspended()) {
+				// chunk is requested again after reconnect
+				return;
+			}
+			if (generation != m_transferGeneration) {
+				requestChunks();
+				return;
+			}
+			if (data.isEmpty()) {
+				fallBackToPlainRead(offset, size, attempt, tr("Decompression error"));
+				return;
+			}
+			if (processChunk(offset, size, attempt, reinterpret_cast<const uint8_t*>(data.constData()), data.size())) {
+				requestChunks();
+			}
+		}, Qt::QueuedConnection);
+	}, Qt::QueuedConnection);
+}
+
+void FileDownloader::fallBackToPlainRead(qsizetype offset, qsizetype size, int attempt, const QString &error)
+{
+	shvWarning() << COMPRESSED_READ_METHOD << "failed for:" << m_shvPath << "error:" << error << ", falling back to plain read";
+	m_useCompressedRead = false;
+	m_retryChunks.push_back(Chunk{offset, size, attempt});
+	requestChunks();
+}
+
+bool FileDownloader::processChunk(qsizetype offset, qsizetype size, int attempt, const uint8_t *data, qsizetype data_size)
+{
+	auto n = std::min(data_size, size);
+	if (n == 0) {
+		finish({}, tr("Unexpected end of file at offset: %1").arg(offset));
+		return false;
+	}
+	if (!storeChunk(offset, data, n)) {
+		finish({}, tr("Write file %1 error: %2").arg(m_targetFileName, m_targetFile->errorString()));
+		return false;
+	}
+	m_receivedBytes += n;
+	m_checkpoint.confirm(offset, n);
+	if (n < size) {
+		m_retryChunks.push_back(Chunk{offset + n, size - n, attempt});
 	}
+	emit progress(static_cast<int>(m_receivedBytes / DEFAULT_CHUNK_SIZE), chunkCnt());
+	emit transferProgress(m_receivedBytes, m_fileSize, bytesPerSec(m_receivedBytes, m_transferTimer));
+	return true;
 }
 
 int FileDownloader::chunkCnt() const
 {
-	return static_cast<int>(m_fileSize / DEFAULT_CHUNK_SIZE) + 1;
+	return static_cast<int>(std::max(m_fileSize, qsizetype(0)) / DEFAULT_CHUNK_SIZE) + 1;
 }
 
 //=========================================================
@@ -93,61 +695,256 @@ int FileDownloader::chunkCnt() const
 //=========================================================
 FileUploader::FileUploader(shv::iotqt::rpc::ClientConnection *conn, const QString &shv_path, QByteArray data, QObject *parent)
 	: Super(conn, shv_path, parent)
+	, m_window(DEFAULT_CHUNK_SIZE, DEFAULT_CHUNK_SIZE)
 {
 	m_data = data;
+	m_source = m_data.constData();
+	m_sourceSize = m_data.size();
+	m_checkpoint.setLocalReader([this](qint64 offset, qint64 size) {
+		return rawData(m_source + offset, size);
+	});
+}
+
+FileUploader::FileUploader(shv::iotqt::rpc::ClientConnection *conn, const QString &shv_path, const QString &local_file_name, QObject *parent)
+	: FileUploader(conn, shv_path, QByteArray(), parent)
+{
+	m_sourceFileName = local_file_name;
+	connect(this, &AbstractFileLoader::finished, this, [this]() {
+		m_source = nullptr;
+		m_sourceFile.close();
+	});
+}
+
+bool FileUploader::openSourceFile()
+{
+	if (m_sourceFileName.isEmpty() || m_sourceFile.isOpen()) {
+		return true;
+	}
+	if (!m_sourceFile.open(m_sourceFileName)) {
+		finish({}, tr("Cannot open file %1: %2").arg(m_sourceFileName, m_sourceFile.errorString()));
+		return false;
+	}
+	m_source = m_sourceFile.data();
+	m_sourceSize = m_sourceFile.size();
+	return true;
+}
+
+FileUploader::~FileUploader()
+{
+	if (!m_isComplete) {
+		if (isAborted()) {
+			m_checkpoint.remove();
+		}
+		else {
+			m_checkpoint.save();
+		}
+	}
 }
 
-void FileUploader::uploadChunk()
-{
-	shvDebug() << m_bytesWritten << "/" << m_data.size();
-	if (m_bytesWritten < m_data.size()) {
-		emit progress(static_cast<int>(m_bytesWritten / m_chunkSize), chunkCnt());
-		auto bytes_to_write = std::min(m_data.size() - m_bytesWritten, m_chunkSize);
-		RpcValue::Blob blob(m_data.constData() + m_bytesWritten, m_data.constData() + m_bytesWritten + bytes_to_write);
-		RpcValue::List params{{RpcValue(m_bytesWritten), blob}};
-		auto rpc_call = shv::iotqt::rpc::RpcCall::create(m_connection)
-				->setShvPath(m_shvPath)
-				->setMethod("write")
-				->setParams(params);
-		connect(rpc_call, &shv::iotqt::rpc::RpcCall::maybeResult, this, [this, bytes_to_write](const ::shv::chainpack::RpcValue &, const shv::chainpack::RpcError &error) {
-			if (error.isValid()) {
-				emit finished({}, tr("Write file chunk error: %1").arg(QString::fromStdString(error.toString())));
+void FileUploader::requestChunks()
+{
+	while (pendingCallCount() < static_cast<size_t>(m_window.size())) {
+		Chunk chunk;
+		if (!m_retryChunks.empty()) {
+			chunk = m_retryChunks.back();
+		}
+		else if (m_compareOffset < m_compareEnd) {
+			auto size = std::min(m_compareEnd - m_compareOffset, m_window.chunkSize());
+			// block is read back when device cannot hash it
+			if (!m_isRemoteHashAvailable && !acquireBandwidth(size)) {
+				break;
+			}
+			compareBlock(m_compareOffset, size);
+			m_compareOffset += size;
+			continue;
+		}
+		else if (m_nextOffset < m_sourceSize) {
+			chunk = Chunk{m_nextOffset, std::min(m_sourceSize - m_nextOffset, m_window.chunkSize()), 1};
+		}
+		else {
+			break;
+		}
+		if (!acquireBandwidth(chunk.size)) {
+			break;
+		}
+		if (!m_retryChunks.empty()) {
+			m_retryChunks.pop_back();
+		}
+		else {
+			m_nextOffset += chunk.size;
+		}
+		writeChunk(chunk.offset, chunk.size, chunk.attempt);
+	}
+	if (pendingCallCount() == 0 && m_bytesWritten >= m_sourceSize) {
+		completeTransfer();
+	}
+}
+
+void FileUploader::completeTransfer()
+{
+	if (m_remoteSize > m_sourceSize) {
+		// remote file was longer, its tail would survive block writes
+		callShvMethod("truncate", RpcValue(static_cast<int64_t>(m_sourceSize)), [this](const RpcValue &, const QString &error) {
+			if (!error.isEmpty()) {
+				finish({}, tr("Truncate file error: %1").arg(error));
 				return;
 			}
-			m_bytesWritten += bytes_to_write;
-			uploadChunk();
+			m_remoteSize = m_sourceSize;
+			completeTransfer();
 		});
-		rpc_call->start();
-
+		return;
+	}
+	emit progress(chunkCnt(), chunkCnt());
+	auto done = [this](const QString &error) {
+		if (!error.isEmpty()) {
+			m_checkpoint.discard();
+			finish({}, error);
+			return;
+		}
+		m_isComplete = true;
+		m_checkpoint.remove();
+		finish({}, {});
+	};
+	if (isVerify()) {
+		verifyTransfer(m_checkpoint.sha1(), m_sourceSize, m_checkpoint.localReader(), done);
 	}
 	else {
-		emit progress(chunkCnt(), chunkCnt());
-		emit finished({}, {});
+		done({});
 	}
 }
 
+void FileUploader::writeChunk(qsizetype offset, qsizetype size, int attempt)
+{
+	shvDebug() << "write:" << offset << "size:" << size << "attempt:" << attempt;
+	auto sent_msec = m_transferTimer.elapsed();
+	// the only copy of chunk data before serialization, mapped pages are read on demand
+	RpcValue::Blob blob(m_source + offset, m_source + offset + size);
+	RpcValue::List params{{RpcValue(offset), blob}};
+	callShvMethod("write", params, [this, offset, size, attempt, sent_msec](const RpcValue &, const QString &error) {
+		if (!error.isEmpty()) {
+			if (attempt >= MAX_CHUNK_ATTEMPTS) {
+				finish({}, tr("Write file chunk error: %1").arg(error));
+				return;
+			}
+			shvWarning() << "Write file chunk at offset:" << offset << "error:" << error << "retrying";
+			m_window.chunkFailed();
+			m_retryChunks.push_back(Chunk{offset, size, attempt + 1});
+			requestChunks();
+			return;
+		}
+		m_bytesWritten += size;
+		m_checkpoint.confirm(offset, size);
+		m_window.chunkDone(m_transferTimer.elapsed() - sent_msec);
+		emit progress(static_cast<int>(m_bytesWritten / m_window.chunkSize()), chunkCnt());
+		emit transferProgress(m_bytesWritten, m_sourceSize, bytesPerSec(m_bytesWritten, m_transferTimer));
+		requestChunks();
+	});
+}
+
 int FileUploader::chunkCnt() const
 {
-	return static_cast<int>(m_data.size() / m_chunkSize) + 1;
+	return static_cast<int>(m_sourceSize / m_window.chunkSize()) + 1;
 }
 
 void FileUploader::start()
 {
-	auto rpc_call = shv::iotqt::rpc::RpcCall::create(m_connection)
-			->setShvPath(m_shvPath)
-			->setMethod("stat");
-	connect(rpc_call, &shv::iotqt::rpc::RpcCall::maybeResult, this, [this](const ::shv::chainpack::RpcValue &result, const shv::chainpack::RpcError &error) {
-		if (error.isValid()) {
-			emit finished({}, tr("Get file size error: %1").arg(QString::fromStdString(error.toString())));
+	if (!openSourceFile()) {
+		return;
+	}
+	callShvMethod("stat", {}, [this](const RpcValue &result, const QString &error) {
+		if (!error.isEmpty()) {
+			finish({}, tr("Get file size error: %1").arg(error));
 			return;
 		}
 		static constexpr int MAX_WRITE = 5;
-		m_chunkSize = result.asIMap().value(MAX_WRITE).toInt();
-		if (m_chunkSize <= 0) {
-			m_chunkSize = DEFAULT_CHUNK_SIZE;
+		qsizetype max_write = result.asIMap().value(MAX_WRITE).toInt();
+		// chunk size is given by the device, only number of writes in flight is adapted
+		m_window = TransferWindow(max_write > 0? max_write: DEFAULT_CHUNK_SIZE, max_write > 0? max_write: DEFAULT_CHUNK_SIZE);
+		static constexpr int SIZE = 1;
+		const auto remote_size = result.asIMap().value(SIZE).toInt64();
+		// data without local file cannot be identified after restart
+		m_checkpoint.setKey(m_sourceFileName.isEmpty()? QString(): checkpointKey(QStringLiteral("upload"), m_sourceFileName));
+		m_checkpoint.restore(m_sourceSize);
+		if (m_checkpoint.offset() > remote_size) {
+			shvInfo() << "Remote file is shorter than upload checkpoint, starting from zero:" << m_shvPath;
+			m_checkpoint.discard();
 		}
-		uploadChunk();
+		verifyCheckpoint(m_checkpoint, [this, remote_size]() {
+			if (!m_isDeltaMode) {
+				startWriting();
+				return;
+			}
+			m_remoteSize = remote_size;
+			callShvMethod(Rpc::METH_DIR, "sha1", [this](const RpcValue &dir_result, const QString &dir_error) {
+				m_isRemoteHashAvailable = dir_error.isEmpty() && isMethodPresent(dir_result, "sha1");
+				shvDebug() << "Delta upload, remote size:" << m_remoteSize << "remote hash:" << m_isRemoteHashAvailable;
+				startWriting();
+			});
+		});
 	});
-	rpc_call->start();
 }
 
+void FileUploader::startWriting()
+{
+	m_bytesWritten = m_checkpoint.offset();
+	m_compareOffset = m_bytesWritten;
+	// blocks present on both sides are compared first, the rest is written as is
+	m_compareEnd = std::max(m_compareOffset, std::min(m_remoteSize, m_sourceSize));
+	m_nextOffset = std::max(m_compareEnd, m_bytesWritten);
+	m_isStarted = true;
+	m_transferTimer.start();
+	requestChunks();
+}
+
+void FileUploader::compareBlock(qsizetype offset, qsizetype size)
+{
+	RpcValue::List params{offset, size};
+	if (m_isRemoteHashAvailable) {
+		callShvMethod("sha1", params, [this, offset, size](const RpcValue &result, const QString &error) {
+			if (!error.isEmpty() || !result.isBlob()) {
+				// cannot tell, write it
+				onBlockCompared(offset, size, false);
+				return;
+			}
+			const auto &blob = result.asBlob();
+			auto local = QCryptographicHash::hash(rawData(m_source + offset, size), QCryptographicHash::Sha1);
+			onBlockCompared(offset, size, static_cast<qsizetype>(blob.size()) == local.size() && std::memcmp(blob.data(), local.constData(), blob.size()) == 0);
+		});
+	}
+	else {
+		callShvMethod("read", params, [this, offset, size](const RpcValue &result, const QString &error) {
+			if (!error.isEmpty() || !result.isBlob()) {
+				onBlockCompared(offset, size, false);
+				return;
+			}
+			const auto &blob = result.asBlob();
+			onBlockCompared(offset, size, static_cast<qsizetype>(blob.size()) >= size && std::memcmp(blob.data(), m_source + offset, static_cast<size_t>(size)) == 0);
+		});
+	}
+}
+
+void FileUploader::onBlockCompared(qsizetype offset, qsizetype size, bool is_equal)
+{
+	if (is_equal) {
+		m_bytesWritten += size;
+		m_checkpoint.confirm(offset, size);
+		emit transferProgress(m_bytesWritten, m_sourceSize, bytesPerSec(m_bytesWritten, m_transferTimer));
+	}
+	else {
+		m_retryChunks.push_back(Chunk{offset, size, 1});
+	}
+	requestChunks();
+}
+
+void FileUploader::resumeTransfer()
+{
+	if (!m_isStarted) {
+		start();
+		return;
+	}
+	m_retryChunks.clear();
+	m_checkpoint.rewind();
+	m_bytesWritten = m_compareOffset = m_checkpoint.offset();
+	m_nextOffset = std::max(m_compareEnd, m_bytesWritten);
+	requestChunks();
+}
@@ -1,8 +1,44 @@
 #pragma once
 
+#include "mappedfile.h"
+#include "transfercheckpoint.h"
+
+#include <QElapsedTimer>
 #include <QObject>
 
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+class BandwidthLimiter;
+class QFile;
+class QThread;
+class QTimer;
+
 namespace shv::iotqt::rpc { class ClientConnection; }
+namespace shv::chainpack { class RpcValue; class RpcMessage; }
+
+/// Number of chunk requests kept in flight and their size, adapted to measured round trip time.
+/// Window grows while RTT stays near its minimum and shrinks when requests start to queue up.
+class TransferWindow
+{
+public:
+	TransferWindow(qsizetype chunk_size, qsizetype max_chunk_size);
+
+	int size() const {return m_size;}
+	qsizetype chunkSize() const {return m_chunkSize;}
+	void setMaxChunkSize(qsizetype n);
+
+	void chunkDone(int64_t rtt_msec);
+	void chunkFailed();
+private:
+	int m_size;
+	qsizetype m_chunkSize;
+	qsizetype m_maxChunkSize;
+	int64_t m_minRtt = -1;
+};
 
 class AbstractFileLoader : public QObject
 {
@@ -10,12 +46,85 @@ class AbstractFileLoader : public QObject
 public:
 	AbstractFileLoader(shv::iotqt::rpc::ClientConnection *conn, const QString &shv_path, QObject *parent);
 
+	virtual void start() = 0;
+
+	/// Cancels the transfer, pending requests are aborted on the peer and the loader is deleted later.
+	void abort();
+	/// Compare transferred data with the remote file before the transfer is reported as finished.
+	void setVerify(bool on) {m_isVerify = on;}
+	/// Limiter shared with other transfers, it must outlive the loader.
+	void setBandwidthLimiter(BandwidthLimiter *limiter) {m_bandwidthLimiter = limiter;}
+	/// Broker name is part of the checkpoint key, so the same path on other broker is never resumed.
+	void setBrokerName(const QString &name) {m_brokerName = name;}
+
+	/// dir(method) returns bool in SHV API 3 and method description in SHV API 2,
+	/// description has to name the method, so an unrelated dir result is not taken as presence.
+	static bool isMethodPresent(const shv::chainpack::RpcValue &dir_result, const std::string &method);
+
 	Q_SIGNAL void progress(int n, int of);
+	/// Confirmed bytes, total bytes and average transfer rate since start.
+	Q_SIGNAL void transferProgress(qint64 bytes, qint64 total, qint64 bytes_per_sec);
+	/// Transfer waits for broker reconnect.
+	Q_SIGNAL void suspendedChanged(bool is_suspended);
+	Q_SIGNAL void verificationStarted();
 	Q_SIGNAL void finished(QByteArray data, QString error);
+protected:
+	struct Chunk
+	{
+		qsizetype offset = 0;
+		qsizetype size = 0;
+		int attempt = 1;
+	};
+
+	using ResponseHandler = std::function<void (const shv::chainpack::RpcValue &result, const QString &error)>;
+	int callShvMethod(const std::string &method, const shv::chainpack::RpcValue &params, ResponseHandler &&handler);
+	void finish(const QByteArray &data, const QString &error);
+	size_t pendingCallCount() const {return m_pendingCalls.size();}
+	bool isAborted() const {return m_isAborted;}
+	bool isFinished() const {return m_isFinished;}
+	bool isSuspended() const {return m_isSuspended;}
+	bool isVerify() const {return m_isVerify;}
+
+	using VerifyHandler = std::function<void (const QString &error)>;
+	/// Uses remote sha1 method when available, otherwise compares sampled ranges of the file.
+	void verifyTransfer(const QByteArray &local_sha1, qint64 file_size, const TransferCheckpoint::LocalReader &reader, VerifyHandler &&handler);
+	/// Persistent checkpoint key of transfer between this broker path and local file.
+	QString checkpointKey(const QString &direction, const QString &local_file_name) const;
+	/// Compares restored checkpoint prefix with the remote file and discards checkpoint when they differ.
+	void verifyCheckpoint(TransferCheckpoint &checkpoint, std::function<void ()> &&done);
+	/// Called when broker is connected again, pending calls lost with the connection are forgotten already.
+	virtual void resumeTransfer() = 0;
+	/// Fills the window of chunk requests in flight.
+	virtual void requestChunks() = 0;
+	/// Returns false when the bandwidth cap is reached, requestChunks() is called again later then.
+	bool acquireBandwidth(qsizetype bytes);
+private:
+	void onBrokerConnectedChanged(bool is_connected);
+	void onRpcMessageReceived(const shv::chainpack::RpcMessage &msg);
+	void checkPendingCallsTimeout();
+	void abortPendingCalls();
+	void compareWithRemote(const QByteArray &local_sha1, qint64 size, const TransferCheckpoint::LocalReader &reader, VerifyHandler &&handler);
+	void verifySampledRanges(qint64 file_size, const TransferCheckpoint::LocalReader &reader, VerifyHandler &&handler);
 protected:
 	shv::iotqt::rpc::ClientConnection *m_connection = nullptr;
 	QString m_shvPath;
 	QByteArray m_data;
+private:
+	struct PendingCall
+	{
+		std::string method;
+		ResponseHandler handler;
+		QElapsedTimer lastActivity;
+	};
+	std::map<int, PendingCall> m_pendingCalls;
+	QTimer *m_timeoutTimer = nullptr;
+	QTimer *m_throttleTimer = nullptr;
+	BandwidthLimiter *m_bandwidthLimiter = nullptr;
+	QString m_brokerName;
+	bool m_isFinished = false;
+	bool m_isAborted = false;
+	bool m_isSuspended = false;
+	bool m_isVerify = false;
 };
 
 class FileDownloader : public AbstractFileLoader
@@ -25,12 +134,47 @@ class FileDownloader : public AbstractFileLoader
 	using Super = AbstractFileLoader;
 public:
 	FileDownloader(shv::iotqt::rpc::ClientConnection *conn, const QString &shv_path, QObject *parent);
-	void start();
+	~FileDownloader() override;
+
+	/// Write chunks directly to file_name instead of collecting them in memory,
+	/// finished() is emitted with empty data then. Incomplete file is removed on abort,
+	/// after error it is truncated to confirmed bytes and kept with checkpoint, so next download to the same file continues.
+	void setTargetFile(const QString &file_name) {m_targetFileName = file_name;}
+	void start() override;
+protected:
+	void resumeTransfer() override;
+	void requestChunks() override;
 private:
-	void downloadChunk();
+	bool openTargetFile();
+	bool resetTargetFile();
+	void completeTransfer();
+	bool storeChunk(qsizetype offset, const uint8_t *data, qsizetype size);
+	QByteArray loadChunk(qint64 offset, qint64 size) const;
+	void readChunk(qsizetype offset, qsizetype size, int attempt);
+	bool processChunk(qsizetype offset, qsizetype size, int attempt, const uint8_t *data, qsizetype data_size);
+	void startDecompressThread();
+	void decompressChunk(qsizetype offset, qsizetype size, int attempt, const QByteArray &compressed);
+	void fallBackToPlainRead(qsizetype offset, qsizetype size, int attempt, const QString &error);
 	int chunkCnt() const;
 private:
-	qsizetype m_fileSize = 0;
+	qsizetype m_fileSize = -1;
+	qsizetype m_nextOffset = 0;
+	qsizetype m_receivedBytes = 0;
+	// failed chunks and parts of chunks the device did not return, read again before continuing
+	std::vector<Chunk> m_retryChunks;
+	TransferCheckpoint m_checkpoint;
+	TransferWindow m_window;
+	QElapsedTimer m_transferTimer;
+	QString m_targetFileName;
+	QFile *m_targetFile = nullptr;
+	bool m_targetFileComplete = false;
+	// compressed chunks are inflated in order on this thread, it exists only when device offers compressed read
+	QThread *m_decompressThread = nullptr;
+	QObject *m_decompressWorker = nullptr;
+	// set when dir probe finds compressed read, cleared on its first failure
+	bool m_useCompressedRead = false;
+	int m_decompressingCount = 0;
+	int m_transferGeneration = 0;
 };
 
 class FileUploader : public AbstractFileLoader
@@ -39,13 +183,46 @@ class FileUploader : public AbstractFileLoader
 
 	using Super = AbstractFileLoader;
 public:
+	/// Upload of data without local file is not resumed after restart.
 	FileUploader(shv::iotqt::rpc::ClientConnection *conn, const QString &shv_path, QByteArray data, QObject *parent);
-	void start();
+	/// Uploads local file, which is memory mapped on start when file system supports it, so it does not have to fit in memory.
+	FileUploader(shv::iotqt::rpc::ClientConnection *conn, const QString &shv_path, const QString &local_file_name, QObject *parent);
+	~FileUploader() override;
+
+	/// Compare blocks of the local file with the remote one first and write only blocks that differ.
+	void setDeltaMode(bool on) {m_isDeltaMode = on;}
+	void start() override;
+protected:
+	void resumeTransfer() override;
+	void requestChunks() override;
 private:
+	bool openSourceFile();
+	void startWriting();
+	void completeTransfer();
 	int chunkCnt() const;
-	void uploadChunk();
+	void compareBlock(qsizetype offset, qsizetype size);
+	void onBlockCompared(qsizetype offset, qsizetype size, bool is_equal);
+	void writeChunk(qsizetype offset, qsizetype size, int attempt);
 private:
+	QString m_sourceFileName;
+	/// Closed as soon as transfer finishes, loader itself is deleted later.
+	MappedFile m_sourceFile;
+	// points to m_data or to the source file data
+	const char *m_source = nullptr;
+	qsizetype m_sourceSize = 0;
+	bool m_isStarted = false;
+	bool m_isComplete = false;
+	qsizetype m_nextOffset = 0;
 	qsizetype m_bytesWritten = 0;
-	qsizetype m_chunkSize = 0;
+	// failed chunks and changed blocks found in delta mode, waiting to be written
+	std::vector<Chunk> m_retryChunks;
+	bool m_isDeltaMode = false;
+	// remote sha1 method is used to compare blocks, otherwise remote block is read
+	bool m_isRemoteHashAvailable = false;
+	qsizetype m_remoteSize = -1;
+	qsizetype m_compareOffset = 0;
+	qsizetype m_compareEnd = 0;
+	TransferCheckpoint m_checkpoint;
+	TransferWindow m_window;
+	QElapsedTimer m_transferTimer;
 };
-
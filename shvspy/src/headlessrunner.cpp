@@ -0,0 +1,418 @@
+#include "headlessrunner.h"
+#include "appclioptions.h"
+#include "batchcallrunner.h"
+#include "brokerconnection.h"
+#include "brokerproperty.h"
+#include "theapp.h"
+
+#include <shv/chainpack/rpc.h>
+#include <shv/chainpack/rpcmessage.h>
+#include <shv/core/utils.h>
+#include <shv/coreqt/log.h>
+#include <shv/coreqt/utils.h>
+#include <shv/iotqt/rpc/clientconnection.h>
+#include <shv/iotqt/rpc/rpccall.h>
+#include <shv/iotqt/rpc/socket.h>
+
+#include <QFile>
+#include <QSettings>
+#include <QUrl>
+
+#include <algorithm>
+#include <iostream>
+
+namespace cp = shv::chainpack;
+
+namespace {
+// broker is reconnected forever by client connection, cron job must not hang
+constexpr int CONNECT_TIMEOUT_MSEC = 30 * 1000;
+constexpr int SUBSCRIPTION_RESPONSE_TIMEOUT_MSEC = 5000;
+constexpr int DEFAULT_SUBSCRIPTION_DURATION_MSEC = 10 * 1000;
+constexpr int DEFAULT_CRAWL_DEPTH = 16;
+
+const auto CMD_CALL = "call";
+const auto CMD_SUBSCRIBE = "subscribe";
+const auto CMD_CRAWL = "crawl";
+
+bool is_broker_scheme(const QString &scheme)
+{
+	// unknown scheme is parsed as default one, so it does not survive round trip
+	using shv::iotqt::rpc::Socket;
+	const auto s = scheme.toStdString();
+	return !s.empty() && Socket::schemeToString(Socket::schemeFromString(s)) == s;
+}
+}
+
+HeadlessRunner::HeadlessRunner(AppCliOptions *cli_opts, QObject *parent)
+	: Super(parent)
+	, m_cliOptions(cli_opts)
+	, m_concurrency(BatchCallRunner::DEFAULT_CONCURRENCY)
+{
+	m_connectTimer.setSingleShot(true);
+	m_connectTimer.setInterval(CONNECT_TIMEOUT_MSEC);
+	connect(&m_connectTimer, &QTimer::timeout, this, [this]() {
+		fail("Cannot connect to broker in " + std::to_string(CONNECT_TIMEOUT_MSEC / 1000) + " seconds.");
+	});
+	m_subscriptionTimer.setSingleShot(true);
+	connect(&m_subscriptionTimer, &QTimer::timeout, this, [this]() {
+		const auto &cmd = m_commands[m_nextCommand - 1];
+		m_isSubscribed = false;
+		m_connection->callMethodUnsubscribe(cmd.shvPath, cmd.method, cmd.source);
+		runNextCommand();
+	});
+}
+
+HeadlessRunner::~HeadlessRunner()
+{
+	if (m_connection) {
+		disconnect(m_connection, nullptr, this, nullptr);
+		delete m_connection;
+	}
+}
+
+bool HeadlessRunner::start(const QString &script_file)
+{
+	const auto format = m_cliOptions->batchOutputFormat();
+	if (format == "chainpack") {
+		m_outputFormat = OutputFormat::ChainPack;
+	}
+	else if (format != "cpon") {
+		shvError() << "Invalid batch output format:" << format;
+		return false;
+	}
+	std::string err;
+	if (!loadScript(script_file, err)) {
+		shvError() << "Invalid batch script" << script_file << "error:" << err;
+		return false;
+	}
+	const auto props = connectionProperties(m_connectionName, err);
+	if (!err.empty()) {
+		shvError() << err;
+		return false;
+	}
+	if (props.value(brokerProperty::AZURELOGIN).toBool()) {
+		shvError() << "Azure login needs browser, it is not supported in batch mode.";
+		return false;
+	}
+	// script paths are relative to shv root of connection like paths in server tree
+	const auto shv_root = props.value(brokerProperty::SHVROOT).toString().toStdString();
+	if (!shv_root.empty()) {
+		for (auto &cmd : m_commands) {
+			cmd.shvPath = shv::core::utils::joinPath(shv_root, cmd.shvPath);
+		}
+	}
+
+	m_connection = brokerConnection::create(props, m_cliOptions->isRawRpcMessageLog());
+	brokerConnection::configure(m_connection, props);
+	connect(m_connection, &shv::iotqt::rpc::ClientConnection::brokerConnectedChanged, this, &HeadlessRunner::onBrokerConnectedChanged);
+	connect(m_connection, &shv::iotqt::rpc::ClientConnection::rpcMessageReceived, this, &HeadlessRunner::onRpcMessageReceived);
+	connect(m_connection, &shv::iotqt::rpc::ClientConnection::brokerLoginError, this, [this](const cp::RpcError &error) {
+		fail("Login error: " + error.toString());
+	});
+	m_callRunner = new BatchCallRunner(m_connection, this);
+	connect(m_callRunner, &BatchCallRunner::callChanged, this, [this](int index) {
+		const auto &call = m_callRunner->calls()[static_cast<size_t>(index)];
+		if (call.status == BatchCallRunner::Status::Failed) {
+			m_exitCode = EXIT_COMMAND_FAILED;
+		}
+		if (call.status == BatchCallRunner::Status::Finished || call.status == BatchCallRunner::Status::Failed) {
+			write(BatchCallRunner::callToRpcValue(call));
+		}
+	});
+	connect(m_callRunner, &BatchCallRunner::finished, this, [this]() {
+		if (!m_callRunner->error().empty()) {
+			fail(m_callRunner->error());
+			return;
+		}
+		runNextCommand();
+	});
+	m_connectTimer.start();
+	m_connection->open();
+	return true;
+}
+
+bool HeadlessRunner::loadScript(const QString &file_name, std::string &err)
+{
+	QFile f(file_name);
+	if (!f.open(QFile::ReadOnly)) {
+		err = f.errorString().toStdString();
+		return false;
+	}
+	const auto script = cp::RpcValue::fromCpon(f.readAll().toStdString(), &err);
+	if (!err.empty()) {
+		return false;
+	}
+	const auto &map = script.asMap();
+	m_connectionName = QString::fromStdString(map.valref("connection").asString());
+	if (auto v = map.value("concurrency"); v.isValid()) {
+		m_concurrency = std::max(v.toInt(), 1);
+	}
+	const auto &commands = map.valref("commands").asList();
+	if (commands.empty()) {
+		err = "Script must be map with non-empty 'commands' list.";
+		return false;
+	}
+	for (const auto &rv : commands) {
+		// commands are written as lists for brevity, maps are accepted as well
+		std::string type;
+		cp::RpcValue::List args;
+		if (rv.isList() && !rv.asList().empty()) {
+			type = rv.asList().front().asString();
+			args.assign(rv.asList().begin() + 1, rv.asList().end());
+		}
+		else if (rv.isMap()) {
+			const auto &m = rv.asMap();
+			type = m.valref("cmd").asString();
+			if (type == CMD_CALL) {
+				args = cp::RpcValue::List{m.value("path"), m.value("method"), m.value("params")};
+			}
+			else if (type == CMD_SUBSCRIBE) {
+				args = cp::RpcValue::List{m.value("path"), m.value("signal"), m.value("source"), m.value("duration")};
+			}
+			else if (type == CMD_CRAWL) {
+				args = cp::RpcValue::List{m.value("path"), m.value("depth")};
+			}
+		}
+		Command cmd;
+		cmd.shvPath = args.valref(0).asString();
+		if (type == CMD_CALL) {
+			cmd.type = Command::Type::Call;
+			cmd.method = args.valref(1).asString();
+			cmd.params = args.value(2);
+			if (cmd.method.empty()) {
+				err = "Call without method: " + rv.toCpon();
+				return false;
+			}
+		}
+		else if (type == CMD_SUBSCRIBE) {
+			cmd.type = Command::Type::Subscribe;
+			cmd.method = args.valref(1).asString();
+			if (cmd.method.empty()) {
+				cmd.method = cp::Rpc::SIG_VAL_CHANGED;
+			}
+			cmd.source = args.valref(2).asString();
+			cmd.durationMsec = args.valref(3).isValid()? args.valref(3).toInt(): DEFAULT_SUBSCRIPTION_DURATION_MSEC;
+		}
+		else if (type == CMD_CRAWL) {
+			cmd.type = Command::Type::Crawl;
+			cmd.depth = args.valref(1).isValid()? args.valref(1).toInt(): DEFAULT_CRAWL_DEPTH;
+		}
+		else {
+			err = "Invalid command: " + rv.toCpon();
+			return false;
+		}
+		m_commands.push_back(std::move(cmd));
+	}
+	return true;
+}
+
+QVariantMap HeadlessRunner::connectionProperties(const QString &connection, std::string &err) const
+{
+	auto conn = connection;
+	if (conn.isEmpty()) {
+		conn = QString::fromStdString(m_cliOptions->connections()).section(',', 0, 0).trimmed();
+	}
+	if (conn.isEmpty()) {
+		err = "Batch script does not specify connection and --connections is not set.";
+		return {};
+	}
+	// connection saved in GUI goes first, its name can contain ':' as well,
+	// server tree model keeps them in the same way
+	const auto servers_json = QSettings().value("application/servers").toString().toStdString();
+	std::string servers_err;
+	cp::RpcValue servers;
+	if (!servers_json.empty()) {
+		servers = cp::RpcValue::fromCpon(servers_json, &servers_err);
+	}
+	for (const auto &rv : servers.asList()) {
+		QVariantMap m = shv::coreqt::Utils::rpcValueToQVariant(rv).toMap();
+		if (m.value(brokerProperty::NAME).toString() == conn) {
+			m[brokerProperty::PASSWORD] = QString::fromStdString(TheApp::crypt().decrypt(m.value(brokerProperty::PASSWORD).toString().toStdString()));
+			return m;
+		}
+	}
+	QUrl url(QUrl::fromPercentEncoding(conn.toUtf8()));
+	if (url.isValid() && is_broker_scheme(url.scheme())) {
+		return brokerConnection::propertiesFromUrl(url);
+	}
+	if (!servers_err.empty()) {
+		err = "Cannot parse saved connections: " + servers_err;
+		return {};
+	}
+	err = "Connection is neither saved connection name nor broker url: " + conn.toStdString();
+	return {};
+}
+
+void HeadlessRunner::onBrokerConnectedChanged(bool is_connected)
+{
+	if (!is_connected) {
+		if (m_isRunning) {
+			fail("Broker connection lost.");
+		}
+		return;
+	}
+	m_connectTimer.stop();
+	if (m_isRunning) {
+		return;
+	}
+	m_isRunning = true;
+	brokerConnection::checkShvApiVersion(m_connection, this, [this]() {
+		runNextCommand();
+	}, [this](const cp::RpcError &error) {
+		fail("SHV API version discovery error: " + error.toString());
+	});
+}
+
+void HeadlessRunner::onRpcMessageReceived(const cp::RpcMessage &msg)
+{
+	if (!m_isSubscribed || !msg.isSignal()) {
+		return;
+	}
+	cp::RpcSignal ntf(msg);
+	cp::RpcValue::Map map;
+	map["path"] = ntf.shvPath().toString();
+	map["signal"] = ntf.signal();
+	map["source"] = ntf.source();
+	map["params"] = ntf.params();
+	map["time"] = cp::RpcValue::DateTime::now();
+	write(map);
+}
+
+void HeadlessRunner::runNextCommand()
+{
+	if (m_isFinished) {
+		return;
+	}
+	if (m_nextCommand >= m_commands.size()) {
+		finish(m_exitCode);
+		return;
+	}
+	const auto &cmd = m_commands[m_nextCommand];
+	switch (cmd.type) {
+	case Command::Type::Call: {
+		// consecutive calls run as one batch, so they share concurrency window
+		auto end = m_nextCommand;
+		while (end < m_commands.size() && m_commands[end].type == Command::Type::Call) {
+			end++;
+		}
+		runCalls(end);
+		break;
+	}
+	case Command::Type::Subscribe:
+		m_nextCommand++;
+		runSubscribe(cmd);
+		break;
+	case Command::Type::Crawl:
+		m_nextCommand++;
+		m_crawlMaxDepth = cmd.depth;
+		m_crawlQueue.push_back(CrawlNode{cmd.shvPath, 0});
+		crawlNext();
+		break;
+	}
+}
+
+void HeadlessRunner::runCalls(size_t end)
+{
+	cp::RpcValue::List calls;
+	for (; m_nextCommand < end; ++m_nextCommand) {
+		const auto &cmd = m_commands[m_nextCommand];
+		calls.push_back(cp::RpcValue::List{cmd.shvPath, cmd.method, cmd.params});
+	}
+	std::string err;
+	if (!m_callRunner->start(calls, m_concurrency, err)) {
+		fail(err);
+	}
+}
+
+void HeadlessRunner::runSubscribe(const Command &cmd)
+{
+	const int rqid = m_connection->callMethodSubscribe(cmd.shvPath, cmd.method, cmd.source);
+	auto *cb = new shv::iotqt::rpc::RpcResponseCallBack(m_connection, rqid, this);
+	cb->start(SUBSCRIPTION_RESPONSE_TIMEOUT_MSEC, this, [this, cmd](const cp::RpcResponse &resp) {
+		if (resp.isError()) {
+			cp::RpcValue::Map map;
+			map["path"] = cmd.shvPath;
+			map["signal"] = cmd.method;
+			map["error"] = resp.error().toString();
+			write(map);
+			m_exitCode = EXIT_COMMAND_FAILED;
+			runNextCommand();
+			return;
+		}
+		m_isSubscribed = true;
+		m_subscriptionTimer.start(cmd.durationMsec);
+	});
+}
+
+void HeadlessRunner::crawlNext()
+{
+	while (m_runningCrawlCalls < m_concurrency && !m_crawlQueue.empty()) {
+		auto node = std::move(m_crawlQueue.front());
+		m_crawlQueue.pop_front();
+		m_runningCrawlCalls++;
+		auto *rpc_call = shv::iotqt::rpc::RpcCall::create(m_connection)->setShvPath(node.shvPath)->setMethod(cp::Rpc::METH_LS);
+		connect(rpc_call, &shv::iotqt::rpc::RpcCall::maybeResult, this, [this, node](const cp::RpcValue &result, const cp::RpcError &error) {
+			m_runningCrawlCalls--;
+			cp::RpcValue::Map map;
+			map["path"] = node.shvPath;
+			if (error.isValid()) {
+				map["error"] = error.toString();
+				m_exitCode = EXIT_COMMAND_FAILED;
+			}
+			else {
+				cp::RpcValue::List children;
+				for (const auto &child : result.asList()) {
+					// ls of SHV API v2 can return [name, has_children] pairs
+					const auto &name = child.isList()? child.asList().valref(0).asString(): child.asString();
+					children.push_back(name);
+					if (node.depth < m_crawlMaxDepth) {
+						m_crawlQueue.push_back(CrawlNode{shv::core::utils::joinPath(node.shvPath, name), node.depth + 1});
+					}
+				}
+				map["children"] = children;
+			}
+			write(map);
+			crawlNext();
+		});
+		rpc_call->start();
+	}
+	if (m_runningCrawlCalls == 0 && m_crawlQueue.empty()) {
+		runNextCommand();
+	}
+}
+
+void HeadlessRunner::write(const cp::RpcValue &value)
+{
+	if (m_outputFormat == OutputFormat::ChainPack) {
+		const auto data = value.toChainPack();
+		std::cout.write(data.data(), static_cast<std::streamsize>(data.size()));
+	}
+	else {
+		std::cout << value.toCpon() << '\n';
+	}
+	std::cout.flush();
+}
+
+void HeadlessRunner::fail(const std::string &err)
+{
+	shvError() << err;
+	finish(EXIT_FAILURE);
+}
+
+void HeadlessRunner::finish(int exit_code)
+{
+	if (m_isFinished) {
+		return;
+	}
+	m_isFinished = true;
+	m_connectTimer.stop();
+	m_subscriptionTimer.stop();
+	m_isRunning = false;
+	if (m_callRunner) {
+		m_callRunner->abort();
+	}
+	if (m_connection) {
+		m_connection->close();
+	}
+	emit finished(exit_code);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <shv/chainpack/rpcvalue.h>
+
+#include <QObject>
+#include <QTimer>
+#include <QVariantMap>
+
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace shv::chainpack { class RpcMessage; }
+namespace shv::iotqt::rpc { class ClientConnection; }
+
+class AppCliOptions;
+class BatchCallRunner;
+
+/// Runs script of call, subscribe and crawl commands without GUI and writes results to stdout.
+/// Connection is set up from broker properties like broker node in server tree, so saved connections,
+/// login types and SHV API version detection behave the same as in GUI.
+class HeadlessRunner : public QObject
+{
+	Q_OBJECT
+
+	using Super = QObject;
+public:
+	enum class OutputFormat {Cpon, ChainPack};
+
+	explicit HeadlessRunner(AppCliOptions *cli_opts, QObject *parent = nullptr);
+	~HeadlessRunner() override;
+
+	/// Loads script and opens connection, returns false when script or connection settings are invalid.
+	bool start(const QString &script_file);
+
+	/// Exit code is EXIT_SUCCESS, EXIT_FAILURE for script or connection error
+	/// or EXIT_COMMAND_FAILED when some command failed.
+	Q_SIGNAL void finished(int exit_code);
+
+	static constexpr int EXIT_COMMAND_FAILED = 2;
+private:
+	struct Command
+	{
+		enum class Type {Call, Subscribe, Crawl};
+		Type type = Type::Call;
+		std::string shvPath;
+		/// Method of call or signal of subscription.
+		std::string method;
+		shv::chainpack::RpcValue params;
+		std::string source;
+		int durationMsec = 0;
+		int depth = 0;
+	};
+	struct CrawlNode
+	{
+		std::string shvPath;
+		int depth;
+	};
+
+	bool loadScript(const QString &file_name, std::string &err);
+	QVariantMap connectionProperties(const QString &connection, std::string &err) const;
+	void onBrokerConnectedChanged(bool is_connected);
+	void onRpcMessageReceived(const shv::chainpack::RpcMessage &msg);
+	void runNextCommand();
+	void runCalls(size_t end);
+	void runSubscribe(const Command &cmd);
+	void crawlNext();
+	void write(const shv::chainpack::RpcValue &value);
+	void fail(const std::string &err);
+	void finish(int exit_code);
+private:
+	AppCliOptions *m_cliOptions;
+	OutputFormat m_outputFormat = OutputFormat::Cpon;
+	QString m_connectionName;
+	int m_concurrency;
+	std::vector<Command> m_commands;
+	size_t m_nextCommand = 0;
+	bool m_isRunning = false;
+	bool m_isFinished = false;
+	int m_exitCode = EXIT_SUCCESS;
+	shv::iotqt::rpc::ClientConnection *m_connection = nullptr;
+	BatchCallRunner *m_callRunner = nullptr;
+	QTimer m_connectTimer;
+	QTimer m_subscriptionTimer;
+	bool m_isSubscribed = false;
+	std::deque<CrawlNode> m_crawlQueue;
+	int m_crawlMaxDepth = 0;
+	int m_runningCrawlCalls = 0;
+};
@@ -0,0 +1,213 @@
+#include "hexview.h"
+#include "bytesearch.h"
+
+#include <QFontDatabase>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+constexpr int BYTES_PER_LINE = 16;
+// "xx " per byte plus extra space between line halves
+constexpr int HEX_COLUMN_CHARS = BYTES_PER_LINE * 3 + 1;
+constexpr auto HEX_DIGITS = "0123456789abcdef";
+
+int hex_column(int byte_ix)
+{
+	return byte_ix * 3 + (byte_ix >= BYTES_PER_LINE / 2? 1: 0);
+}
+}
+
+HexView::HexView(QWidget *parent)
+	: Super(parent)
+{
+	setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+	setFocusPolicy(Qt::StrongFocus);
+}
+
+void HexView::reset()
+{
+	m_file.close();
+	m_data.clear();
+	m_bytes = nullptr;
+	m_size = 0;
+	m_errorString.clear();
+	m_selectionStart = -1;
+	m_selectionSize = 0;
+}
+
+void HexView::setData(const QByteArray &data)
+{
+	reset();
+	m_data = data;
+	m_bytes = reinterpret_cast<const uchar*>(m_data.constData());
+	m_size = m_data.size();
+	verticalScrollBar()->setValue(0);
+	updateScrollBars();
+	viewport()->update();
+}
+
+bool HexView::setFile(const QString &file_name)
+{
+	reset();
+	if (!m_file.open(file_name)) {
+		m_errorString = m_file.errorString();
+		return false;
+	}
+	m_bytes = reinterpret_cast<const uchar*>(m_file.data());
+	m_size = m_file.size();
+	verticalScrollBar()->setValue(0);
+	updateScrollBars();
+	viewport()->update();
+	return true;
+}
+
+QByteArray HexView::data() const
+{
+	if (!m_data.isEmpty()) {
+		return m_data;
+	}
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+	return QByteArray::fromRawData(reinterpret_cast<const char*>(m_bytes), static_cast<int>(m_size));
+#else
+	return QByteArray::fromRawData(reinterpret_cast<const char*>(m_bytes), m_size);
+#endif
+}
+
+qint64 HexView::find(const QByteArray &pattern, qint64 from) const
+{
+	return byteSearch::find(reinterpret_cast<const char*>(m_bytes), m_size, pattern, from);
+}
+
+qint64 HexView::findBackward(const QByteArray &pattern, qint64 from) const
+{
+	return byteSearch::findBackward(reinterpret_cast<const char*>(m_bytes), m_size, pattern, from);
+}
+
+void HexView::setSelection(qint64 offset, qint64 size)
+{
+	m_selectionStart = offset;
+	m_selectionSize = offset < 0? 0: size;
+	if (offset >= 0) {
+		auto *sb = verticalScrollBar();
+		auto line = offset / BYTES_PER_LINE;
+		if (line < sb->value() || line >= sb->value() + sb->pageStep()) {
+			sb->setValue(static_cast<int>(std::min<qint64>(std::max<qint64>(line - sb->pageStep() / 2, 0), sb->maximum())));
+		}
+	}
+	viewport()->update();
+}
+
+qint64 HexView::lineCount() const
+{
+	return (m_size + BYTES_PER_LINE - 1) / BYTES_PER_LINE;
+}
+
+int HexView::addressDigits() const
+{
+	return m_size > std::numeric_limits<quint32>::max()? 16: 8;
+}
+
+int HexView::lineChars() const
+{
+	return addressDigits() + 2 + HEX_COLUMN_CHARS + 1 + BYTES_PER_LINE;
+}
+
+void HexView::updateScrollBars()
+{
+	QFontMetrics fm(font());
+	auto page = std::max(viewport()->height() / fm.height(), 1);
+	auto lines = std::min<qint64>(lineCount(), std::numeric_limits<int>::max());
+	verticalScrollBar()->setRange(0, std::max(static_cast<int>(lines) - page, 0));
+	verticalScrollBar()->setPageStep(page);
+	auto width = lineChars() * fm.horizontalAdvance(QLatin1Char('0'));
+	horizontalScrollBar()->setRange(0, std::max(width - viewport()->width(), 0));
+	horizontalScrollBar()->setPageStep(viewport()->width());
+}
+
+void HexView::resizeEvent(QResizeEvent *event)
+{
+	Super::resizeEvent(event);
+	updateScrollBars();
+}
+
+void HexView::paintEvent(QPaintEvent *event)
+{
+	Q_UNUSED(event)
+	QPainter painter(viewport());
+	QFontMetrics fm(font());
+	const int line_height = fm.height();
+	const int char_width = fm.horizontalAdvance(QLatin1Char('0'));
+	const int addr_digits = addressDigits();
+	const int hex_start = addr_digits + 2;
+	const int ascii_start = hex_start + HEX_COLUMN_CHARS + 1;
+	const qint64 selection_end = m_selectionStart + m_selectionSize;
+
+	painter.translate(-horizontalScrollBar()->value(), 0);
+	const qint64 first_line = verticalScrollBar()->value();
+	const int visible_lines = viewport()->height() / line_height + 1;
+	QString line(lineChars(), QLatin1Char(' '));
+	for (int i = 0; i < visible_lines; ++i) {
+		const qint64 line_offset = (first_line + i) * BYTES_PER_LINE;
+		if (line_offset >= m_size) {
+			break;
+		}
+		const int n = static_cast<int>(std::min<qint64>(BYTES_PER_LINE, m_size - line_offset));
+		const int y = i * line_height;
+		line.fill(QLatin1Char(' '));
+		auto addr = line_offset;
+		for (int j = addr_digits - 1; j >= 0; --j) {
+			line[j] = QLatin1Char(HEX_DIGITS[addr & 0xf]);
+			addr >>= 4;
+		}
+		for (int j = 0; j < n; ++j) {
+			const uchar b = m_bytes[line_offset + j];
+			const int col = hex_start + hex_column(j);
+			line[col] = QLatin1Char(HEX_DIGITS[b >> 4]);
+			line[col + 1] = QLatin1Char(HEX_DIGITS[b & 0xf]);
+			line[ascii_start + j] = (b >= 0x20 && b < 0x7f)? QLatin1Char(static_cast<char>(b)): QLatin1Char('.');
+			if (line_offset + j >= m_selectionStart && line_offset + j < selection_end) {
+				painter.fillRect(col * char_width, y, 2 * char_width, line_height, palette().highlight());
+				painter.fillRect((ascii_start + j) * char_width, y, char_width, line_height, palette().highlight());
+			}
+		}
+		painter.drawText(0, y + fm.ascent(), line);
+	}
+}
+
+qint64 HexView::offsetAt(const QPoint &pos) const
+{
+	QFontMetrics fm(font());
+	const int col = (pos.x() + horizontalScrollBar()->value()) / fm.horizontalAdvance(QLatin1Char('0'));
+	const qint64 line = verticalScrollBar()->value() + pos.y() / fm.height();
+	const int hex_start = addressDigits() + 2;
+	const int ascii_start = hex_start + HEX_COLUMN_CHARS + 1;
+	int byte_ix = -1;
+	if (col >= ascii_start && col < ascii_start + BYTES_PER_LINE) {
+		byte_ix = col - ascii_start;
+	}
+	else if (col >= hex_start && col < hex_start + HEX_COLUMN_CHARS) {
+		auto rel = col - hex_start;
+		if (rel >= hex_column(BYTES_PER_LINE / 2)) {
+			rel--;
+		}
+		byte_ix = std::min(rel / 3, BYTES_PER_LINE - 1);
+	}
+	if (byte_ix < 0) {
+		return -1;
+	}
+	auto offset = line * BYTES_PER_LINE + byte_ix;
+	return offset < m_size? offset: -1;
+}
+
+void HexView::mousePressEvent(QMouseEvent *event)
+{
+	if (event->button() == Qt::LeftButton) {
+		auto offset = offsetAt(event->pos());
+		setSelection(offset, 1);
+	}
+	Super::mousePressEvent(event);
+}
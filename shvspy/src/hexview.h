@@ -0,0 +1,54 @@
+#pragma once
+
+#include "mappedfile.h"
+
+#include <QAbstractScrollArea>
+#include <QByteArray>
+
+/// Hex and ASCII view of binary data. Only visible lines are painted,
+/// so blobs of hundreds of MB held in memory or mapped from file open instantly.
+class HexView : public QAbstractScrollArea
+{
+	Q_OBJECT
+
+	using Super = QAbstractScrollArea;
+public:
+	explicit HexView(QWidget *parent = nullptr);
+
+	void setData(const QByteArray &data);
+	bool setFile(const QString &file_name);
+	QString errorString() const {return m_errorString;}
+
+	qint64 size() const {return m_size;}
+	/// Data is not copied, it is valid as long as the view.
+	QByteArray data() const;
+
+	/// Returns offset of the first pattern occurrence at or after from, or -1.
+	qint64 find(const QByteArray &pattern, qint64 from) const;
+	/// Returns offset of the last pattern occurrence before from, or -1.
+	qint64 findBackward(const QByteArray &pattern, qint64 from) const;
+
+	qint64 selectionStart() const {return m_selectionStart;}
+	qint64 selectionSize() const {return m_selectionSize;}
+	void setSelection(qint64 offset, qint64 size);
+	void clearSelection() {setSelection(-1, 0);}
+protected:
+	void paintEvent(QPaintEvent *event) override;
+	void resizeEvent(QResizeEvent *event) override;
+	void mousePressEvent(QMouseEvent *event) override;
+private:
+	void reset();
+	void updateScrollBars();
+	qint64 lineCount() const;
+	int addressDigits() const;
+	int lineChars() const;
+	qint64 offsetAt(const QPoint &pos) const;
+private:
+	QByteArray m_data;
+	MappedFile m_file;
+	const uchar *m_bytes = nullptr;
+	qint64 m_size = 0;
+	QString m_errorString;
+	qint64 m_selectionStart = -1;
+	qint64 m_selectionSize = 0;
+};
@@ -2,6 +2,7 @@
 #include "theapp.h"
 #include "appversion.h"
 #include "appclioptions.h"
+#include "headlessrunner.h"
 
 #include <shv/chainpack/rpcmessage.h>
 #include <shv/core/utils.h>
@@ -111,6 +112,21 @@ int main(int argc, char *argv[])
 
 	shvInfo() << "--------------------------------------------------------------------------------------";
 
+#ifndef Q_OS_WASM
+	if(cli_opts.batch_isset()) {
+		// no widgets, so it can run from cron without display
+		QCoreApplication a(argc, argv);
+		HeadlessRunner runner(&cli_opts);
+		QObject::connect(&runner, &HeadlessRunner::finished, &a, &QCoreApplication::exit, Qt::QueuedConnection);
+		if(!runner.start(QString::fromStdString(cli_opts.batch()))) {
+			return EXIT_FAILURE;
+		}
+		ret = QCoreApplication::exec();
+		shvInfo() << "batch exit code:" << ret;
+		return ret;
+	}
+#endif
+
 	TheApp a(argc, argv, &cli_opts);
 	MainWindow w;
 	w.show();
@@ -9,13 +9,20 @@
 #include "servertreemodel/shvbrokernodeitem.h"
 #include "log/rpcnotificationsmodel.h"
 #include "dlgbrokerproperties.h"
+#include "dlgbrokerstatistics.h"
+#include "dlgtransfermanager.h"
+#include "brokerconnection.h"
 #include "brokerproperty.h"
 #include "dlgcallshvmethod.h"
+#include "dlgrpcvaluetree.h"
+#include "rpcvaluediff.h"
+#include "rpcvaluefilereader.h"
 #include "dlguserseditor.h"
 #include "dlgroleseditor.h"
 #include "dlgmountseditor.h"
 #include "methodparametersdialog.h"
 #include "texteditdialog.h"
+#include "transfermanager.h"
 
 #include <shv/chainpack/chainpackreader.h>
 #include <shv/chainpack/chainpackwriter.h>
@@ -37,8 +44,9 @@
 #include <QInputDialog>
 #include <QScrollBar>
 #include <QFileDialog>
-#include <QUrlQuery>
+#include <QUrl>
 #include <QProgressDialog>
+#include <QLocale>
 
 #include <fstream>
 
@@ -54,11 +62,23 @@ MainWindow::MainWindow(QWidget *parent) :
 	connect(ui->actionQuit, &QAction::triggered, TheApp::instance(), &TheApp::quit);
 	setWindowIcon(QIcon(":/shvspy/images/shvspy"));
 
+	auto *menu_file = new QMenu(tr("&File"), this);
+	ui->menuBar->insertMenu(ui->menu_View->menuAction(), menu_file);
+	auto *act_open_file = new QAction(tr("&Open ChainPack/Cpon file..."), this);
+	act_open_file->setShortcut(QKeySequence::Open);
+	menu_file->addAction(act_open_file);
+	connect(act_open_file, &QAction::triggered, this, &MainWindow::openRpcValueFile);
+	menu_file->addSeparator();
+	menu_file->addAction(ui->actionQuit);
+
 	ui->menu_View->addAction(ui->dockServers->toggleViewAction());
 	ui->menu_View->addAction(ui->dockAttributes->toggleViewAction());
 	ui->menu_View->addAction(ui->dockNotifications->toggleViewAction());
 	ui->menu_View->addAction(ui->dockErrors->toggleViewAction());
 	ui->menu_View->addAction(ui->dockSubscriptions->toggleViewAction());
+	auto *act_transfers = new QAction(tr("File transfers"), this);
+	ui->menu_View->addAction(act_transfers);
+	connect(act_transfers, &QAction::triggered, this, &MainWindow::showTransferManager);
 
 	ServerTreeModel *tree_model = TheApp::instance()->serverTreeModel();
 	ui->treeServers->setModel(tree_model);
@@ -94,6 +114,8 @@ MainWindow::MainWindow(QWidget *parent) :
 		ui->btLogInspector->setVisible(false);
 		ui->btFileUpload->setVisible(false);
 		ui->btFileDownload->setVisible(false);
+		ui->chkFileVerify->setVisible(false);
+		ui->chkFileDelta->setVisible(false);
 	};
 	hide_action_buttons();
 	connect(attr_model, &AttributesModel::reloaded, this, [this, hide_action_buttons]() {
@@ -115,6 +137,8 @@ MainWindow::MainWindow(QWidget *parent) :
 			ui->btLogInspector->setVisible(node_has_methods(node_methods, get_log_methods));
 			ui->btFileDownload->setVisible(node_has_methods(node_methods, ro_file_node_methods));
 			ui->btFileUpload->setVisible(node_has_methods(node_methods, wr_file_node_methods));
+			ui->chkFileVerify->setVisible(!ui->btFileDownload->isHidden() || !ui->btFileUpload->isHidden());
+			ui->chkFileDelta->setVisible(!ui->btFileUpload->isHidden());
 		}
 
 		ui->tblAttributes->resizeColumnToContents(AttributesModel::ColMethodName);
@@ -144,6 +168,14 @@ MainWindow::MainWindow(QWidget *parent) :
 	connect(ui->btLogInspector, &QPushButton::clicked, this, &MainWindow::openLogInspector);
 	connect(ui->btFileDownload, &QPushButton::clicked, this, &MainWindow::fileDownload);
 	connect(ui->btFileUpload, &QPushButton::clicked, this, &MainWindow::fileUpload);
+	ui->chkFileVerify->setChecked(QSettings().value(QStringLiteral("ui/mainWindow/verifyFileTransfers"), false).toBool());
+	connect(ui->chkFileVerify, &QCheckBox::toggled, this, [](bool checked) {
+		QSettings().setValue(QStringLiteral("ui/mainWindow/verifyFileTransfers"), checked);
+	});
+	ui->chkFileDelta->setChecked(QSettings().value(QStringLiteral("ui/mainWindow/deltaFileUpload"), false).toBool());
+	connect(ui->chkFileDelta, &QCheckBox::toggled, this, [](bool checked) {
+		QSettings().setValue(QStringLiteral("ui/mainWindow/deltaFileUpload"), checked);
+	});
 
 	ui->notificationsLogWidget->setLogTableModel(TheApp::instance()->rpcNotificationsModel());
 	connect(ui->notificationsLogWidget->tableView(), &QTableView::doubleClicked, this, &MainWindow::onNotificationsDoubleClicked);
@@ -234,47 +266,15 @@ void MainWindow::checkSettingsReady()
 					continue;
 				}
 				shvInfo() << "Adding adhoc dserver url:" << url.toString();
-				QUrlQuery query(url);
-				QVariantMap conprops;
-				auto set_conprop_from_query = [&query, &conprops](const char *key) {
-					if (query.hasQueryItem(key)) {
-						conprops[key] = query.queryItemValue(key);
-					}
-				};
-				using namespace brokerProperty;
-				auto name = query.queryItemValue(NAME);
-				if (name.isEmpty()) {
-					name = QStringLiteral("Connection %1").arg(++n);
-				}
-				conprops[NAME] = name;
-				conprops[SCHEME] = url.scheme();
-				auto host = url.host();
-				if (host.isEmpty()) {
-					host = url.path();
+				auto conprops = brokerConnection::propertiesFromUrl(url);
+				if (conprops.value(brokerProperty::NAME).toString().isEmpty()) {
+					conprops[brokerProperty::NAME] = QStringLiteral("Connection %1").arg(++n);
 				}
-				if (host.isEmpty()) {
-					host = "localhost";
-				}
-				conprops[HOST] = host;
-				conprops[PORT] = url.port(3755);
-				set_conprop_from_query(DEVICE_ID);
-				set_conprop_from_query(DEVICE_MOUNTPOINT);
-				set_conprop_from_query(USER);
-				auto password = query.queryItemValue(PASSWORD);
+				// server tree model decrypts passwords of loaded servers
+				auto password = conprops.value(brokerProperty::PASSWORD).toString();
 				if (!password.isEmpty()) {
-					password = QString::fromStdString(TheApp::instance()->crypt().encrypt(password.toStdString()));
+					conprops[brokerProperty::PASSWORD] = QString::fromStdString(TheApp::instance()->crypt().encrypt(password.toStdString()));
 				}
-				conprops[PASSWORD] = password;
-				set_conprop_from_query(CONNECTIONTYPE);
-				set_conprop_from_query(PLAIN_TEXT_PASSWORD);
-				set_conprop_from_query(AZURELOGIN);
-				set_conprop_from_query(SECURITYTYPE);
-				set_conprop_from_query(PEERVERIFY);
-				set_conprop_from_query(RPC_RECONNECTINTERVAL);
-				set_conprop_from_query(RPC_HEARTBEATINTERVAL);
-				set_conprop_from_query(RPC_RPCTIMEOUT);
-				set_conprop_from_query(MUTEHEARTBEATS);
-				set_conprop_from_query(SHVROOT);
 				qservers << conprops;
 			}
 			if (!qservers.isEmpty()) {
@@ -380,6 +380,9 @@ void MainWindow::onTreeServers_customContextMenuRequested(const QPoint &pos)
 	auto *a_usersEditor = new QAction(tr("Users editor"), m);
 	auto *a_rolesEditor = new QAction(tr("Roles editor"), m);
 	auto *a_mountsEditor = new QAction(tr("Mounts editor"), m);
+	auto *a_rpcStatistics = new QAction(tr("RPC statistics"), m);
+	auto *a_downloadDirectory = new QAction(tr("Download directory ..."), m);
+	auto *a_uploadFiles = new QAction(tr("Upload files ..."), m);
 
 	if (!nd) {
 		m->addAction(ui->actAddServer);
@@ -393,11 +396,19 @@ void MainWindow::onTreeServers_customContextMenuRequested(const QPoint &pos)
 			m->addSeparator();
 			m->addAction(a_reloadNode);
 			m->addAction(a_callShvMethod);
+			m->addAction(a_rpcStatistics);
+#ifndef Q_OS_WASM
+			m->addAction(a_downloadDirectory);
+#endif
 		}
 	} else {
 		m->addAction(a_reloadNode);
 		m->addAction(a_subscribeNode);
 		m->addAction(a_callShvMethod);
+#ifndef Q_OS_WASM
+		m->addAction(a_downloadDirectory);
+		m->addAction(a_uploadFiles);
+#endif
 
 		if (nd->nodeId() == ".broker"){
 			m->addAction(a_usersEditor);
@@ -412,7 +423,7 @@ void MainWindow::onTreeServers_customContextMenuRequested(const QPoint &pos)
 	}
 
 	m->popup(ui->treeServers->viewport()->mapToGlobal(pos));
-	auto handle_custom_action = [this, a_reloadNode, a_subscribeNode, a_callShvMethod, a_usersEditor, a_rolesEditor, a_mountsEditor, m](QAction *a) {
+	auto handle_custom_action = [this, a_reloadNode, a_subscribeNode, a_callShvMethod, a_usersEditor, a_rolesEditor, a_mountsEditor, a_rpcStatistics, a_downloadDirectory, a_uploadFiles, m](QAction *a) {
 		m->deleteLater();
 		ShvNodeItem *nd = TheApp::instance()->serverTreeModel()->itemFromIndex(ui->treeServers->currentIndex());
 		if (!nd) {
@@ -429,9 +440,40 @@ void MainWindow::onTreeServers_customContextMenuRequested(const QPoint &pos)
 			return;
 		}
 
+		if (a == a_rpcStatistics) {
+			auto *dlg = new DlgBrokerStatistics(nd->serverNode(), this);
+			dlg->setAttribute(Qt::WA_DeleteOnClose);
+			dlg->show();
+			return;
+		}
+
 		shv::iotqt::rpc::ClientConnection *cc = nd->serverNode()->clientConnection();
+		if (a == a_downloadDirectory) {
+			auto local_dir = QFileDialog::getExistingDirectory(this, tr("Download directory to"));
+			if (!local_dir.isEmpty()) {
+				auto broker_name = QString::fromStdString(nd->serverNode()->nodeId());
+				auto dir_name = nd == nd->serverNode()? broker_name: nd->objectName();
+				TheApp::instance()->transferManager()->addRemoteDirectory(cc, broker_name, QString::fromStdString(nd->shvPath()), local_dir + '/' + dir_name);
+				showTransferManager();
+			}
+			return;
+		}
+
+		if (a == a_uploadFiles) {
+			auto file_names = QFileDialog::getOpenFileNames(this, tr("Select files to upload"), QString(), tr("All files (*)"));
+			auto broker_name = QString::fromStdString(nd->serverNode()->nodeId());
+			for (const auto &fn : file_names) {
+				auto shv_path = shv::core::utils::joinPath(nd->shvPath(), QFileInfo(fn).fileName().toStdString());
+				TheApp::instance()->transferManager()->addUpload(cc, broker_name, fn, QString::fromStdString(shv_path));
+			}
+			if (!file_names.isEmpty()) {
+				showTransferManager();
+			}
+			return;
+		}
+
 		if (a == a_callShvMethod) {
-			auto dlg = new DlgCallShvMethod(cc, this);
+			auto dlg = new DlgCallShvMethod(cc, nd->serverNode()->nodeId(), nd->serverNode()->brokerProperties().value(brokerProperty::RPC_RPCTIMEOUT).toInt() * 1000, this);
 			dlg->setShvPath(nd->shvPath());
 			dlg->open();
 			connect(dlg, &QDialog::finished, dlg, &QObject::deleteLater);
@@ -489,7 +531,7 @@ void MainWindow::onTreeServers_customContextMenuRequested(const QPoint &pos)
 		call->start();
 	};
 
-	for (auto* action : {a_reloadNode, a_subscribeNode, a_callShvMethod, a_usersEditor, a_rolesEditor, a_mountsEditor}) {
+	for (auto* action : {a_reloadNode, a_subscribeNode, a_callShvMethod, a_usersEditor, a_rolesEditor, a_mountsEditor, a_rpcStatistics, a_downloadDirectory, a_uploadFiles}) {
 		connect(action, &QAction::triggered, this, [handle_custom_action, action] { handle_custom_action(action); } );
 	}
 }
@@ -531,31 +573,81 @@ void MainWindow::displayValue(const shv::chainpack::RpcValue &rv)
 	if(rv.isString()) {
 		auto *view = create_text_view(this);
 		view->setWindowIconText(tr("Result"));
-		view->setText(QString::fromStdString(rv.asString()));
+		// text stays in UTF-8, large strings are shown in TextView without QString conversion
+		view->setBlob(QByteArray::fromStdString(rv.asString()));
 		view->show();
 	}
 	else if (rv.isBlob()) {
 		const auto &blob = rv.asBlob();
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-		auto data = QByteArray::fromRawData(reinterpret_cast<const char*>(blob.data()), blob.size());
+		// copy, view keeps data after rv is gone
+		auto data = QByteArray(reinterpret_cast<const char*>(blob.data()), static_cast<int>(blob.size()));
 #else
 		auto data = QByteArrayView(blob).toByteArray();
 #endif
 		showBlob(data);
 	}
 	else {
-		auto *view = new CponEditDialog(this);
+		// tree does not serialize the value, large results open instantly
+		auto *view = new DlgRpcValueTree(this);
 		view->setModal(false);
 		view->setAttribute(Qt::WA_DeleteOnClose);
 		view->setWindowIconText(tr("Result"));
-		view->setReadOnly(true);
-		view->setValidateContent(false);
-		QString cpon = QString::fromStdString(rv.toCpon("  "));
-		view->setText(cpon);
+		view->setValue(rv);
 		view->show();
 	}
 }
 
+QString MainWindow::getRpcValueFileName()
+{
+	static QString recent_dir;
+	auto file_name = QFileDialog::getOpenFileName(this, tr("Open ChainPack/Cpon file"), recent_dir, tr("ChainPack/Cpon files (*.chpk *.cpon *.json);;All files (*)"));
+	if (!file_name.isEmpty()) {
+		recent_dir = QFileInfo(file_name).absolutePath();
+	}
+	return file_name;
+}
+
+void MainWindow::loadRpcValueFile(const QString &file_name, std::function<void (const cp::RpcValue &)> &&on_loaded)
+{
+	auto *progress_dlg = new QProgressDialog(tr("Reading %1 ...").arg(file_name), tr("Cancel"), 0, 100, this);
+	progress_dlg->setAttribute(Qt::WA_DeleteOnClose);
+	progress_dlg->setMinimumDuration(500);
+	// reader is owned by progress dialog, closing the dialog cancels reading
+	auto *reader = new RpcValueFileReader(progress_dlg);
+	connect(reader, &RpcValueFileReader::progress, progress_dlg, &QProgressDialog::setValue);
+	connect(progress_dlg, &QProgressDialog::canceled, progress_dlg, &QProgressDialog::close);
+	connect(reader, &RpcValueFileReader::finished, this, [this, reader, progress_dlg, on_loaded = std::move(on_loaded)]() {
+		progress_dlg->close();
+		if (reader->errorString().isEmpty()) {
+			on_loaded(reader->value());
+		}
+		else {
+			QMessageBox::warning(this, tr("Warning"), tr("Cannot read file %1: %2").arg(reader->fileName(), reader->errorString()));
+		}
+	});
+	if (!reader->start(file_name)) {
+		QMessageBox::warning(this, tr("Warning"), tr("Cannot open file %1: %2").arg(file_name, reader->errorString()));
+		progress_dlg->close();
+	}
+}
+
+void MainWindow::openRpcValueFile()
+{
+	auto file_name = getRpcValueFileName();
+	if (file_name.isEmpty()) {
+		return;
+	}
+	loadRpcValueFile(file_name, [this, file_name](const cp::RpcValue &value) {
+		auto *view = new DlgRpcValueTree(this);
+		view->setModal(false);
+		view->setAttribute(Qt::WA_DeleteOnClose);
+		view->setWindowTitle(file_name);
+		view->setValue(value);
+		view->show();
+	});
+}
+
 void MainWindow::showBlob(const QByteArray &blob)
 {
 	auto *view = create_text_view(this);
@@ -564,14 +656,29 @@ void MainWindow::showBlob(const QByteArray &blob)
 	view->show();
 }
 
+void MainWindow::showBlobFile(const QString &file_name)
+{
+	auto *view = create_text_view(this);
+	view->setWindowIconText(tr("Result"));
+	view->setWindowTitle(file_name);
+	if (!view->setBlobFile(file_name)) {
+		QMessageBox::warning(this, tr("Warning"), tr("Cannot open file ") + file_name);
+		view->deleteLater();
+		return;
+	}
+	view->show();
+}
+
 void MainWindow::editMethodParameters(const QModelIndex &ix)
 {
 	QVariant v = ix.data(AttributesModel::RpcValueRole);
 	auto rv = qvariant_cast<cp::RpcValue>(v);
 
+	std::string broker = TheApp::instance()->attributesModel()->brokerName();
 	QString path = TheApp::instance()->attributesModel()->path();
 	QString method = TheApp::instance()->attributesModel()->method(ix.row());
-	auto *dlg = new MethodParametersDialog(path, method, rv, this);
+	QString param_type = TheApp::instance()->attributesModel()->paramType(ix.row());
+	auto *dlg = new MethodParametersDialog(broker, path, method, param_type, rv, this);
 	dlg->setWindowTitle(tr("Parameters"));
 	connect(dlg, &QDialog::finished, this, [this, dlg, ix](int result) {
 		if (result == QDialog::Accepted) {
@@ -632,7 +739,25 @@ void MainWindow::editCponParameters(const QModelIndex &ix)
 void MainWindow::onAttributesTableContextMenu(const QPoint &point)
 {
 	QModelIndex index = ui->tblAttributes->indexAt(point);
-	if (index.isValid() && index.column() == AttributesModel::ColMethodName) {
+	AttributesModel *attr_model = TheApp::instance()->attributesModel();
+	if (index.isValid() && index.column() == AttributesModel::ColBtRun) {
+		QMenu menu(this);
+		auto *a_call = menu.addAction(tr("Call method"));
+		auto *a_abort = menu.addAction(tr("Abort method call"));
+		a_abort->setEnabled(attr_model->isMethodCallRunning(index.row()));
+		auto *a = menu.exec(ui->tblAttributes->viewport()->mapToGlobal(point));
+		if (a == a_call) {
+			try {
+				attr_model->callMethod(index.row(), shv::core::Exception::Throw);
+			} catch (const std::exception &e) {
+				QMessageBox::warning(this, tr("Method call error"), tr("Method call error: %1").arg(e.what()));
+			}
+		}
+		else if (a == a_abort) {
+			attr_model->abortMethodCall(index.row());
+		}
+	}
+	else if (index.isValid() && index.column() == AttributesModel::ColMethodName) {
 		QMenu menu(this);
 		menu.addAction(tr("Method description"));
 		if (menu.exec(ui->tblAttributes->viewport()->mapToGlobal(point))) {
@@ -651,6 +776,11 @@ void MainWindow::onAttributesTableContextMenu(const QPoint &point)
 	else if (index.isValid() && index.column() == AttributesModel::ColResult) {
 		QMenu menu(this);
 		auto *a_view_result = menu.addAction(tr("View result"));
+		auto *a_diff_result = menu.addAction(tr("Diff with previous result"));
+		auto *a_diff_file = menu.addAction(tr("Diff with ChainPack/Cpon file..."));
+		a_diff_file->setEnabled(qvariant_cast<cp::RpcValue>(index.data(AttributesModel::RpcValueRole)).isValid());
+		auto *a_abort = menu.addAction(tr("Abort method call"));
+		a_abort->setEnabled(attr_model->isMethodCallRunning(index.row()));
 		auto *a_save_result_binary = menu.addAction(tr("Save binary result"));
 		auto *a_save_result_chainpack = menu.addAction(tr("Save result as ChainPack"));
 		auto *a_save_result_cpon = menu.addAction(tr("Save result as Cpon"));
@@ -659,6 +789,40 @@ void MainWindow::onAttributesTableContextMenu(const QPoint &point)
 			displayResult(index);
 			return;
 		}
+		if (a == a_abort) {
+			attr_model->abortMethodCall(index.row());
+			return;
+		}
+		if (a == a_diff_result) {
+			auto *view = create_text_view(this);
+			view->setWindowIconText(tr("Result diff"));
+			view->setText(TheApp::instance()->attributesModel()->resultDiff(index.row()));
+			view->show();
+			return;
+		}
+		if (a == a_diff_file) {
+			auto file_name = getRpcValueFileName();
+			if (file_name.isEmpty()) {
+				return;
+			}
+			const auto result = qvariant_cast<cp::RpcValue>(index.data(AttributesModel::RpcValueRole));
+			loadRpcValueFile(file_name, [this, file_name, result](const cp::RpcValue &file_value) {
+				QStringList lines;
+				lines << tr("%1 -> current result").arg(file_name);
+				const auto diff = rpcValueDiff::diff(file_value, result);
+				if (diff.empty()) {
+					lines << tr("Values are equal.");
+				}
+				for (const auto &line : diff) {
+					lines << QString::fromStdString(line);
+				}
+				auto *view = create_text_view(this);
+				view->setWindowIconText(tr("Result diff"));
+				view->setText(lines.join('\n'));
+				view->show();
+			});
+			return;
+		}
 		auto save_file = [this](const QString &ext, const std::string &data, const std::string &file_name = {}) {
 			static QString recent_dir;
 			const QString full_path = recent_dir + '/' + QString::fromStdString(file_name);
@@ -797,65 +961,119 @@ void MainWindow::openLogInspector()
 	}
 }
 
+namespace {
+void show_transfer_progress(QProgressDialog *dlg, const QString &label, qint64 bytes, qint64 total, qint64 bytes_per_sec)
+{
+	QLocale locale;
+	dlg->setMaximum(1000);
+	dlg->setValue(total > 0? static_cast<int>(bytes * 1000 / total): 0);
+	dlg->setLabelText(QStringLiteral("%1\n%2 / %3, %4/s")
+					  .arg(label)
+					  .arg(locale.formattedDataSize(bytes))
+					  .arg(locale.formattedDataSize(total))
+					  .arg(locale.formattedDataSize(bytes_per_sec)));
+}
+
+void show_transfer_suspended(QProgressDialog *dlg, const QString &label, bool is_suspended)
+{
+	if (is_suspended) {
+		dlg->setLabelText(label + '\n' + QCoreApplication::translate("MainWindow", "Connection lost, waiting for reconnect ..."));
+	}
+}
+}
+
 void MainWindow::fileDownload()
 {
 	ShvNodeItem *nd = TheApp::instance()->serverTreeModel()->itemFromIndex(ui->treeServers->currentIndex());
 	if(nd) {
 		shv::iotqt::rpc::ClientConnection *cc = nd->serverNode()->clientConnection();
-		auto *loader = new FileDownloader(cc, QString::fromStdString(nd->shvPath()), this);
 		auto file_name = nd->objectName();
-		auto *dlg = new QProgressDialog(tr("Downloading file %1 ...").arg(file_name), tr("Abort"), 0, 1, this);
+#ifdef Q_OS_WASM
+		QString target_file_name;
+#else
+		QString target_file_name = QFileDialog::getSaveFileName(this, tr("Save downloaded file as"), file_name);
+		if (target_file_name.isEmpty()) {
+			return;
+		}
+#endif
+		auto *loader = new FileDownloader(cc, QString::fromStdString(nd->shvPath()), this);
+		loader->setBrokerName(QString::fromStdString(nd->serverNode()->nodeId()));
+		loader->setTargetFile(target_file_name);
+		loader->setVerify(ui->chkFileVerify->isChecked());
+		auto label = tr("Downloading file %1 ...").arg(file_name);
+		auto *dlg = new QProgressDialog(label, tr("Abort"), 0, 1, this);
 		connect(dlg, &QProgressDialog::canceled, loader, [loader, dlg](){
-			loader->deleteLater();
+			loader->abort();
 			dlg->deleteLater();
 		});
-		connect(loader, &FileDownloader::progress, dlg, [dlg](int n, int of) {
-			shvDebug() << "progress:" << n << "of" << of;
-			if (n == 0) {
-				dlg->setMaximum(of);
-				dlg->open();
-			}
-			dlg->setValue(n);
+		connect(loader, &FileDownloader::transferProgress, dlg, [dlg, label](qint64 bytes, qint64 total, qint64 bytes_per_sec) {
+			show_transfer_progress(dlg, label, bytes, total, bytes_per_sec);
+		});
+		connect(loader, &FileDownloader::suspendedChanged, dlg, [dlg, label](bool is_suspended) {
+			show_transfer_suspended(dlg, label, is_suspended);
 		});
-		connect(loader, &FileDownloader::finished, this, [dlg, this](auto data, auto error) {
+		connect(loader, &FileDownloader::verificationStarted, dlg, [dlg, label]() {
+			dlg->setLabelText(label + '\n' + tr("Verifying ..."));
+		});
+		connect(loader, &FileDownloader::finished, this, [dlg, this, target_file_name](auto data, auto error) {
 			dlg->deleteLater();
-			if (error.isEmpty()) {
-				showBlob(data);
-			}
-			else {
+			if (!error.isEmpty()) {
 				QMessageBox msg(this);
 				msg.setIcon(QMessageBox::Warning);
 				msg.setText(error);
 				msg.open();
 			}
+			else if (target_file_name.isEmpty()) {
+				showBlob(data);
+			}
+			else {
+				auto *msg = new QMessageBox(QMessageBox::Information, tr("Download finished"), tr("File saved to %1").arg(target_file_name), QMessageBox::Close, this);
+				msg->setAttribute(Qt::WA_DeleteOnClose);
+				auto *bt_preview = msg->addButton(tr("Preview"), QMessageBox::ActionRole);
+				connect(bt_preview, &QPushButton::clicked, this, [this, target_file_name]() {
+					showBlobFile(target_file_name);
+				});
+				msg->open();
+			}
 		});
 		loader->start();
+		dlg->open();
 	}
 }
 
+void MainWindow::showTransferManager()
+{
+	if (!m_dlgTransferManager) {
+		m_dlgTransferManager = new DlgTransferManager(TheApp::instance()->transferManager(), this);
+		m_dlgTransferManager->setAttribute(Qt::WA_DeleteOnClose);
+	}
+	m_dlgTransferManager->show();
+	m_dlgTransferManager->raise();
+}
+
 void MainWindow::fileUpload()
 {
 	ShvNodeItem *nd = TheApp::instance()->serverTreeModel()->itemFromIndex(ui->treeServers->currentIndex());
 	if(nd) {
 		shv::iotqt::rpc::ClientConnection *cc = nd->serverNode()->clientConnection();
-		auto file_content_ready = [this, cc, shv_path = nd->shvPath(), remote_file_name = nd->objectName()](const QString &local_file_name, const QByteArray &data) {
-			if (local_file_name.isEmpty()) {
-				// No file was selected
-				return;
-			}
-			auto *loader = new FileUploader(cc, QString::fromStdString(shv_path), data, this);
-			auto *dlg = new QProgressDialog(tr("Uploading file %1 ...").arg(remote_file_name), tr("Abort"), 0, 1, this);
+		auto start_upload = [this, remote_file_name = nd->objectName(), broker_name = QString::fromStdString(nd->serverNode()->nodeId())](FileUploader *loader) {
+			loader->setBrokerName(broker_name);
+			loader->setVerify(ui->chkFileVerify->isChecked());
+			loader->setDeltaMode(ui->chkFileDelta->isChecked());
+			auto label = tr("Uploading file %1 ...").arg(remote_file_name);
+			auto *dlg = new QProgressDialog(label, tr("Abort"), 0, 1, this);
 			connect(dlg, &QProgressDialog::canceled, loader, [loader, dlg](){
-				loader->deleteLater();
+				loader->abort();
 				dlg->deleteLater();
 			});
-			connect(loader, &FileDownloader::progress, dlg, [dlg](int n, int of) {
-				shvDebug() << "progress:" << n << "of" << of;
-				if (n == 0) {
-					dlg->setMaximum(of);
-					dlg->open();
-				}
-				dlg->setValue(n);
+			connect(loader, &FileUploader::transferProgress, dlg, [dlg, label](qint64 bytes, qint64 total, qint64 bytes_per_sec) {
+				show_transfer_progress(dlg, label, bytes, total, bytes_per_sec);
+			});
+			connect(loader, &FileUploader::suspendedChanged, dlg, [dlg, label](bool is_suspended) {
+				show_transfer_suspended(dlg, label, is_suspended);
+			});
+			connect(loader, &FileUploader::verificationStarted, dlg, [dlg, label]() {
+				dlg->setLabelText(label + '\n' + tr("Verifying ..."));
 			});
 			connect(loader, &FileDownloader::finished, this, [dlg, this](auto , auto error) {
 				dlg->deleteLater();
@@ -867,19 +1085,24 @@ void MainWindow::fileUpload()
 			loader->start();
 			dlg->open();
 		};
-#if QT_VERSION < QT_VERSION_CHECK(5, 13, 0)
-		if (auto fn = QFileDialog::getOpenFileName(this, tr("Select  file to upload"), tr("All files (*)")); !fn.isEmpty()) {
-			QFile f(fn);
-			if (f.open(QFile::ReadOnly)) {
-				auto data = f.readAll();
-				file_content_ready(fn, data);
+#ifdef Q_OS_WASM
+		auto file_content_ready = [this, cc, shv_path = nd->shvPath(), start_upload](const QString &local_file_name, const QByteArray &data) {
+			if (local_file_name.isEmpty()) {
+				// No file was selected
+				return;
 			}
-		}
-#elif QT_VERSION < QT_VERSION_CHECK(6, 7, 0)
+			start_upload(new FileUploader(cc, QString::fromStdString(shv_path), data, this));
+		};
+#if QT_VERSION < QT_VERSION_CHECK(6, 7, 0)
 		QFileDialog::getOpenFileContent("All files (*)",  file_content_ready);
 #else
-		// works also for WASM
 		QFileDialog::getOpenFileContent("All files (*)",  file_content_ready, this);
+#endif
+#else
+		// local file is memory mapped by the uploader, it is never read into memory as a whole
+		if (auto fn = QFileDialog::getOpenFileName(this, tr("Select  file to upload"), QString(), tr("All files (*)")); !fn.isEmpty()) {
+			start_upload(new FileUploader(cc, QString::fromStdString(nd->shvPath()), fn, this));
+		}
 #endif
 	}
 }
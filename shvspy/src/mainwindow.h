@@ -4,8 +4,11 @@
 #include <shv/chainpack/rpcvalue.h>
 
 #include <QMainWindow>
+#include <QPointer>
 #include <QSettings>
 
+#include <functional>
+
 namespace Ui {
 class MainWindow;
 }
@@ -13,6 +16,7 @@ class QCloseEvent;
 class QStandardItemModel;
 
 class ShvBrokerNodeItem;
+class DlgTransferManager;
 
 class MainWindow : public QMainWindow
 {
@@ -38,6 +42,7 @@ private:
 	void openLogInspector();
 	void fileDownload();
 	void fileUpload();
+	void showTransferManager();
 
 	void gotoShvPath();
 
@@ -48,6 +53,11 @@ private:
 	void displayResult(const QModelIndex &ix);
 	void displayValue(const shv::chainpack::RpcValue &rv);
 	void showBlob(const QByteArray &blob);
+	void showBlobFile(const QString &file_name);
+	QString getRpcValueFileName();
+	/// Parses file on background with progress dialog, on_loaded is not called on error or cancel.
+	void loadRpcValueFile(const QString &file_name, std::function<void (const shv::chainpack::RpcValue &)> &&on_loaded);
+	void openRpcValueFile();
 	void editMethodParameters(const QModelIndex &ix);
 	void editStringParameter(const QModelIndex &ix);
 	void editCponParameters(const QModelIndex &ix);
@@ -63,6 +73,7 @@ private:
 	Ui::MainWindow *ui;
 	QStandardItemModel *m_opcObjects;
 	QSettings m_settings;
+	QPointer<DlgTransferManager> m_dlgTransferManager;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,41 @@
+#include "mappedfile.h"
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const QString &file_name)
+{
+	close();
+	m_file.setFileName(file_name);
+	if (!m_file.open(QFile::ReadOnly)) {
+		return false;
+	}
+	m_size = m_file.size();
+	if (m_size > 0) {
+		m_map = m_file.map(0, m_size);
+		if (m_map) {
+			m_bytes = reinterpret_cast<const char*>(m_map);
+		}
+		else {
+			// file system without mapping support
+			m_data = m_file.readAll();
+			m_bytes = m_data.constData();
+			m_size = m_data.size();
+		}
+	}
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_map) {
+		m_file.unmap(m_map);
+		m_map = nullptr;
+	}
+	m_file.close();
+	m_data.clear();
+	m_bytes = nullptr;
+	m_size = 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+
+/// Read-only file content, memory mapped when possible and read into memory
+/// on file systems without mapping support. Data is valid until close or destruction.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile &) = delete;
+	MappedFile& operator=(const MappedFile &) = delete;
+	~MappedFile();
+
+	bool open(const QString &file_name);
+	void close();
+	bool isOpen() const {return m_file.isOpen();}
+	QString errorString() const {return m_file.errorString();}
+
+	const char* data() const {return m_bytes;}
+	qint64 size() const {return m_size;}
+private:
+	QFile m_file;
+	uchar *m_map = nullptr;
+	QByteArray m_data;
+	const char *m_bytes = nullptr;
+	qint64 m_size = 0;
+};
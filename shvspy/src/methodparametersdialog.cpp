@@ -1,13 +1,13 @@
 #include "methodparametersdialog.h"
 #include "ui_methodparametersdialog.h"
+#include "parametersmodel/parametersitemdelegate.h"
+#include "parametersmodel/parametersmodel.h"
+#include "theapp.h"
+#include "callhistory.h"
 
 #include <shv/chainpack/rpcvalue.h>
 #include <shv/coreqt/log.h>
 
-#include <QCheckBox>
-#include <QComboBox>
-#include <QDateTimeEdit>
-#include <QLineEdit>
 #include <QSettings>
 
 namespace cp = shv::chainpack;
@@ -19,24 +19,19 @@ const int TAB_INDEX_PARAMETER_LIST = 2;
 const int TAB_INDEX_CPON = 3;
 }
 
-const QVector<cp::RpcValue::Type> MethodParametersDialog::m_supportedTypes {
-	cp::RpcValue::Type::String,
-	cp::RpcValue::Type::Int,
-	cp::RpcValue::Type::UInt,
-	cp::RpcValue::Type::Double,
-	cp::RpcValue::Type::Bool,
-	cp::RpcValue::Type::DateTime,
-};
-
-MethodParametersDialog::MethodParametersDialog(const QString &path, const QString &method, const cp::RpcValue &params, QWidget *parent)
+MethodParametersDialog::MethodParametersDialog(const std::string &broker, const QString &path, const QString &method, const QString &param_type, const cp::RpcValue &params, QWidget *parent)
 	: QDialog(parent)
 	, ui(new Ui::MethodParametersDialog)
+	, m_singleModel(new ParametersModel(this))
+	, m_listModel(new ParametersModel(this))
+	, m_mapModel(new ParametersModel(this))
+	, m_paramTypeHint(parseParamType(param_type))
 	, m_syntaxCheckTimer(this)
 	, m_path(path)
 	, m_method(method)
 	, m_currentTabIndex(TAB_INDEX_CPON)
 {
-	shvLogFuncFrame() << "method:" << method << "params:" << params.toCpon();
+	shvLogFuncFrame() << "method:" << method << "param type:" << param_type << "params:" << params.toCpon();
 	ui->setupUi(this);
 
 	ui->parsingSingleLabel->hide();
@@ -47,35 +42,52 @@ MethodParametersDialog::MethodParametersDialog(const QString &path, const QStrin
 	ui->removeMapButton->setEnabled(false);
 	ui->parsingMapLabel->hide();
 
+	auto init_table = [this](QTableView *table, ParametersModel *model) {
+		table->setModel(model);
+		table->setItemDelegate(new ParametersItemDelegate(table));
+		table->setEditTriggers(QAbstractItemView::AllEditTriggers);
+		table->setColumnHidden(ParametersModel::ColKey, model != m_mapModel);
+	};
+	init_table(ui->singleParameterTable, m_singleModel);
+	init_table(ui->parameterListTable, m_listModel);
+	init_table(ui->parameterMapTable, m_mapModel);
+
 	connect(ui->tabWidget, &QTabWidget::currentChanged, this, &MethodParametersDialog::onCurrentTabChanged);
-	connect(ui->addListButton, &QPushButton::clicked, this, QOverload<>::of(&MethodParametersDialog::newListParameter));
-	connect(ui->addMapButton, &QPushButton::clicked, this, QOverload<>::of(&MethodParametersDialog::newMapParameter));
+	connect(ui->addListButton, &QPushButton::clicked, this, &MethodParametersDialog::newListParameter);
+	connect(ui->addMapButton, &QPushButton::clicked, this, &MethodParametersDialog::newMapParameter);
 	connect(ui->removeListButton, &QPushButton::clicked, this, &MethodParametersDialog::removeListParameter);
 	connect(ui->removeMapButton, &QPushButton::clicked, this, &MethodParametersDialog::removeMapParameter);
 	connect(ui->clearButton, &QPushButton::clicked, this, &MethodParametersDialog::clear);
-	connect(ui->parameterListTable, &QTableWidget::currentCellChanged, this, &MethodParametersDialog::onListCurrentCellChanged);
-	connect(ui->parameterMapTable, &QTableWidget::currentCellChanged, this, &MethodParametersDialog::onMapCurrentCellChanged);
+	connect(ui->parameterListTable->selectionModel(), &QItemSelectionModel::currentRowChanged, this, [this](const QModelIndex &current) {
+		ui->removeListButton->setEnabled(current.isValid());
+	});
+	connect(ui->parameterMapTable->selectionModel(), &QItemSelectionModel::currentRowChanged, this, [this](const QModelIndex &current) {
+		ui->removeMapButton->setEnabled(current.isValid());
+	});
 	connect(ui->rawCponEdit, &QPlainTextEdit::textChanged, &m_syntaxCheckTimer, QOverload<>::of(&QTimer::start));
 	connect(ui->rawCponEdit, &QPlainTextEdit::textChanged, this, [this]() {
 		m_cponEdited = true;
 	});
 
-	ui->singleParameterTable->setRowCount(1);
-
-	m_singleTypeCombo = new QComboBox(this);
-	ui->singleParameterTable->setCellWidget(0, 0, m_singleTypeCombo);
-	for (cp::RpcValue::Type t : m_supportedTypes) {
-		m_singleTypeCombo->addItem(cp::RpcValue::typeToName(t), static_cast<int>(t));
-	}
-	m_singleValueGetters << ValueGetter();
-	m_singleValueSetters << ValueSetter();
-	switchToString(ui->singleParameterTable, 0, 1, m_singleValueGetters, m_singleValueSetters);
+	const auto last_used = TheApp::instance()->callHistory()->params(broker, m_path.toStdString(), m_method.toStdString());
+	ui->cbxLastUsedParams->addItems(last_used);
+	ui->cbxLastUsedParams->setCurrentIndex(-1);
+	ui->cbxLastUsedParams->setEnabled(!last_used.isEmpty());
+	connect(ui->cbxLastUsedParams, QOverload<int>::of(&QComboBox::activated), this, [this](int index) {
+		loadParams(ui->cbxLastUsedParams->itemText(index));
+	});
 
-	connect(m_singleTypeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MethodParametersDialog::onSingleTypeChanged);
+	newSingleParameter(cp::RpcValue());
 
 	if (params.isValid()) {
 		loadParams(params);
 	}
+	else if (m_paramTypeHint.tabIndex >= 0) {
+		disconnect(ui->tabWidget, &QTabWidget::currentChanged, this, &MethodParametersDialog::onCurrentTabChanged);
+		ui->tabWidget->setCurrentIndex(m_paramTypeHint.tabIndex);
+		m_currentTabIndex = m_paramTypeHint.tabIndex;
+		connect(ui->tabWidget, &QTabWidget::currentChanged, this, &MethodParametersDialog::onCurrentTabChanged);
+	}
 	m_syntaxCheckTimer.setInterval(500);
 	m_syntaxCheckTimer.setSingleShot(true);
 	connect(&m_syntaxCheckTimer, &QTimer::timeout, this, &MethodParametersDialog::checkSyntax);
@@ -91,6 +103,38 @@ MethodParametersDialog::~MethodParametersDialog()
 	delete ui;
 }
 
+MethodParametersDialog::ParamTypeHint MethodParametersDialog::parseParamType(const QString &param_type)
+{
+	auto scalar_type = [](const QString &name, cp::RpcValue::Type *type) {
+		for (cp::RpcValue::Type t : ParametersModel::supportedTypes()) {
+			if (name.compare(QLatin1String(cp::RpcValue::typeToName(t)), Qt::CaseInsensitive) == 0) {
+				*type = t;
+				return true;
+			}
+		}
+		return false;
+	};
+	ParamTypeHint hint;
+	QString s = param_type.trimmed();
+	if (s.isEmpty()) {
+		return hint;
+	}
+	if (scalar_type(s, &hint.itemType)) {
+		hint.tabIndex = TAB_INDEX_SINGLE_PARAMETER;
+	}
+	else if (s.compare(QLatin1String("Map"), Qt::CaseInsensitive) == 0 || s.startsWith('{')) {
+		hint.tabIndex = TAB_INDEX_PARAMETER_MAP;
+	}
+	else if (s.startsWith(QLatin1String("List"), Qt::CaseInsensitive) || s.startsWith('[')) {
+		hint.tabIndex = TAB_INDEX_PARAMETER_LIST;
+		// item type in brackets, for example [Int] or List[Double]
+		if (auto from = s.indexOf('['), to = s.lastIndexOf(']'); from >= 0 && to > from) {
+			scalar_type(s.mid(from + 1, to - from - 1).trimmed(), &hint.itemType);
+		}
+	}
+	return hint;
+}
+
 cp::RpcValue MethodParametersDialog::value() const
 {
 	if (ui->tabWidget->currentIndex() == TAB_INDEX_SINGLE_PARAMETER) {
@@ -117,136 +161,40 @@ cp::RpcValue MethodParametersDialog::value() const
 
 void MethodParametersDialog::newSingleParameter(const shv::chainpack::RpcValue &param)
 {
-	cp::RpcValue::Type current_type = static_cast<cp::RpcValue::Type>(m_singleTypeCombo->itemData(m_singleTypeCombo->currentIndex()).toInt());
-	cp::RpcValue::Type requested_type;
-	if (param.isValid()) {
-		requested_type = param.type();
-	}
-	else {
-		requested_type = cp::RpcValue::Type::String;
-	}
-	if (current_type != requested_type) {
-		disconnect(m_singleTypeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MethodParametersDialog::onSingleTypeChanged);
-		auto index = static_cast<int>(m_supportedTypes.indexOf(requested_type));
-		m_singleTypeCombo->setCurrentIndex(index);
-		switchByType(requested_type, ui->singleParameterTable, 0, 1, m_singleValueGetters, m_singleValueSetters);
-		connect(m_singleTypeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MethodParametersDialog::onSingleTypeChanged);
-	}
-	m_singleValueSetters[0](param);
+	std::vector<ParametersModel::Param> params;
+	params.push_back(ParametersModel::Param{{}, param.isValid()? param: ParametersModel::defaultValue(m_paramTypeHint.itemType)});
+	m_singleModel->setParams(std::move(params));
 }
 
 void MethodParametersDialog::newListParameter()
 {
-	newListParameter(cp::RpcValue());
+	const int row = m_listModel->addParam({}, ParametersModel::defaultValue(m_paramTypeHint.itemType));
+	auto ix = m_listModel->index(row, ParametersModel::ColValue);
+	ui->parameterListTable->setCurrentIndex(ix);
+	ui->parameterListTable->edit(ix);
 }
 
 void MethodParametersDialog::newMapParameter()
 {
-	newMapParameter("", cp::RpcValue());
-}
-
-void MethodParametersDialog::newMapParameter(const QString &key, const cp::RpcValue &param)
-{
-	int row = ui->parameterMapTable->rowCount();
-	ui->parameterMapTable->setRowCount(row + 1);
-
-	ui->parameterMapTable->setItem(row, 0, new QTableWidgetItem(key));
-	auto *combo = new QComboBox(this);
-	ui->parameterMapTable->setCellWidget(row, 1, combo);
-	for (cp::RpcValue::Type t : m_supportedTypes) {
-		combo->addItem(cp::RpcValue::typeToName(t), static_cast<int>(t));
-	}
-	m_mapValueGetters << ValueGetter();
-	m_mapValueSetters << ValueSetter();
-	ui->parameterMapTable->setVerticalHeaderItem(row, new QTableWidgetItem("  "));
-
-	if (param.isValid()) {
-		cp::RpcValue::Type t = param.type();
-		auto index = static_cast<int>(m_supportedTypes.indexOf(t));
-		combo->setCurrentIndex(index);
-		switchByType(t, ui->parameterMapTable, row, 2, m_mapValueGetters, m_mapValueSetters);
-		m_mapValueSetters[row](param);
-	}
-	else {
-		int index = static_cast<int>(m_supportedTypes.indexOf(cp::RpcValue::Type::String));
-		combo->setCurrentIndex(index);
-		switchToString(ui->parameterMapTable, row, 2, m_mapValueGetters, m_mapValueSetters);
-	}
-	connect(combo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this, combo, row](int index) {
-		auto t = static_cast<cp::RpcValue::Type>(combo->itemData(index).toInt());
-		switchByType(t, ui->parameterMapTable, row, 2, m_mapValueGetters, m_mapValueSetters);
-	});
-}
-
-void MethodParametersDialog::newListParameter(const cp::RpcValue &param)
-{
-	int row = ui->parameterListTable->rowCount();
-	ui->parameterListTable->setRowCount(row + 1);
-
-	auto *combo = new QComboBox(this);
-	ui->parameterListTable->setCellWidget(row, 0, combo);
-	for (cp::RpcValue::Type t : m_supportedTypes) {
-		combo->addItem(cp::RpcValue::typeToName(t), static_cast<int>(t));
-	}
-	m_listValueGetters << ValueGetter();
-	m_listValueSetters << ValueSetter();
-	ui->parameterListTable->setVerticalHeaderItem(row, new QTableWidgetItem("  "));
-
-	if (param.isValid()) {
-		cp::RpcValue::Type t = param.type();
-		auto index = static_cast<int>(m_supportedTypes.indexOf(t));
-		combo->setCurrentIndex(index);
-		switchByType(t, ui->parameterListTable, row, 1, m_listValueGetters, m_listValueSetters);
-		m_listValueSetters[row](param);
-	}
-	else {
-		auto index = static_cast<int>(m_supportedTypes.indexOf(cp::RpcValue::Type::String));
-		combo->setCurrentIndex(index);
-		switchToString(ui->parameterListTable, row, 1, m_listValueGetters, m_listValueSetters);
-	}
-	connect(combo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this, combo, row](int index) {
-		auto t = static_cast<cp::RpcValue::Type>(combo->itemData(index).toInt());
-		switchByType(t, ui->parameterListTable, row, 1, m_listValueGetters, m_listValueSetters);
-	});
-}
-
-void MethodParametersDialog::onListCurrentCellChanged(int row, int col)
-{
-	Q_UNUSED(col);
-	ui->removeListButton->setEnabled(row != -1);
-}
-
-void MethodParametersDialog::onMapCurrentCellChanged(int row, int col)
-{
-	Q_UNUSED(col);
-	ui->removeMapButton->setEnabled(row != -1);
-}
-
-void MethodParametersDialog::onSingleTypeChanged(int type)
-{
-	auto t = static_cast<cp::RpcValue::Type>(m_singleTypeCombo->itemData(type).toInt());
-	switchByType(t, ui->singleParameterTable, 0, 1, m_singleValueGetters, m_singleValueSetters);
+	const int row = m_mapModel->addParam({}, ParametersModel::defaultValue(cp::RpcValue::Type::String));
+	auto ix = m_mapModel->index(row, ParametersModel::ColKey);
+	ui->parameterMapTable->setCurrentIndex(ix);
+	ui->parameterMapTable->edit(ix);
 }
 
 void MethodParametersDialog::removeListParameter()
 {
-	int row = ui->parameterListTable->currentRow();
-	ui->parameterListTable->removeRow(row);
-	m_listValueGetters.removeAt(row);
-	m_listValueSetters.removeAt(row);
+	m_listModel->removeParam(ui->parameterListTable->currentIndex().row());
 }
 
 void MethodParametersDialog::removeMapParameter()
 {
-	int row = ui->parameterMapTable->currentRow();
-	ui->parameterMapTable->removeRow(row);
-	m_mapValueGetters.removeAt(row);
-	m_mapValueSetters.removeAt(row);
+	m_mapModel->removeParam(ui->parameterMapTable->currentIndex().row());
 }
 
 bool MethodParametersDialog::tryParseSingleParam(const cp::RpcValue &params)
 {
-	if (!m_supportedTypes.contains(params.type())) {
+	if (!ParametersModel::isSupportedType(params.type())) {
 		return false;
 	}
 	newSingleParameter(params);
@@ -261,13 +209,16 @@ bool MethodParametersDialog::tryParseListParams(const cp::RpcValue &params)
 	const auto &param_list = params.asList();
 
 	for (const cp::RpcValue &param : param_list) {
-		if (!m_supportedTypes.contains(param.type())) {
+		if (!ParametersModel::isSupportedType(param.type())) {
 			return false;
 		}
 	}
+	std::vector<ParametersModel::Param> list;
+	list.reserve(param_list.size());
 	for (const cp::RpcValue &param : param_list) {
-		newListParameter(param);
+		list.push_back(ParametersModel::Param{{}, param});
 	}
+	m_listModel->setParams(std::move(list));
 	return true;
 }
 
@@ -279,141 +230,19 @@ bool MethodParametersDialog::tryParseMapParams(const cp::RpcValue &params)
 	const auto &param_map = params.asMap();
 
 	for (const auto &param_pair : param_map) {
-		if (!m_supportedTypes.contains(param_pair.second.type())) {
+		if (!ParametersModel::isSupportedType(param_pair.second.type())) {
 			return false;
 		}
 	}
+	std::vector<ParametersModel::Param> map;
+	map.reserve(param_map.size());
 	for (const auto &param_pair : param_map) {
-		newMapParameter(QString::fromStdString(param_pair.first), param_pair.second);
+		map.push_back(ParametersModel::Param{param_pair.first, param_pair.second});
 	}
+	m_mapModel->setParams(std::move(map));
 	return true;
 }
 
-void MethodParametersDialog::switchToBool(QTableWidget *table, int row, int col, QVector<ValueGetter> &getters, QVector<ValueSetter> &setters)
-{
-	auto *checkbox = new QCheckBox(this);
-	table->setCellWidget(row, col, checkbox);
-	getters[row] = [checkbox]() {
-		return cp::RpcValue(checkbox->isChecked() ? true : false);
-	};
-	setters[row] = [checkbox](const cp::RpcValue &param) {
-		checkbox->setChecked(param.toBool());
-	};
-}
-
-void MethodParametersDialog::switchToInt(QTableWidget *table, int row, int col, QVector<ValueGetter> &getters, QVector<ValueSetter> &setters)
-{
-	auto *line_edit = new QLineEdit(this);
-	table->setCellWidget(row, col, line_edit);
-	line_edit->setValidator(new QIntValidator(line_edit));
-	getters[row] = [line_edit]() {
-		return cp::RpcValue(line_edit->text().toInt());
-	};
-	setters[row] = [line_edit](const cp::RpcValue &param) {
-		line_edit->setText(QString::number(param.toInt()));
-	};
-}
-
-void MethodParametersDialog::switchToUInt(QTableWidget *table, int row, int col, QVector<ValueGetter> &getters, QVector<ValueSetter> &setters)
-{
-	auto *line_edit = new QLineEdit(this);
-	table->setCellWidget(row, col, line_edit);
-	line_edit->setValidator(new QIntValidator(0, std::numeric_limits<int>::max(), line_edit));
-	getters[row] = [line_edit]() {
-		return cp::RpcValue(line_edit->text().toUInt());
-	};
-	setters[row] = [line_edit](const cp::RpcValue &param) {
-		line_edit->setText(QString::number(param.toUInt()));
-	};
-}
-
-void MethodParametersDialog::switchToString(QTableWidget *table, int row, int col, QVector<ValueGetter> &getters, QVector<ValueSetter> &setters)
-{
-	auto *line_edit = new QLineEdit(this);
-	line_edit->setMaxLength(std::numeric_limits<int>::max());
-	table->setCellWidget(row, col, line_edit);
-	getters[row] = [line_edit]() {
-		return  cp::RpcValue(line_edit->text().toStdString());
-	};
-	setters[row] = [line_edit](const cp::RpcValue &param) {
-		line_edit->setText(QString::fromStdString(param.asString()));
-	};
-}
-
-void MethodParametersDialog::switchToDouble(QTableWidget *table, int row, int col, QVector<ValueGetter> &getters, QVector<ValueSetter> &setters)
-{
-	auto *line_edit = new QLineEdit(this);
-	table->setCellWidget(row, col, line_edit);
-	auto *v = new QDoubleValidator(line_edit);
-	v->setLocale(QLocale::C);
-	line_edit->setValidator(v);
-	getters[row] = [line_edit]() {
-		return cp::RpcValue(line_edit->text().toDouble());
-	};
-	setters[row] = [line_edit](const cp::RpcValue &param) {
-		line_edit->setText(QString::number(param.toDouble()));
-	};
-}
-
-void MethodParametersDialog::switchToDateTime(QTableWidget *table, int row, int col, QVector<ValueGetter> &getters, QVector<ValueSetter> &setters)
-{
-	auto *datetime_widget = new QWidget(this);
-	auto *edit = new QDateTimeEdit(datetime_widget);
-#if !defined(__EMSCRIPTEN__)
-#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
-	edit->setTimeZone(QTimeZone::utc());
-#else
-	edit->setTimeSpec(Qt::TimeSpec::UTC);
-#endif
-#endif
-	auto *today = new QPushButton("...", datetime_widget);
-	today->setFixedWidth(20);
-	auto *layout = new QHBoxLayout;
-	layout->setContentsMargins(0,0,0,0);
-	layout->setSpacing(0);
-	layout->addWidget(edit);
-	layout->addWidget(today);
-	datetime_widget->setLayout(layout);
-	edit->setDisplayFormat("dd.MM.yyyy HH:mm:ss");
-	edit->setCalendarPopup(true);
-	table->setCellWidget(row, col, datetime_widget);
-	connect(today, &QPushButton::clicked, edit, [edit]() {
-		edit->setDateTime(QDateTime::currentDateTime());
-	});
-	getters[row] = [edit]() {
-		return cp::RpcValue::DateTime::fromMSecsSinceEpoch(edit->dateTime().toMSecsSinceEpoch());
-	};
-	setters[row] = [edit](const cp::RpcValue &param) {
-		edit->setDateTime(QDateTime::fromMSecsSinceEpoch(param.toDateTime().msecsSinceEpoch()));
-	};
-}
-
-void MethodParametersDialog::switchByType(const cp::RpcValue::Type &type, QTableWidget *table, int row, int col, QVector<ValueGetter> &getters, QVector<ValueSetter> &setters)
-{
-	switch (type) {
-	case cp::RpcValue::Type::Int:
-		switchToInt(table, row, col, getters, setters);
-		break;
-	case cp::RpcValue::Type::UInt:
-		switchToUInt(table, row, col, getters, setters);
-		break;
-	case cp::RpcValue::Type::Bool:
-		switchToBool(table, row, col, getters, setters);
-		break;
-	case cp::RpcValue::Type::String:
-		switchToString(table, row, col, getters, setters);
-		break;
-	case cp::RpcValue::Type::Double:
-		switchToDouble(table, row, col, getters, setters);
-		break;
-	case cp::RpcValue::Type::DateTime:
-		switchToDateTime(table, row, col, getters, setters);
-		break;
-	default:
-		break;
-	}
-}
-
 void MethodParametersDialog::switchToCpon()
 {
 	cp::RpcValue value;
@@ -478,7 +307,7 @@ void MethodParametersDialog::switchToMap()
 			}
 		}
 		else if (m_currentTabIndex == TAB_INDEX_PARAMETER_LIST) {
-			if (!ui->parameterListTable->isHidden() && ui->parameterListTable->rowCount() == 0) {
+			if (!ui->parameterListTable->isHidden() && m_listModel->rowCount() == 0) {
 				parsed = true;
 			}
 		}
@@ -518,7 +347,7 @@ void MethodParametersDialog::switchToList()
 			}
 		}
 		else if (m_currentTabIndex == TAB_INDEX_PARAMETER_MAP) {
-			if (!ui->parameterMapTable->isHidden() && ui->parameterMapTable->rowCount() == 0) {
+			if (!ui->parameterMapTable->isHidden() && m_mapModel->rowCount() == 0) {
 				parsed = true;
 			}
 		}
@@ -558,12 +387,12 @@ void MethodParametersDialog::switchToSingle()
 			}
 		}
 		else if (m_currentTabIndex == TAB_INDEX_PARAMETER_MAP) {
-			if (!ui->parameterMapTable->isHidden() && ui->parameterMapTable->rowCount() == 0) {
+			if (!ui->parameterMapTable->isHidden() && m_mapModel->rowCount() == 0) {
 				parsed = true;
 			}
 		}
 		else if (m_currentTabIndex == TAB_INDEX_PARAMETER_LIST) {
-			if (!ui->parameterListTable->isHidden() && ui->parameterListTable->rowCount() == 0) {
+			if (!ui->parameterListTable->isHidden() && m_listModel->rowCount() == 0) {
 				parsed = true;
 			}
 		}
@@ -585,9 +414,7 @@ void MethodParametersDialog::clearSingleParam()
 
 void MethodParametersDialog::clearParamList()
 {
-	ui->parameterListTable->reset();
-	ui->parameterListTable->clearContents();
-	ui->parameterListTable->setRowCount(0);
+	m_listModel->clear();
 	ui->removeListButton->setEnabled(false);
 	ui->addListButton->setEnabled(true);
 	ui->parsingListLabel->hide();
@@ -596,9 +423,7 @@ void MethodParametersDialog::clearParamList()
 
 void MethodParametersDialog::clearParamMap()
 {
-	ui->parameterMapTable->reset();
-	ui->parameterMapTable->clearContents();
-	ui->parameterMapTable->setRowCount(0);
+	m_mapModel->clear();
 	ui->removeMapButton->setEnabled(false);
 	ui->addMapButton->setEnabled(true);
 	ui->parsingMapLabel->hide();
@@ -681,7 +506,7 @@ cp::RpcValue MethodParametersDialog::singleParamValue() const
 		return cp::RpcValue();
 	}
 
-	cp::RpcValue val = m_singleValueGetters[0]();
+	cp::RpcValue val = m_singleModel->value(0);
 	if (val.isString() && val.asString().empty()) {
 		return cp::RpcValue();
 	}
@@ -690,24 +515,10 @@ cp::RpcValue MethodParametersDialog::singleParamValue() const
 
 cp::RpcValue MethodParametersDialog::listParamValue() const
 {
-	if (ui->parameterListTable->rowCount() == 0) {
-		return cp::RpcValue();
-	}
-	cp::RpcValue::List list;
-	for (int i = 0; i < ui->parameterListTable->rowCount(); ++i) {
-		list.push_back(m_listValueGetters[i]());
-	}
-	return list;
+	return m_listModel->listValue();
 }
 
 cp::RpcValue MethodParametersDialog::mapParamValue() const
 {
-	if (ui->parameterMapTable->rowCount() == 0) {
-		return cp::RpcValue();
-	}
-	cp::RpcValue::Map map;
-	for (int i = 0; i < ui->parameterMapTable->rowCount(); ++i) {
-		map[ui->parameterMapTable->item(i, 0)->text().toStdString()] = m_mapValueGetters[i]();
-	}
-	return map;
+	return m_mapModel->mapValue();
 }
@@ -3,7 +3,6 @@
 #include <QDialog>
 
 #include <QTimer>
-#include <functional>
 
 #include <shv/chainpack/rpcvalue.h>
 
@@ -11,47 +10,39 @@ namespace Ui {
 class MethodParametersDialog;
 }
 
-class QComboBox;
-class QTableWidget;
-class LastUsedParamsWidget;
+class ParametersModel;
 
 class MethodParametersDialog : public QDialog
 {
 	Q_OBJECT
 
 public:
-	explicit MethodParametersDialog(const QString &path, const QString &method, const shv::chainpack::RpcValue &params, QWidget *parent = nullptr);
+	/// param_type is MetaMethod param type signature, for example Int, String, Map or [Int],
+	/// it selects the editor and default types of new parameters when params are empty.
+	/// Last used params are offered from call history of broker.
+	explicit MethodParametersDialog(const std::string &broker, const QString &path, const QString &method, const QString &param_type, const shv::chainpack::RpcValue &params, QWidget *parent = nullptr);
 	~MethodParametersDialog() override;
 
 	shv::chainpack::RpcValue value() const;
 
 private:
-	using ValueGetter = std::function<shv::chainpack::RpcValue()>;
-	using ValueSetter = std::function<void(const shv::chainpack::RpcValue &param)>;
+	/// Param type signature parsed once, when dialog is created.
+	struct ParamTypeHint
+	{
+		int tabIndex = -1;
+		shv::chainpack::RpcValue::Type itemType = shv::chainpack::RpcValue::Type::String;
+	};
+	static ParamTypeHint parseParamType(const QString &param_type);
 
 	void newSingleParameter(const shv::chainpack::RpcValue &param);
 	void newListParameter();
-	void newListParameter(const shv::chainpack::RpcValue &param);
 	void newMapParameter();
-	void newMapParameter(const QString &key, const shv::chainpack::RpcValue &param);
-	void onListCurrentCellChanged(int row, int col);
-	void onMapCurrentCellChanged(int row, int col);
-	void onSingleTypeChanged(int type);
 	void removeListParameter();
 	void removeMapParameter();
 	bool tryParseSingleParam(const shv::chainpack::RpcValue &params);
 	bool tryParseListParams(const shv::chainpack::RpcValue &params);
 	bool tryParseMapParams(const shv::chainpack::RpcValue &params);
 
-	void switchToBool(QTableWidget *table, int row, int col, QVector<ValueGetter> &getters, QVector<ValueSetter> &setters);
-	void switchToInt(QTableWidget *table, int row, int col, QVector<ValueGetter> &getters, QVector<ValueSetter> &setters);
-	void switchToUInt(QTableWidget *table, int row, int col, QVector<ValueGetter> &getters, QVector<ValueSetter> &setters);
-	void switchToString(QTableWidget *table, int row, int col, QVector<ValueGetter> &getters, QVector<ValueSetter> &setters);
-	void switchToDouble(QTableWidget *table, int row, int col, QVector<ValueGetter> &getters, QVector<ValueSetter> &setters);
-	void switchToDateTime(QTableWidget *table, int row, int col, QVector<ValueGetter> &getters, QVector<ValueSetter> &setters);
-
-	void switchByType(const shv::chainpack::RpcValue::Type &type, QTableWidget *table, int row, int col, QVector<ValueGetter> &getters, QVector<ValueSetter> &setters);
-
 	void switchToCpon();
 	void switchToMap();
 	void switchToList();
@@ -71,18 +62,13 @@ private:
 	shv::chainpack::RpcValue mapParamValue() const;
 
 	Ui::MethodParametersDialog *ui;
-	QComboBox *m_singleTypeCombo;
-	QVector<ValueGetter> m_singleValueGetters;
-	QVector<ValueSetter> m_singleValueSetters;
-	QVector<ValueGetter> m_listValueGetters;
-	QVector<ValueSetter> m_listValueSetters;
-	QVector<ValueGetter> m_mapValueGetters;
-	QVector<ValueSetter> m_mapValueSetters;
-	const static QVector<shv::chainpack::RpcValue::Type> m_supportedTypes;
+	ParametersModel *m_singleModel;
+	ParametersModel *m_listModel;
+	ParametersModel *m_mapModel;
+	ParamTypeHint m_paramTypeHint;
 	QTimer m_syntaxCheckTimer;
 	QString m_path;
 	QString m_method;
-	LastUsedParamsWidget *m_usedParamsWidget = nullptr;
 	int m_currentTabIndex;
 	bool m_cponEdited = false;
 };
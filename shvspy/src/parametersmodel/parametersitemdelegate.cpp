@@ -0,0 +1,133 @@
+#include "parametersitemdelegate.h"
+
+#include "parametersmodel.h"
+
+#include <shv/chainpack/rpcvalue.h>
+
+#include <QComboBox>
+#include <QDateTimeEdit>
+#include <QDoubleValidator>
+#include <QHBoxLayout>
+#include <QIntValidator>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTimeZone>
+
+#include <limits>
+
+namespace cp = shv::chainpack;
+
+namespace {
+cp::RpcValue::Type param_type(const QModelIndex &index)
+{
+	return static_cast<cp::RpcValue::Type>(index.siblingAtColumn(ParametersModel::ColType).data(Qt::EditRole).toInt());
+}
+
+QWidget* create_datetime_editor(QWidget *parent)
+{
+	auto *datetime_widget = new QWidget(parent);
+	datetime_widget->setAutoFillBackground(true);
+	auto *edit = new QDateTimeEdit(datetime_widget);
+#if !defined(__EMSCRIPTEN__)
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+	edit->setTimeZone(QTimeZone::utc());
+#else
+	edit->setTimeSpec(Qt::TimeSpec::UTC);
+#endif
+#endif
+	edit->setDisplayFormat("dd.MM.yyyy HH:mm:ss");
+	edit->setCalendarPopup(true);
+	auto *today = new QPushButton("...", datetime_widget);
+	today->setFixedWidth(20);
+	QObject::connect(today, &QPushButton::clicked, edit, [edit]() {
+		edit->setDateTime(QDateTime::currentDateTime());
+	});
+	auto *layout = new QHBoxLayout(datetime_widget);
+	layout->setContentsMargins(0,0,0,0);
+	layout->setSpacing(0);
+	layout->addWidget(edit);
+	layout->addWidget(today);
+	datetime_widget->setFocusProxy(edit);
+	return datetime_widget;
+}
+}
+
+ParametersItemDelegate::ParametersItemDelegate(QObject *parent)
+	: Super(parent)
+{
+}
+
+QWidget *ParametersItemDelegate::createEditor(QWidget *parent, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+	if (index.column() == ParametersModel::ColType) {
+		auto *combo = new QComboBox(parent);
+		for (cp::RpcValue::Type t : ParametersModel::supportedTypes()) {
+			combo->addItem(cp::RpcValue::typeToName(t), static_cast<int>(t));
+		}
+		return combo;
+	}
+	if (index.column() == ParametersModel::ColValue) {
+		switch (param_type(index)) {
+		case cp::RpcValue::Type::Bool:
+			// edited by check box
+			return nullptr;
+		case cp::RpcValue::Type::DateTime:
+			return create_datetime_editor(parent);
+		case cp::RpcValue::Type::Int: {
+			auto *line_edit = new QLineEdit(parent);
+			line_edit->setValidator(new QIntValidator(line_edit));
+			return line_edit;
+		}
+		case cp::RpcValue::Type::UInt: {
+			auto *line_edit = new QLineEdit(parent);
+			line_edit->setValidator(new QIntValidator(0, std::numeric_limits<int>::max(), line_edit));
+			return line_edit;
+		}
+		case cp::RpcValue::Type::Double: {
+			auto *line_edit = new QLineEdit(parent);
+			auto *v = new QDoubleValidator(line_edit);
+			v->setLocale(QLocale::C);
+			line_edit->setValidator(v);
+			return line_edit;
+		}
+		default: {
+			auto *line_edit = new QLineEdit(parent);
+			line_edit->setMaxLength(std::numeric_limits<int>::max());
+			return line_edit;
+		}
+		}
+	}
+	return Super::createEditor(parent, option, index);
+}
+
+void ParametersItemDelegate::setEditorData(QWidget *editor, const QModelIndex &index) const
+{
+	if (auto *combo = qobject_cast<QComboBox*>(editor)) {
+		combo->setCurrentIndex(combo->findData(index.data(Qt::EditRole)));
+	}
+	else if (auto *datetime_edit = editor->findChild<QDateTimeEdit*>()) {
+		datetime_edit->setDateTime(index.data(Qt::EditRole).toDateTime());
+	}
+	else if (auto *line_edit = qobject_cast<QLineEdit*>(editor)) {
+		line_edit->setText(index.data(Qt::EditRole).toString());
+	}
+	else {
+		Super::setEditorData(editor, index);
+	}
+}
+
+void ParametersItemDelegate::setModelData(QWidget *editor, QAbstractItemModel *model, const QModelIndex &index) const
+{
+	if (auto *combo = qobject_cast<QComboBox*>(editor)) {
+		model->setData(index, combo->currentData(), Qt::EditRole);
+	}
+	else if (auto *datetime_edit = editor->findChild<QDateTimeEdit*>()) {
+		model->setData(index, datetime_edit->dateTime(), Qt::EditRole);
+	}
+	else if (auto *line_edit = qobject_cast<QLineEdit*>(editor)) {
+		model->setData(index, line_edit->text(), Qt::EditRole);
+	}
+	else {
+		Super::setModelData(editor, model, index);
+	}
+}
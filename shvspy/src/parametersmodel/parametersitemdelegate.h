@@ -0,0 +1,17 @@
+#pragma once
+
+#include <QStyledItemDelegate>
+
+/// Creates editor for type or value of ParametersModel cell, value editor depends on parameter type.
+class ParametersItemDelegate : public QStyledItemDelegate
+{
+	Q_OBJECT
+
+	using Super = QStyledItemDelegate;
+public:
+	explicit ParametersItemDelegate(QObject *parent = nullptr);
+
+	QWidget *createEditor(QWidget *parent, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+	void setEditorData(QWidget *editor, const QModelIndex &index) const override;
+	void setModelData(QWidget *editor, QAbstractItemModel *model, const QModelIndex &index) const override;
+};
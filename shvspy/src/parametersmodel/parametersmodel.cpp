@@ -0,0 +1,263 @@
+#include "parametersmodel.h"
+
+#include <QDateTime>
+#include <QTimeZone>
+
+#include <algorithm>
+
+namespace cp = shv::chainpack;
+
+namespace {
+QDateTime to_qdatetime(const cp::RpcValue &val)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+	return QDateTime::fromMSecsSinceEpoch(val.toDateTime().msecsSinceEpoch(), QTimeZone::utc());
+#else
+	return QDateTime::fromMSecsSinceEpoch(val.toDateTime().msecsSinceEpoch(), Qt::UTC);
+#endif
+}
+
+// value typed in editor or switched to another type, numbers are converted between each other
+cp::RpcValue to_rpcvalue(const QVariant &val, cp::RpcValue::Type type)
+{
+	switch (type) {
+	case cp::RpcValue::Type::Int:
+		return cp::RpcValue(val.toInt());
+	case cp::RpcValue::Type::UInt:
+		return cp::RpcValue(val.toUInt());
+	case cp::RpcValue::Type::Double:
+		return cp::RpcValue(val.toDouble());
+	case cp::RpcValue::Type::Bool:
+		return cp::RpcValue(val.toBool());
+	case cp::RpcValue::Type::DateTime:
+		return cp::RpcValue::DateTime::fromMSecsSinceEpoch(val.toDateTime().toMSecsSinceEpoch());
+	default:
+		return cp::RpcValue(val.toString().toStdString());
+	}
+}
+
+QVariant to_qvariant(const cp::RpcValue &val)
+{
+	switch (val.type()) {
+	case cp::RpcValue::Type::Int:
+		return val.toInt();
+	case cp::RpcValue::Type::UInt:
+		return val.toUInt();
+	case cp::RpcValue::Type::Double:
+		return val.toDouble();
+	case cp::RpcValue::Type::Bool:
+		return val.toBool();
+	case cp::RpcValue::Type::DateTime:
+		return to_qdatetime(val);
+	default:
+		return QString::fromStdString(val.asString());
+	}
+}
+}
+
+ParametersModel::ParametersModel(QObject *parent)
+	: Super(parent)
+{
+}
+
+const std::vector<cp::RpcValue::Type>& ParametersModel::supportedTypes()
+{
+	static const std::vector<cp::RpcValue::Type> types {
+		cp::RpcValue::Type::String,
+		cp::RpcValue::Type::Int,
+		cp::RpcValue::Type::UInt,
+		cp::RpcValue::Type::Double,
+		cp::RpcValue::Type::Bool,
+		cp::RpcValue::Type::DateTime,
+	};
+	return types;
+}
+
+bool ParametersModel::isSupportedType(cp::RpcValue::Type type)
+{
+	const auto &types = supportedTypes();
+	return std::find(types.cbegin(), types.cend(), type) != types.cend();
+}
+
+cp::RpcValue ParametersModel::defaultValue(cp::RpcValue::Type type)
+{
+	if (type == cp::RpcValue::Type::DateTime) {
+		return cp::RpcValue::DateTime::now();
+	}
+	return to_rpcvalue(QVariant(), type);
+}
+
+void ParametersModel::setParams(std::vector<Param> &&params)
+{
+	beginResetModel();
+	m_params = std::move(params);
+	endResetModel();
+}
+
+void ParametersModel::clear()
+{
+	setParams({});
+}
+
+int ParametersModel::addParam(const std::string &key, const cp::RpcValue &value)
+{
+	const int row = rowCount();
+	beginInsertRows(QModelIndex(), row, row);
+	m_params.push_back(Param{key, value});
+	endInsertRows();
+	return row;
+}
+
+void ParametersModel::removeParam(int row)
+{
+	if (row < 0 || row >= rowCount()) {
+		return;
+	}
+	beginRemoveRows(QModelIndex(), row, row);
+	m_params.erase(m_params.begin() + row);
+	endRemoveRows();
+}
+
+cp::RpcValue ParametersModel::value(int row) const
+{
+	if (row < 0 || row >= rowCount()) {
+		return cp::RpcValue();
+	}
+	return m_params[static_cast<size_t>(row)].value;
+}
+
+cp::RpcValue ParametersModel::listValue() const
+{
+	if (m_params.empty()) {
+		return cp::RpcValue();
+	}
+	cp::RpcValue::List list;
+	list.reserve(m_params.size());
+	for (const auto &param : m_params) {
+		list.push_back(param.value);
+	}
+	return list;
+}
+
+cp::RpcValue ParametersModel::mapValue() const
+{
+	if (m_params.empty()) {
+		return cp::RpcValue();
+	}
+	cp::RpcValue::Map map;
+	for (const auto &param : m_params) {
+		map[param.key] = param.value;
+	}
+	return map;
+}
+
+int ParametersModel::rowCount(const QModelIndex &parent) const
+{
+	return parent.isValid()? 0: static_cast<int>(m_params.size());
+}
+
+int ParametersModel::columnCount(const QModelIndex &parent) const
+{
+	return parent.isValid()? 0: ColCount;
+}
+
+Qt::ItemFlags ParametersModel::flags(const QModelIndex &ix) const
+{
+	auto ret = Super::flags(ix);
+	if (!ix.isValid()) {
+		return ret;
+	}
+	if (ix.column() == ColValue && m_params[static_cast<size_t>(ix.row())].value.isBool()) {
+		return ret | Qt::ItemIsUserCheckable;
+	}
+	return ret | Qt::ItemIsEditable;
+}
+
+QVariant ParametersModel::data(const QModelIndex &ix, int role) const
+{
+	if (!ix.isValid() || ix.row() >= rowCount()) {
+		return QVariant();
+	}
+	const auto &param = m_params[static_cast<size_t>(ix.row())];
+	switch (ix.column()) {
+	case ColKey:
+		if (role == Qt::DisplayRole || role == Qt::EditRole) {
+			return QString::fromStdString(param.key);
+		}
+		break;
+	case ColType:
+		if (role == Qt::DisplayRole) {
+			return QString::fromLatin1(cp::RpcValue::typeToName(param.value.type()));
+		}
+		if (role == Qt::EditRole) {
+			return static_cast<int>(param.value.type());
+		}
+		break;
+	case ColValue:
+		if (param.value.isBool()) {
+			if (role == Qt::CheckStateRole) {
+				return param.value.toBool()? Qt::Checked: Qt::Unchecked;
+			}
+			break;
+		}
+		if (role == Qt::DisplayRole) {
+			if (param.value.isDateTime()) {
+				return to_qdatetime(param.value).toString(QStringLiteral("dd.MM.yyyy HH:mm:ss"));
+			}
+			return to_qvariant(param.value).toString();
+		}
+		if (role == Qt::EditRole) {
+			return to_qvariant(param.value);
+		}
+		break;
+	default:
+		break;
+	}
+	return QVariant();
+}
+
+bool ParametersModel::setData(const QModelIndex &ix, const QVariant &val, int role)
+{
+	if (!ix.isValid() || ix.row() >= rowCount()) {
+		return false;
+	}
+	auto &param = m_params[static_cast<size_t>(ix.row())];
+	if (ix.column() == ColKey && role == Qt::EditRole) {
+		param.key = val.toString().toStdString();
+	}
+	else if (ix.column() == ColType && role == Qt::EditRole) {
+		const auto type = static_cast<cp::RpcValue::Type>(val.toInt());
+		if (type == param.value.type()) {
+			return true;
+		}
+		const bool is_number = param.value.isInt() || param.value.isUInt() || param.value.isDouble();
+		const bool to_number = type == cp::RpcValue::Type::Int || type == cp::RpcValue::Type::UInt || type == cp::RpcValue::Type::Double;
+		param.value = is_number && to_number? to_rpcvalue(to_qvariant(param.value), type): defaultValue(type);
+		emit dataChanged(index(ix.row(), ColType), index(ix.row(), ColValue));
+		return true;
+	}
+	else if (ix.column() == ColValue && role == Qt::EditRole) {
+		param.value = to_rpcvalue(val, param.value.type());
+	}
+	else if (ix.column() == ColValue && role == Qt::CheckStateRole && param.value.isBool()) {
+		param.value = cp::RpcValue(val.toInt() == Qt::Checked);
+	}
+	else {
+		return false;
+	}
+	emit dataChanged(ix, ix);
+	return true;
+}
+
+QVariant ParametersModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+		switch (section) {
+		case ColKey: return tr("Name");
+		case ColType: return tr("Type");
+		case ColValue: return tr("Value");
+		default: break;
+		}
+	}
+	return Super::headerData(section, orientation, role);
+}
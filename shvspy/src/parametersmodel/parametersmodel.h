@@ -0,0 +1,49 @@
+#pragma once
+
+#include <shv/chainpack/rpcvalue.h>
+
+#include <QAbstractTableModel>
+
+#include <string>
+#include <vector>
+
+/// Editable list or map of scalar method parameters. Values are kept as RpcValue,
+/// editors are created by ParametersItemDelegate only for the cell being edited,
+/// so parameter lists with thousands of items open instantly.
+class ParametersModel : public QAbstractTableModel
+{
+	Q_OBJECT
+
+	using Super = QAbstractTableModel;
+public:
+	enum Columns {ColKey = 0, ColType, ColValue, ColCount};
+	struct Param
+	{
+		std::string key;
+		shv::chainpack::RpcValue value;
+	};
+
+	explicit ParametersModel(QObject *parent = nullptr);
+
+	static const std::vector<shv::chainpack::RpcValue::Type>& supportedTypes();
+	static bool isSupportedType(shv::chainpack::RpcValue::Type type);
+	static shv::chainpack::RpcValue defaultValue(shv::chainpack::RpcValue::Type type);
+
+	void setParams(std::vector<Param> &&params);
+	void clear();
+	int addParam(const std::string &key, const shv::chainpack::RpcValue &value);
+	void removeParam(int row);
+
+	shv::chainpack::RpcValue value(int row) const;
+	shv::chainpack::RpcValue listValue() const;
+	shv::chainpack::RpcValue mapValue() const;
+
+	int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+	int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+	Qt::ItemFlags flags(const QModelIndex &ix) const override;
+	QVariant data(const QModelIndex &ix, int role = Qt::DisplayRole) const override;
+	bool setData(const QModelIndex &ix, const QVariant &val, int role = Qt::EditRole) override;
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+private:
+	std::vector<Param> m_params;
+};
@@ -0,0 +1,33 @@
+#include "rpcrequestabort.h"
+
+#include <shv/chainpack/rpcmessage.h>
+#include <shv/coreqt/log.h>
+#include <shv/iotqt/rpc/clientconnection.h>
+
+namespace cp = shv::chainpack;
+
+namespace rpcRequest {
+
+namespace {
+// SHV RPC 3 message body key, request with Abort set to true cancels the request with the same id
+constexpr int KEY_ABORT = 5;
+}
+
+bool sendAbort(shv::iotqt::rpc::ClientConnection *connection, int rq_id, const std::string &shv_path, const std::string &method)
+{
+	if(!connection || !connection->isBrokerConnected())
+		return false;
+	if(connection->shvApiVersion() != cp::IRpcConnection::ShvApiVersion::V3)
+		return false;
+	cp::RpcRequest rq;
+	rq.setRequestId(rq_id);
+	rq.setShvPath(shv_path);
+	rq.setMethod(method);
+	cp::RpcValue msg = rq.value();
+	msg.set(KEY_ABORT, true);
+	shvDebug() << "Aborting request:" << rq_id << shv_path << method;
+	connection->sendRpcMessage(cp::RpcMessage(msg));
+	return true;
+}
+
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+namespace shv::iotqt::rpc { class ClientConnection; }
+
+namespace rpcRequest {
+
+/// Asks the peer to stop processing request rq_id, only SHV API 3 supports request abort.
+/// Returns false when abort message was not sent.
+bool sendAbort(shv::iotqt::rpc::ClientConnection *connection, int rq_id, const std::string &shv_path, const std::string &method);
+
+}
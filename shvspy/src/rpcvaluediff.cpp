@@ -0,0 +1,106 @@
+#include "rpcvaluediff.h"
+
+#include <shv/chainpack/rpcvalue.h>
+
+#include <algorithm>
+#include <set>
+
+namespace cp = shv::chainpack;
+
+namespace rpcValueDiff {
+
+namespace {
+class Differ
+{
+public:
+	explicit Differ(size_t max_lines) : m_maxLines(max_lines) {}
+
+	void diff(const cp::RpcValue &from, const cp::RpcValue &to, const std::string &path)
+	{
+		if(isFull() || from == to)
+			return;
+		if(from.isMap() && to.isMap()) {
+			const auto &m1 = from.asMap();
+			const auto &m2 = to.asMap();
+			std::set<std::string> keys;
+			for(const auto &[k, v] : m1)
+				keys.insert(k);
+			for(const auto &[k, v] : m2)
+				keys.insert(k);
+			for(const auto &k : keys) {
+				auto it1 = m1.find(k);
+				auto it2 = m2.find(k);
+				if(it1 == m1.end())
+					added(path + '/' + k, it2->second);
+				else if(it2 == m2.end())
+					removed(path + '/' + k, it1->second);
+				else
+					diff(it1->second, it2->second, path + '/' + k);
+			}
+		}
+		else if(from.isIMap() && to.isIMap()) {
+			const auto &m1 = from.asIMap();
+			const auto &m2 = to.asIMap();
+			std::set<cp::RpcValue::Int> keys;
+			for(const auto &[k, v] : m1)
+				keys.insert(k);
+			for(const auto &[k, v] : m2)
+				keys.insert(k);
+			for(const auto &k : keys) {
+				auto it1 = m1.find(k);
+				auto it2 = m2.find(k);
+				auto key_path = path + '/' + std::to_string(k);
+				if(it1 == m1.end())
+					added(key_path, it2->second);
+				else if(it2 == m2.end())
+					removed(key_path, it1->second);
+				else
+					diff(it1->second, it2->second, key_path);
+			}
+		}
+		else if(from.isList() && to.isList()) {
+			const auto &l1 = from.asList();
+			const auto &l2 = to.asList();
+			for (size_t i = 0; i < std::max(l1.size(), l2.size()); ++i) {
+				auto item_path = path + '/' + std::to_string(i);
+				if(i >= l1.size())
+					added(item_path, l2[i]);
+				else if(i >= l2.size())
+					removed(item_path, l1[i]);
+				else
+					diff(l1[i], l2[i], item_path);
+			}
+		}
+		else {
+			addLine("~ " + pathOrRoot(path) + ": " + from.toCpon() + " -> " + to.toCpon());
+		}
+	}
+
+	std::vector<std::string> takeLines() { return std::move(m_lines); }
+private:
+	static std::string pathOrRoot(const std::string &path) { return path.empty()? std::string("/"): path; }
+	bool isFull() const { return m_lines.size() >= m_maxLines; }
+	void added(const std::string &path, const cp::RpcValue &v) { addLine("+ " + pathOrRoot(path) + ": " + v.toCpon()); }
+	void removed(const std::string &path, const cp::RpcValue &v) { addLine("- " + pathOrRoot(path) + ": " + v.toCpon()); }
+	void addLine(std::string &&line)
+	{
+		if(isFull())
+			return;
+		m_lines.push_back(std::move(line));
+		if(isFull())
+			m_lines.emplace_back("...");
+	}
+private:
+	size_t m_maxLines;
+	std::vector<std::string> m_lines;
+};
+}
+
+std::vector<std::string> diff(const cp::RpcValue &from, const cp::RpcValue &to, size_t max_lines)
+{
+	Differ differ(max_lines);
+	differ.diff(from, to, {});
+	return differ.takeLines();
+}
+
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace shv::chainpack { class RpcValue; }
+
+namespace rpcValueDiff {
+
+/// Structural difference of two values, one line per changed, added or removed item,
+/// item paths are in JSON pointer like notation, for example '/status/errors/0'.
+std::vector<std::string> diff(const shv::chainpack::RpcValue &from, const shv::chainpack::RpcValue &to, size_t max_lines = 1000);
+
+}
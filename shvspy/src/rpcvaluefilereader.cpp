@@ -0,0 +1,151 @@
+#include "rpcvaluefilereader.h"
+
+#include <shv/chainpack/chainpackreader.h>
+#include <shv/chainpack/cponreader.h>
+
+#include <QFileInfo>
+#include <QThread>
+
+#include <algorithm>
+#include <functional>
+#include <istream>
+#include <streambuf>
+
+namespace cp = shv::chainpack;
+
+namespace {
+// parser gets mapped data in windows, cancellation and progress are checked between them
+constexpr qint64 READ_WINDOW_SIZE = 4 * 1024 * 1024;
+
+class MappedStreamBuf : public std::streambuf
+{
+public:
+	using ProgressCallback = std::function<void (qint64 bytes_read)>;
+
+	MappedStreamBuf(const char *data, qint64 size, const std::atomic_bool &cancelled, ProgressCallback &&progress)
+		: m_data(data)
+		, m_size(size)
+		, m_cancelled(cancelled)
+		, m_progress(std::move(progress))
+	{
+	}
+protected:
+	int_type underflow() override
+	{
+		if (m_cancelled || m_offset >= m_size) {
+			return traits_type::eof();
+		}
+		const qint64 n = std::min(m_size - m_offset, READ_WINDOW_SIZE);
+		// stream buffer API is not const, but get area is only read
+		auto *p = const_cast<char*>(m_data + m_offset);
+		setg(p, p, p + n);
+		m_offset += n;
+		m_progress(m_offset);
+		return traits_type::to_int_type(*p);
+	}
+private:
+	const char *m_data;
+	qint64 m_size;
+	qint64 m_offset = 0;
+	const std::atomic_bool &m_cancelled;
+	ProgressCallback m_progress;
+};
+}
+
+RpcValueFileReader::RpcValueFileReader(QObject *parent)
+	: Super(parent)
+{
+}
+
+RpcValueFileReader::~RpcValueFileReader()
+{
+	cancel();
+}
+
+void RpcValueFileReader::cancel()
+{
+	m_generation++;
+	if (m_thread) {
+		*m_cancelled = true;
+		m_thread->wait();
+		m_thread = nullptr;
+	}
+	closeFile();
+}
+
+void RpcValueFileReader::closeFile()
+{
+	// unmaps file, parser must not be running
+	m_file.close();
+}
+
+bool RpcValueFileReader::start(const QString &file_name)
+{
+	cancel();
+	m_fileName = file_name;
+	m_value = cp::RpcValue();
+	m_errorString.clear();
+	if (!m_file.open(file_name)) {
+		m_errorString = m_file.errorString();
+		closeFile();
+		return false;
+	}
+	const char *bytes = m_file.data();
+	const qint64 size = m_file.size();
+	const auto suffix = QFileInfo(file_name).suffix().toLower();
+	const bool is_cpon = suffix == QLatin1String("cpon") || suffix == QLatin1String("json");
+	auto cancelled = std::make_shared<std::atomic_bool>(false);
+	m_cancelled = cancelled;
+	const int generation = m_generation;
+	m_thread = QThread::create([this, bytes, size, is_cpon, cancelled, generation]() {
+		int last_percent = 0;
+		MappedStreamBuf buf(bytes, size, *cancelled, [this, size, &last_percent](qint64 bytes_read) {
+			if (int percent = static_cast<int>(bytes_read * 100 / size); percent != last_percent) {
+				last_percent = percent;
+				emit progress(percent);
+			}
+		});
+		std::istream in(&buf);
+		cp::RpcValue value;
+		std::string error;
+		try {
+			if (is_cpon) {
+				cp::CponReader rd(in);
+				value = rd.read();
+			}
+			else {
+				cp::ChainPackReader rd(in);
+				value = rd.read();
+			}
+		}
+		catch (const std::exception &e) {
+			error = e.what();
+		}
+		if (*cancelled) {
+			return;
+		}
+		QMetaObject::invokeMethod(this, [this, value, error, generation]() {
+			if (generation != m_generation) {
+				return;
+			}
+			// worker only returns after posting result, file is unmapped when it does not read it anymore
+			if (m_thread) {
+				m_thread->wait();
+				m_thread = nullptr;
+			}
+			m_value = value;
+			m_errorString = QString::fromStdString(error);
+			closeFile();
+			emit finished();
+		}, Qt::QueuedConnection);
+	});
+	m_thread->setParent(this);
+	connect(m_thread, &QThread::finished, this, [this, thread = m_thread]() {
+		if (m_thread == thread) {
+			m_thread = nullptr;
+		}
+		thread->deleteLater();
+	});
+	m_thread->start();
+	return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "mappedfile.h"
+
+#include <shv/chainpack/rpcvalue.h>
+
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+
+class QThread;
+
+/// Parses ChainPack or Cpon file on worker thread. File is memory mapped and fed to the parser
+/// through stream buffer without copying, so only the parsed value occupies memory.
+/// Format is given by file extension, files without .cpon or .json extension are read as ChainPack.
+class RpcValueFileReader : public QObject
+{
+	Q_OBJECT
+
+	using Super = QObject;
+public:
+	explicit RpcValueFileReader(QObject *parent = nullptr);
+	~RpcValueFileReader() override;
+
+	bool start(const QString &file_name);
+	void cancel();
+	bool isRunning() const {return m_thread != nullptr;}
+
+	QString fileName() const {return m_fileName;}
+	const shv::chainpack::RpcValue& value() const {return m_value;}
+	QString errorString() const {return m_errorString;}
+
+	/// Parsed part of the file in percent.
+	Q_SIGNAL void progress(int percent);
+	Q_SIGNAL void finished();
+private:
+	void closeFile();
+private:
+	QString m_fileName;
+	MappedFile m_file;
+	QThread *m_thread = nullptr;
+	std::shared_ptr<std::atomic_bool> m_cancelled;
+	int m_generation = 0;
+	shv::chainpack::RpcValue m_value;
+	QString m_errorString;
+};
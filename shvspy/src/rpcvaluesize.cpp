@@ -0,0 +1,103 @@
+#include "rpcvaluesize.h"
+
+#include <shv/chainpack/rpcvalue.h>
+
+namespace cp = shv::chainpack;
+
+namespace rpcValueSize {
+
+namespace {
+// 64 bit integer takes at most 9 bytes, length byte and 8 bytes of data
+constexpr int64_t INT_SIZE = 9;
+// type byte and integer or 8 bytes of double
+constexpr int64_t SCALAR_SIZE = 1 + INT_SIZE;
+// type byte, mantissa and exponent
+constexpr int64_t DECIMAL_SIZE = 1 + 2 * INT_SIZE;
+
+int64_t uint_size(uint64_t n)
+{
+	int64_t ret = 1;
+	while(n >= 128) {
+		n >>= 7;
+		ret++;
+	}
+	return ret;
+}
+
+int64_t string_size(size_t len)
+{
+	return 1 + uint_size(len) + static_cast<int64_t>(len);
+}
+
+bool add_size(const cp::RpcValue &value, int64_t &size, int64_t limit);
+
+bool add_meta_size(const cp::RpcValue::MetaData &meta, int64_t &size, int64_t limit)
+{
+	if(meta.isEmpty())
+		return true;
+	size += 2;
+	for(const auto &[key, item] : meta.iValues()) {
+		size += SCALAR_SIZE;
+		if(!add_size(item, size, limit))
+			return false;
+	}
+	for(const auto &[key, item] : meta.sValues()) {
+		size += string_size(key.size());
+		if(!add_size(item, size, limit))
+			return false;
+	}
+	return size <= limit;
+}
+
+bool add_size(const cp::RpcValue &value, int64_t &size, int64_t limit)
+{
+	if(!add_meta_size(value.metaData(), size, limit))
+		return false;
+	if(value.isString()) {
+		size += string_size(value.asString().size());
+	}
+	else if(value.isBlob()) {
+		size += string_size(value.asBlob().size());
+	}
+	else if(value.isList()) {
+		size += 2;
+		for(const auto &item : value.asList()) {
+			if(!add_size(item, size, limit))
+				return false;
+		}
+	}
+	else if(value.isMap()) {
+		size += 2;
+		for(const auto &[key, item] : value.asMap()) {
+			size += string_size(key.size());
+			if(!add_size(item, size, limit))
+				return false;
+		}
+	}
+	else if(value.isIMap()) {
+		size += 2;
+		for(const auto &[key, item] : value.asIMap()) {
+			size += SCALAR_SIZE;
+			if(!add_size(item, size, limit))
+				return false;
+		}
+	}
+	else if(value.type() == cp::RpcValue::Type::Decimal) {
+		size += DECIMAL_SIZE;
+	}
+	else {
+		size += SCALAR_SIZE;
+	}
+	return size <= limit;
+}
+}
+
+int64_t chainPackSize(const cp::RpcValue &value, int64_t limit)
+{
+	int64_t size = 0;
+	if(!add_size(value, size, limit))
+		return -1;
+	return size;
+}
+
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+namespace shv::chainpack { class RpcValue; }
+
+namespace rpcValueSize {
+
+/// Upper estimate of ChainPack size of value including meta data computed without serializing it,
+/// every number is counted with its widest encoding. Walk stops and -1 is returned as soon as
+/// estimate exceeds limit, so cost is bounded for huge results.
+int64_t chainPackSize(const shv::chainpack::RpcValue &value, int64_t limit);
+
+}
@@ -0,0 +1,257 @@
+#include "rpcvaluetreemodel.h"
+
+#include <QStringList>
+
+#include <iterator>
+
+namespace cp = shv::chainpack;
+
+namespace {
+// long strings are cut in the view, whole value can be copied as Cpon
+constexpr size_t MAX_DISPLAY_LENGTH = 256;
+
+QString cut_text(const std::string &s)
+{
+	if (s.size() > MAX_DISPLAY_LENGTH) {
+		return QString::fromStdString(s.substr(0, MAX_DISPLAY_LENGTH)) + QStringLiteral("...");
+	}
+	return QString::fromStdString(s);
+}
+
+QString escape_path_key(QString key)
+{
+	return key.replace('~', QLatin1String("~0")).replace('/', QLatin1String("~1"));
+}
+
+QString unescape_path_key(QString key)
+{
+	return key.replace(QLatin1String("~1"), QLatin1String("/")).replace(QLatin1String("~0"), QLatin1String("~"));
+}
+}
+
+RpcValueTreeModel::RpcValueTreeModel(QObject *parent)
+	: Super(parent)
+{
+}
+
+RpcValueTreeModel::~RpcValueTreeModel() = default;
+
+void RpcValueTreeModel::setValue(const cp::RpcValue &val)
+{
+	beginResetModel();
+	m_root = std::make_unique<Node>();
+	m_root->value = val;
+	endResetModel();
+}
+
+int RpcValueTreeModel::childCount(const cp::RpcValue &val)
+{
+	if (val.isList()) {
+		return static_cast<int>(val.asList().size());
+	}
+	if (val.isMap()) {
+		return static_cast<int>(val.asMap().size());
+	}
+	if (val.isIMap()) {
+		return static_cast<int>(val.asIMap().size());
+	}
+	return 0;
+}
+
+RpcValueTreeModel::Node *RpcValueTreeModel::childNode(Node *parent, int row) const
+{
+	const auto &val = parent->value;
+	if (parent->children.empty()) {
+		parent->children.resize(static_cast<size_t>(childCount(val)));
+		// maps cannot be indexed by row, their children are created at once
+		int i = 0;
+		auto add_child = [parent, &i](const QString &key, const cp::RpcValue &child_val) {
+			auto &nd = parent->children[static_cast<size_t>(i)];
+			nd = std::make_unique<Node>();
+			nd->parent = parent;
+			nd->row = i++;
+			nd->key = key;
+			nd->value = child_val;
+		};
+		if (val.isMap()) {
+			for (const auto &[key, child_val] : val.asMap()) {
+				add_child(QString::fromStdString(key), child_val);
+			}
+		}
+		else if (val.isIMap()) {
+			for (const auto &[key, child_val] : val.asIMap()) {
+				add_child(QString::number(key), child_val);
+			}
+		}
+	}
+	if (row < 0 || static_cast<size_t>(row) >= parent->children.size()) {
+		return nullptr;
+	}
+	auto &nd = parent->children[static_cast<size_t>(row)];
+	if (!nd) {
+		nd = std::make_unique<Node>();
+		nd->parent = parent;
+		nd->row = row;
+		nd->key = QString::number(row);
+		nd->value = val.asList().at(static_cast<size_t>(row));
+	}
+	return nd.get();
+}
+
+RpcValueTreeModel::Node *RpcValueTreeModel::nodeForIndex(const QModelIndex &ix) const
+{
+	return ix.isValid()? static_cast<Node*>(ix.internalPointer()): nullptr;
+}
+
+cp::RpcValue RpcValueTreeModel::value(const QModelIndex &ix) const
+{
+	if (Node *nd = nodeForIndex(ix)) {
+		return nd->value;
+	}
+	return {};
+}
+
+QString RpcValueTreeModel::path(const QModelIndex &ix) const
+{
+	QStringList keys;
+	for (Node *nd = nodeForIndex(ix); nd && nd->parent; nd = nd->parent) {
+		keys.prepend(escape_path_key(nd->key));
+	}
+	return keys.isEmpty()? QStringLiteral("/"): '/' + keys.join('/');
+}
+
+QModelIndex RpcValueTreeModel::indexForPath(const QString &path, QString *error) const
+{
+	if (!m_root) {
+		return {};
+	}
+#if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
+	auto skip_empty_parts = QString::SkipEmptyParts;
+#else
+	auto skip_empty_parts = Qt::SkipEmptyParts;
+#endif
+	Node *nd = m_root.get();
+	for (const auto &part : path.split('/', skip_empty_parts)) {
+		auto key = unescape_path_key(part);
+		int row = -1;
+		if (nd->value.isMap()) {
+			const auto &map = nd->value.asMap();
+			if (auto it = map.find(key.toStdString()); it != map.end()) {
+				row = static_cast<int>(std::distance(map.begin(), it));
+			}
+		}
+		else if (nd->value.isIMap() || nd->value.isList()) {
+			bool ok;
+			int n = key.toInt(&ok);
+			if (ok && nd->value.isList()) {
+				row = n < childCount(nd->value)? n: -1;
+			}
+			else if (ok) {
+				const auto &imap = nd->value.asIMap();
+				if (auto it = imap.find(n); it != imap.end()) {
+					row = static_cast<int>(std::distance(imap.begin(), it));
+				}
+			}
+		}
+		nd = row < 0? nullptr: childNode(nd, row);
+		if (!nd) {
+			if (error) {
+				*error = tr("Key '%1' not found").arg(key);
+			}
+			return {};
+		}
+	}
+	return createIndex(nd->row, 0, nd);
+}
+
+QModelIndex RpcValueTreeModel::index(int row, int column, const QModelIndex &parent) const
+{
+	if (!m_root || column < 0 || column >= ColCount) {
+		return {};
+	}
+	if (!parent.isValid()) {
+		return row == 0? createIndex(0, column, m_root.get()): QModelIndex();
+	}
+	if (Node *nd = childNode(nodeForIndex(parent), row)) {
+		return createIndex(row, column, nd);
+	}
+	return {};
+}
+
+QModelIndex RpcValueTreeModel::parent(const QModelIndex &child) const
+{
+	Node *nd = nodeForIndex(child);
+	if (!nd || !nd->parent) {
+		return {};
+	}
+	return createIndex(nd->parent->row, 0, nd->parent);
+}
+
+int RpcValueTreeModel::rowCount(const QModelIndex &parent) const
+{
+	if (!m_root) {
+		return 0;
+	}
+	if (!parent.isValid()) {
+		return 1;
+	}
+	if (parent.column() > 0) {
+		return 0;
+	}
+	return childCount(nodeForIndex(parent)->value);
+}
+
+int RpcValueTreeModel::columnCount(const QModelIndex &parent) const
+{
+	Q_UNUSED(parent)
+	return ColCount;
+}
+
+bool RpcValueTreeModel::hasChildren(const QModelIndex &parent) const
+{
+	return rowCount(parent) > 0;
+}
+
+QVariant RpcValueTreeModel::data(const QModelIndex &ix, int role) const
+{
+	Node *nd = nodeForIndex(ix);
+	if (!nd || role != Qt::DisplayRole) {
+		return {};
+	}
+	const auto &val = nd->value;
+	switch (ix.column()) {
+	case ColKey:
+		return nd->parent? nd->key: QStringLiteral("/");
+	case ColType:
+		return QString::fromLatin1(cp::RpcValue::typeToName(val.type()));
+	case ColValue:
+		if (val.isList()) {
+			return tr("[%1 items]").arg(childCount(val));
+		}
+		if (val.isMap() || val.isIMap()) {
+			return tr("{%1 items}").arg(childCount(val));
+		}
+		if (val.isBlob()) {
+			return tr("%1 bytes").arg(val.asBlob().size());
+		}
+		if (val.isString()) {
+			return cut_text(val.asString());
+		}
+		return cut_text(val.toCpon());
+	default:
+		return {};
+	}
+}
+
+QVariant RpcValueTreeModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+		switch (section) {
+		case ColKey: return tr("Key");
+		case ColType: return tr("Type");
+		case ColValue: return tr("Value");
+		default: break;
+		}
+	}
+	return Super::headerData(section, orientation, role);
+}
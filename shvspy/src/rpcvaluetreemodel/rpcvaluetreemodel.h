@@ -0,0 +1,53 @@
+#pragma once
+
+#include <shv/chainpack/rpcvalue.h>
+
+#include <QAbstractItemModel>
+
+#include <memory>
+#include <vector>
+
+/// Tree over RpcValue without serializing it. Child nodes are created only when the view
+/// asks for them, list and map sizes are taken directly from containers.
+class RpcValueTreeModel : public QAbstractItemModel
+{
+	Q_OBJECT
+
+	using Super = QAbstractItemModel;
+public:
+	enum Columns {ColKey = 0, ColType, ColValue, ColCount};
+
+	explicit RpcValueTreeModel(QObject *parent = nullptr);
+	~RpcValueTreeModel() override;
+
+	void setValue(const shv::chainpack::RpcValue &val);
+	shv::chainpack::RpcValue value(const QModelIndex &ix) const;
+
+	/// JSON pointer like path, for example /1/values/3, keys containing ~ or / are escaped as ~0 and ~1.
+	QString path(const QModelIndex &ix) const;
+	/// Returns invalid index and sets error when path does not exist.
+	QModelIndex indexForPath(const QString &path, QString *error = nullptr) const;
+
+	QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+	QModelIndex parent(const QModelIndex &child) const override;
+	int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+	int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+	bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex &ix, int role = Qt::DisplayRole) const override;
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+private:
+	struct Node
+	{
+		Node *parent = nullptr;
+		int row = 0;
+		QString key;
+		shv::chainpack::RpcValue value;
+		/// Sized on first access, list items are created one by one as they become visible.
+		std::vector<std::unique_ptr<Node>> children;
+	};
+	static int childCount(const shv::chainpack::RpcValue &val);
+	Node* childNode(Node *parent, int row) const;
+	Node* nodeForIndex(const QModelIndex &ix) const;
+private:
+	std::unique_ptr<Node> m_root;
+};
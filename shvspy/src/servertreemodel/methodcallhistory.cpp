@@ -0,0 +1,65 @@
+#include "methodcallhistory.h"
+#include "../rpcvaluesize.h"
+
+#include <QDateTime>
+
+#include <algorithm>
+#include <vector>
+
+void MethodCallHistory::append(const shv::chainpack::RpcResponse &response, int64_t latency_msec)
+{
+	Entry &e = m_entries[m_head];
+	e.receivedMsec = QDateTime::currentMSecsSinceEpoch();
+	e.latencyMsec = latency_msec;
+	e.isError = response.isError();
+	m_previousValue = m_lastValue;
+	m_lastValue = e.isError? response.error().toRpcValue(): response.result();
+	e.resultSize = rpcValueSize::chainPackSize(m_lastValue, MAX_MEASURED_SIZE);
+	m_head = (m_head + 1) % CAPACITY;
+	m_count = std::min(m_count + 1, CAPACITY);
+	m_callCount++;
+}
+
+void MethodCallHistory::clear()
+{
+	*this = MethodCallHistory();
+}
+
+const MethodCallHistory::Entry &MethodCallHistory::at(size_t ix) const
+{
+	static const Entry empty_entry;
+	if(ix >= m_count)
+		return empty_entry;
+	return m_entries[(m_head + CAPACITY - 1 - ix) % CAPACITY];
+}
+
+int64_t MethodCallHistory::lastLatency() const
+{
+	if(m_count == 0)
+		return -1;
+	return at(0).latencyMsec;
+}
+
+int64_t MethodCallHistory::averageLatency() const
+{
+	if(m_count == 0)
+		return -1;
+	int64_t sum = 0;
+	for (size_t i = 0; i < m_count; ++i)
+		sum += m_entries[i].latencyMsec;
+	return sum / static_cast<int64_t>(m_count);
+}
+
+int64_t MethodCallHistory::percentileLatency(double percentile) const
+{
+	if(m_count == 0)
+		return -1;
+	std::vector<int64_t> samples;
+	samples.reserve(m_count);
+	for (size_t i = 0; i < m_count; ++i)
+		samples.push_back(m_entries[i].latencyMsec);
+	auto n = static_cast<size_t>(percentile * static_cast<double>(m_count - 1) + 0.5);
+	n = std::min(n, m_count - 1);
+	std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(n), samples.end());
+	return samples[n];
+}
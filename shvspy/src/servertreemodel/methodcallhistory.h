@@ -0,0 +1,45 @@
+#pragma once
+
+#include <shv/chainpack/rpcmessage.h>
+
+#include <array>
+#include <cstdint>
+
+class MethodCallHistory
+{
+public:
+	static constexpr size_t CAPACITY = 128;
+	/// Results bigger than this are not measured, their size is -1.
+	static constexpr int64_t MAX_MEASURED_SIZE = 1024 * 1024;
+
+	struct Entry
+	{
+		int64_t receivedMsec = 0;
+		int64_t latencyMsec = 0;
+		/// Estimated ChainPack size of result or error, -1 when bigger than MAX_MEASURED_SIZE.
+		int64_t resultSize = -1;
+		bool isError = false;
+	};
+public:
+	void append(const shv::chainpack::RpcResponse &response, int64_t latency_msec);
+	void clear();
+
+	size_t count() const {return m_count;}
+	/// ix == 0 is the most recent call
+	const Entry& at(size_t ix) const;
+	/// Result or error of the last two calls, they are kept to show result difference.
+	const shv::chainpack::RpcValue& lastValue() const {return m_lastValue;}
+	const shv::chainpack::RpcValue& previousValue() const {return m_previousValue;}
+
+	unsigned callCount() const {return m_callCount;}
+	int64_t lastLatency() const;
+	int64_t averageLatency() const;
+	int64_t percentileLatency(double percentile) const;
+private:
+	std::array<Entry, CAPACITY> m_entries;
+	size_t m_head = 0;
+	size_t m_count = 0;
+	shv::chainpack::RpcValue m_lastValue;
+	shv::chainpack::RpcValue m_previousValue;
+	unsigned m_callCount = 0;
+};
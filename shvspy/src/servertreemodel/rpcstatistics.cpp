@@ -0,0 +1,136 @@
+#include "rpcstatistics.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace cp = shv::chainpack;
+
+//=========================================================
+// LatencyHistogram
+//=========================================================
+unsigned LatencyHistogram::bucketIndex(uint32_t val)
+{
+	if(val < LINEAR_BUCKET_COUNT)
+		return val;
+	auto msb = static_cast<unsigned>(std::bit_width(val)) - 1;
+	auto shift = msb - SUB_BUCKET_BITS;
+	auto sub_bucket = (val >> shift) & (SUB_BUCKET_COUNT - 1);
+	return LINEAR_BUCKET_COUNT + (msb - SUB_BUCKET_BITS - 1) * SUB_BUCKET_COUNT + sub_bucket;
+}
+
+uint32_t LatencyHistogram::bucketUpperBound(unsigned ix)
+{
+	if(ix < LINEAR_BUCKET_COUNT)
+		return ix;
+	auto msb = (ix - LINEAR_BUCKET_COUNT) / SUB_BUCKET_COUNT + SUB_BUCKET_BITS + 1;
+	auto sub_bucket = (ix - LINEAR_BUCKET_COUNT) % SUB_BUCKET_COUNT;
+	auto shift = msb - SUB_BUCKET_BITS;
+	uint64_t lower = static_cast<uint64_t>(SUB_BUCKET_COUNT + sub_bucket) << shift;
+	return static_cast<uint32_t>(lower + (uint64_t{1} << shift) - 1);
+}
+
+void LatencyHistogram::record(int64_t msec)
+{
+	msec = std::clamp<int64_t>(msec, 0, UINT32_MAX);
+	m_buckets[bucketIndex(static_cast<uint32_t>(msec))]++;
+	if(m_count == 0 || msec < m_min)
+		m_min = msec;
+	if(msec > m_max)
+		m_max = msec;
+	m_count++;
+	m_sum += static_cast<uint64_t>(msec);
+}
+
+int64_t LatencyHistogram::percentile(double p) const
+{
+	if(m_count == 0)
+		return 0;
+	auto rank = static_cast<uint64_t>(p * static_cast<double>(m_count) + 0.5);
+	rank = std::clamp<uint64_t>(rank, 1, m_count);
+	uint64_t n = 0;
+	for (unsigned i = 0; i < BUCKET_COUNT; ++i) {
+		n += m_buckets[i];
+		if(n >= rank)
+			return std::min<int64_t>(bucketUpperBound(i), m_max);
+	}
+	return m_max;
+}
+
+cp::RpcValue LatencyHistogram::toRpcValue() const
+{
+	cp::RpcValue::Map ret;
+	ret["count"] = static_cast<cp::RpcValue::Int>(m_count);
+	ret["min"] = static_cast<cp::RpcValue::Int>(min());
+	ret["max"] = static_cast<cp::RpcValue::Int>(max());
+	ret["avg"] = static_cast<cp::RpcValue::Int>(average());
+	ret["p50"] = static_cast<cp::RpcValue::Int>(percentile(0.5));
+	ret["p90"] = static_cast<cp::RpcValue::Int>(percentile(0.9));
+	ret["p99"] = static_cast<cp::RpcValue::Int>(percentile(0.99));
+	cp::RpcValue::List buckets;
+	for (unsigned i = 0; i < BUCKET_COUNT; ++i) {
+		if(m_buckets[i] > 0)
+			buckets.push_back(cp::RpcValue::List{static_cast<cp::RpcValue::Int>(bucketUpperBound(i)), static_cast<cp::RpcValue::Int>(m_buckets[i])});
+	}
+	ret["buckets"] = buckets;
+	return ret;
+}
+
+//=========================================================
+// RpcStatistics
+//=========================================================
+void RpcStatistics::recordRequest(const cp::RpcValue &params)
+{
+	m_requestCount++;
+	if(m_measurePayloadSize && params.isValid())
+		m_bytesSent += params.toChainPack().size();
+}
+
+void RpcStatistics::recordResponse(const std::string &method, int64_t latency_msec, bool is_error, const cp::RpcValue &result)
+{
+	m_responseCount++;
+	MethodStatistics &ms = m_methods[method];
+	ms.latency.record(latency_msec);
+	if(is_error) {
+		m_errorCount++;
+		ms.errorCount++;
+	}
+	if(m_measurePayloadSize && result.isValid())
+		m_bytesReceived += result.toChainPack().size();
+}
+
+void RpcStatistics::recordTimeout(const std::string &method)
+{
+	m_timeoutCount++;
+	m_methods[method].timeoutCount++;
+}
+
+void RpcStatistics::reset()
+{
+	bool measure_payload_size = m_measurePayloadSize;
+	*this = RpcStatistics();
+	m_measurePayloadSize = measure_payload_size;
+}
+
+cp::RpcValue RpcStatistics::toRpcValue(size_t in_flight_count) const
+{
+	cp::RpcValue::Map ret;
+	ret["inFlight"] = static_cast<cp::RpcValue::Int>(in_flight_count);
+	ret["requests"] = static_cast<cp::RpcValue::Int>(m_requestCount);
+	ret["responses"] = static_cast<cp::RpcValue::Int>(m_responseCount);
+	ret["errors"] = static_cast<cp::RpcValue::Int>(m_errorCount);
+	ret["timeouts"] = static_cast<cp::RpcValue::Int>(m_timeoutCount);
+	if(m_measurePayloadSize) {
+		ret["bytesSent"] = static_cast<cp::RpcValue::Int>(m_bytesSent);
+		ret["bytesReceived"] = static_cast<cp::RpcValue::Int>(m_bytesReceived);
+	}
+	cp::RpcValue::Map methods;
+	for(const auto &[method, ms] : m_methods) {
+		cp::RpcValue::Map m;
+		m["latency"] = ms.latency.toRpcValue();
+		m["errors"] = static_cast<cp::RpcValue::Int>(ms.errorCount);
+		m["timeouts"] = static_cast<cp::RpcValue::Int>(ms.timeoutCount);
+		methods[method] = m;
+	}
+	ret["methods"] = methods;
+	return ret;
+}
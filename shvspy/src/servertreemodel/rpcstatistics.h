@@ -0,0 +1,77 @@
+#pragma once
+
+#include <shv/chainpack/rpcvalue.h>
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+
+/// Log-linear latency histogram in the spirit of HdrHistogram,
+/// values up to 15 msec are recorded exactly, bigger ones with 3 bits of precision (max error 12.5%).
+class LatencyHistogram
+{
+public:
+	static constexpr unsigned SUB_BUCKET_BITS = 3;
+	static constexpr unsigned SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+	static constexpr unsigned LINEAR_BUCKET_COUNT = 2 * SUB_BUCKET_COUNT;
+	static constexpr unsigned BUCKET_COUNT = LINEAR_BUCKET_COUNT + (32 - SUB_BUCKET_BITS - 1) * SUB_BUCKET_COUNT;
+public:
+	void record(int64_t msec);
+
+	uint64_t count() const {return m_count;}
+	int64_t min() const {return m_count? m_min: 0;}
+	int64_t max() const {return m_max;}
+	int64_t average() const {return m_count? static_cast<int64_t>(m_sum / m_count): 0;}
+	int64_t percentile(double p) const;
+
+	shv::chainpack::RpcValue toRpcValue() const;
+private:
+	static unsigned bucketIndex(uint32_t val);
+	static uint32_t bucketUpperBound(unsigned ix);
+private:
+	std::array<uint32_t, BUCKET_COUNT> m_buckets = {};
+	uint64_t m_count = 0;
+	uint64_t m_sum = 0;
+	int64_t m_min = 0;
+	int64_t m_max = 0;
+};
+
+class RpcStatistics
+{
+public:
+	struct MethodStatistics
+	{
+		LatencyHistogram latency;
+		uint64_t errorCount = 0;
+		uint64_t timeoutCount = 0;
+	};
+public:
+	void recordRequest(const shv::chainpack::RpcValue &params);
+	void recordResponse(const std::string &method, int64_t latency_msec, bool is_error, const shv::chainpack::RpcValue &result);
+	void recordTimeout(const std::string &method);
+	void reset();
+
+	/// Payload size measurement serializes params and results to ChainPack, it is off by default
+	bool isMeasurePayloadSize() const {return m_measurePayloadSize;}
+	void setMeasurePayloadSize(bool b) {m_measurePayloadSize = b;}
+
+	uint64_t requestCount() const {return m_requestCount;}
+	uint64_t responseCount() const {return m_responseCount;}
+	uint64_t errorCount() const {return m_errorCount;}
+	uint64_t timeoutCount() const {return m_timeoutCount;}
+	uint64_t bytesSent() const {return m_bytesSent;}
+	uint64_t bytesReceived() const {return m_bytesReceived;}
+	const std::map<std::string, MethodStatistics>& methods() const {return m_methods;}
+
+	shv::chainpack::RpcValue toRpcValue(size_t in_flight_count) const;
+private:
+	std::map<std::string, MethodStatistics> m_methods;
+	uint64_t m_requestCount = 0;
+	uint64_t m_responseCount = 0;
+	uint64_t m_errorCount = 0;
+	uint64_t m_timeoutCount = 0;
+	uint64_t m_bytesSent = 0;
+	uint64_t m_bytesReceived = 0;
+	bool m_measurePayloadSize = false;
+};
@@ -1,15 +1,15 @@
 #include "shvbrokernodeitem.h"
 #include "servertreemodel.h"
+#include "../brokerconnection.h"
 #include "../brokerproperty.h"
 #include "../theapp.h"
 #include "../appclioptions.h"
 #include "../log/rpcnotificationsmodel.h"
 #include "../attributesmodel/attributesmodel.h"
 #include "../subscriptionsmodel/subscriptionsmodel.h"
+#include "../rpcrequestabort.h"
 
 #include <shv/iotqt/rpc/clientconnection.h>
-#include <shv/iotqt/rpc/deviceconnection.h>
-#include <shv/iotqt/rpc/deviceappclioptions.h>
 #include <shv/iotqt/rpc/rpccall.h>
 #include <shv/iotqt/rpc/socket.h>
 #include <shv/iotqt/node/shvnode.h>
@@ -39,13 +39,20 @@ namespace cp = shv::chainpack;
 
 const QString ShvBrokerNodeItem::SUBSCRIPTIONS = QStringLiteral("subscriptions");
 
+namespace {
+const auto METH_RPC_STATISTICS = "rpcStatistics";
+}
+
 struct ShvBrokerNodeItem::RpcRequestInfo
 {
 	std::string shvPath;
+	std::string method;
 	QElapsedTimer startTS;
+	QElapsedTimer lastActivityTS;
 
 	RpcRequestInfo() {
 		startTS.start();
+		lastActivityTS.start();
 	}
 };
 
@@ -66,9 +73,12 @@ ShvBrokerNodeItem::ShvBrokerNodeItem(ServerTreeModel *m, const std::string &serv
 		tm2.start();
 		auto it = m_runningRpcRequests.begin();
 		while (it != m_runningRpcRequests.end()) {
-			auto elapsed = it->second.startTS.msecsTo(tm2);
-			if(elapsed > rpc_timeout_msec) {
+			// delay responses restart lastActivityTS, so long running calls reporting progress do not expire
+			auto idle = it->second.lastActivityTS.msecsTo(tm2);
+			if(idle > rpc_timeout_msec) {
+				auto elapsed = it->second.startTS.msecsTo(tm2);
 				shvWarning() << "RPC request timeout expired for node:" << server_name << it->second.shvPath << "after:" << elapsed << "msecs.";
+				m_rpcStatistics.recordTimeout(it->second.method);
 				it = m_runningRpcRequests.erase(it);
 			}
 			else
@@ -167,58 +177,7 @@ void ShvBrokerNodeItem::open()
 	m_brokerLoginErrorCount = 0;
 	m_openStatus = OpenStatus::Connecting;
 	shv::iotqt::rpc::ClientConnection *cli = clientConnection();
-	//cli->setServerName(props.value("name").toString());
-	//cli->setScheme(m_serverPropeties.value("scheme").toString().toStdString());
-	auto scheme = m_brokerPropeties.value(brokerProperty::SCHEME).toString().toStdString();
-	auto scheme_enum = shv::iotqt::rpc::Socket::schemeFromString(scheme);
-	if(scheme_enum == shv::iotqt::rpc::Socket::Scheme::Tcp && m_brokerPropeties.value(brokerProperty::SECURITYTYPE).toString() == "SSL")
-		scheme_enum = shv::iotqt::rpc::Socket::Scheme::Ssl;
-	scheme = shv::iotqt::rpc::Socket::schemeToString(scheme_enum);
-	auto host = m_brokerPropeties.value(brokerProperty::HOST).toString().toStdString();
-	auto port = m_brokerPropeties.value(brokerProperty::PORT).toInt();
-	std::string pwd = m_brokerPropeties.value(brokerProperty::PASSWORD).toString().toStdString();
-	if(scheme_enum == shv::iotqt::rpc::Socket::Scheme::LocalSocket || scheme_enum == shv::iotqt::rpc::Socket::Scheme::LocalSocketSerial || scheme_enum == shv::iotqt::rpc::Socket::Scheme::SerialPort) {
-		host = scheme + ":" + host;
-	}
-	else {
-		host = scheme + "://" + host;
-		if(port > 0) {
-			host += ':' + QString::number(port).toStdString();
-		}
-	}
-	bool skip_login = m_brokerPropeties.value(brokerProperty::SKIPLOGINPHASE).toBool();
-	if (skip_login) {
-		cli->setLoginType(shv::iotqt::rpc::ClientConnection::LoginType::None);
-	}
-	else {
-		//cli->setLoginType(pwd.size() == 40? cp::IRpcConnection::LoginType::Sha1: cp::IRpcConnection::LoginType::Plain);
-		if(scheme_enum == shv::iotqt::rpc::Socket::Scheme::Ssl) {
-			// SSL encryption is enough
-			// plain text password can be used for LDAP authentication on broker if enabled
-			cli->setLoginType(cp::IRpcConnection::LoginType::Plain);
-		}
-		else {
-			if(m_brokerPropeties.value(brokerProperty::PLAIN_TEXT_PASSWORD).toBool()) {
-				cli->setLoginType(cp::IRpcConnection::LoginType::Plain);
-			}
-			else {
-				// do not send plain text password over not encrypted socket
-				cli->setLoginType(cp::IRpcConnection::LoginType::Sha1);
-			}
-		}
-	}
-	cli->setHost(host);
-	//cli->setPort(m_serverPropeties.value("port").toInt());
-	//cli->setSecurityType(m_serverPropeties.value("securityType").toString().toStdString());
-	cli->setPeerVerify(m_brokerPropeties.value(brokerProperty::PEERVERIFY).toBool());
-	cli->setUser(m_brokerPropeties.value(brokerProperty::USER).toString().toStdString());
-	cli->setPassword(pwd);
-	//cli->setSkipLoginPhase(m_brokerPropeties.value("skipLoginPhase").toBool());
-
-	auto protocol_type = static_cast<shv::chainpack::Rpc::ProtocolType>(m_brokerPropeties.value(brokerProperty::RPC_PROTOCOLTYPE, static_cast<int>(shv::chainpack::Rpc::ProtocolType::ChainPack)).toInt());
-	cli->setProtocolType(protocol_type);
-
-
+	[[maybe_unused]] auto scheme_enum = brokerConnection::configure(cli, m_brokerPropeties);
 #if QT_VERSION_MAJOR >= 6 && defined(WITH_AZURE_SUPPORT)
 	bool azure_login = m_brokerPropeties.value(brokerProperty::AZURELOGIN, false).toBool();
 
@@ -261,56 +220,7 @@ void ShvBrokerNodeItem::close()
 shv::iotqt::rpc::ClientConnection *ShvBrokerNodeItem::clientConnection()
 {
 	if(!m_rpcConnection) {
-		QString conn_type = m_brokerPropeties.value(brokerProperty::CONNECTIONTYPE).toString();
-
-		shv::iotqt::rpc::DeviceAppCliOptions opts;
-		//{
-		//	int proto_type = m_brokerPropeties.value(brokerProperty::RPC_PROTOCOLTYPE).toInt();
-		//	if(proto_type == static_cast<int>(cp::Rpc::ProtocolType::JsonRpc))
-		//		opts.setProtocolType("jsonrpc");
-		//	else if(proto_type == static_cast<int>(cp::Rpc::ProtocolType::Cpon))
-		//		opts.setProtocolType("cpon");
-		//	else
-		//		opts.setProtocolType("chainpack");
-		//}
-		{
-			QVariant v = m_brokerPropeties.value(brokerProperty::RPC_RECONNECTINTERVAL);
-			if(v.isValid())
-				opts.setReconnectInterval(v.toInt());
-		}
-		{
-			QVariant v = m_brokerPropeties.value(brokerProperty::RPC_HEARTBEATINTERVAL);
-			if(v.isValid())
-				opts.setHeartBeatInterval(v.toInt());
-		}
-		{
-			QVariant v = m_brokerPropeties.value(brokerProperty::RPC_RPCTIMEOUT);
-			if(v.isValid())
-				opts.setRpcTimeout(v.toInt());
-		}
-		{
-			QString dev_id = m_brokerPropeties.value(brokerProperty::DEVICE_ID).toString();
-			if(!dev_id.isEmpty())
-				opts.setDeviceId(dev_id.toStdString());
-		}
-		{
-			QString mount_point = m_brokerPropeties.value(brokerProperty::DEVICE_MOUNTPOINT).toString();
-			if(!mount_point.isEmpty())
-				opts.setMountPoint(mount_point.toStdString());
-		}
-		if(conn_type == "device") {
-			auto *c = new shv::iotqt::rpc::DeviceConnection("shvspy " + QCoreApplication::applicationVersion().toStdString());
-			c->setCliOptions(&opts);
-			m_rpcConnection = c;
-		}
-		else {
-			m_rpcConnection = new shv::iotqt::rpc::ClientConnection("shvspy " + QCoreApplication::applicationVersion().toStdString());
-			m_rpcConnection->setCliOptions(&opts);
-		}
-		if(brokerProperties().value(brokerProperty::MUTEHEARTBEATS).toBool()) {
-			m_rpcConnection->muteShvPathInLog(shv::chainpack::Rpc::DIR_BROKER_APP, shv::chainpack::Rpc::METH_PING);
-		}
-		m_rpcConnection->setRawRpcMessageLog(TheApp::instance()->cliOptions()->isRawRpcMessageLog());
+		m_rpcConnection = brokerConnection::create(m_brokerPropeties, TheApp::instance()->cliOptions()->isRawRpcMessageLog());
 		//m_rpcConnection->setCheckBrokerConnectedInterval(0);
 		connect(m_rpcConnection, &shv::iotqt::rpc::ClientConnection::brokerConnectedChanged, this, &ShvBrokerNodeItem::onBrokerConnectedChanged);
 		connect(m_rpcConnection, &shv::iotqt::rpc::ClientConnection::rpcMessageReceived, this, &ShvBrokerNodeItem::onRpcMessageReceived);
@@ -408,16 +318,40 @@ int ShvBrokerNodeItem::callNodeRpcMethod(const std::string &calling_node_shv_pat
 	if(throw_exc && !cc->isBrokerConnected())
 		SHV_EXCEPTION("Broker is not connected.");
 	int rqid = cc->callShvMethod(calling_node_shv_path, method, params, req_user_id == RequestUserID::Yes ? cp::RpcValue{""} : cp::RpcValue{});
-	m_runningRpcRequests[rqid].shvPath = calling_node_shv_path;
+	RpcRequestInfo &rq_info = m_runningRpcRequests[rqid];
+	rq_info.shvPath = calling_node_shv_path;
+	rq_info.method = method;
+	m_rpcStatistics.recordRequest(params);
 	return rqid;
 }
 
+void ShvBrokerNodeItem::abortRpcRequest(int rqid)
+{
+	auto it = m_runningRpcRequests.find(rqid);
+	if(it == m_runningRpcRequests.end())
+		return;
+	rpcRequest::sendAbort(m_rpcConnection, rqid, it->second.shvPath, it->second.method);
+	// late response will not find the request and it will be dropped without processing
+	m_runningRpcRequests.erase(it);
+}
+
+cp::RpcValue ShvBrokerNodeItem::rpcStatisticsSnapshot() const
+{
+	return m_rpcStatistics.toRpcValue(m_runningRpcRequests.size());
+}
+
 void ShvBrokerNodeItem::onRpcMessageReceived(const shv::chainpack::RpcMessage &msg)
 {
 	if(msg.isResponse()) {
 		cp::RpcResponse resp(msg);
 		if (resp.delay().has_value()) {
-			// ignore delay messages
+			auto it = m_runningRpcRequests.find(resp.requestId().toInt());
+			if(it != m_runningRpcRequests.end()) {
+				it->second.lastActivityTS.start();
+				if(ShvNodeItem *nd = findNode(it->second.shvPath); nd) {
+					nd->processRpcMessage(msg);
+				}
+			}
 			return;
 		}
 		if(resp.isError())
@@ -432,6 +366,7 @@ void ShvBrokerNodeItem::onRpcMessageReceived(const shv::chainpack::RpcMessage &m
 			// can be load attributes request
 			return;
 		}
+		m_rpcStatistics.recordResponse(it->second.method, it->second.startTS.elapsed(), resp.isError(), resp.result());
 		const std::string &path = it->second.shvPath;
 		ShvNodeItem *nd = findNode(path);
 		if(nd) {
@@ -468,6 +403,7 @@ void ShvBrokerNodeItem::onRpcMessageReceived(const shv::chainpack::RpcMessage &m
 										   MetaMethod(Rpc::METH_APP_NAME, MetaMethod::Flag::IsGetter, {}, "String").toRpcValue(),
 										   MetaMethod(Rpc::METH_APP_VERSION, MetaMethod::Flag::IsGetter, {}, "String").toRpcValue(),
 										   MetaMethod(Rpc::METH_ECHO, MetaMethod::Flag::None, "RpcValue", "RpcValue", AccessLevel::Write).toRpcValue(),
+										   MetaMethod(METH_RPC_STATISTICS, MetaMethod::Flag::IsGetter, {}, "Map").toRpcValue(),
 									   });
 						break;
 					}
@@ -483,6 +419,10 @@ void ShvBrokerNodeItem::onRpcMessageReceived(const shv::chainpack::RpcMessage &m
 						resp.setResult(rq.params());
 						break;
 					}
+					if(method == METH_RPC_STATISTICS) {
+						resp.setResult(rpcStatisticsSnapshot());
+						break;
+					}
 				}
 				SHV_EXCEPTION("Invalid method: " + method + " on path: " + shv_path);
 			} while (false);
@@ -505,40 +445,7 @@ void ShvBrokerNodeItem::onRpcMessageReceived(const shv::chainpack::RpcMessage &m
 
 void ShvBrokerNodeItem::checkShvApiVersion(QObject *context, std::function<void ()> on_success, std::function<void (const shv::chainpack::RpcError &)> on_error)
 {
-	auto *rpc_call = shv::iotqt::rpc::RpcCall::create(m_rpcConnection)->setShvPath(".broker")->setMethod("ls");
-	connect(rpc_call, &shv::iotqt::rpc::RpcCall::maybeResult, context, [this, on_success, on_error](const ::shv::chainpack::RpcValue &result, const shv::chainpack::RpcError &error) {
-		if (error.isValid()) {
-			if (on_error) {
-				on_error(error);
-			}
-			else {
-				shvError() << "SHV API version discovery error:" << error.toString();
-			}
-		}
-		else {
-			using ShvApiVersion = shv::iotqt::rpc::ClientConnection::ShvApiVersion;
-			const auto &dirs = result.asList();
-			if (std::find(dirs.begin(), dirs.end(), "app") != dirs.end()) {
-				shvInfo() << "Setting SHV API to ver 2";
-				m_rpcConnection->setShvApiVersion(ShvApiVersion::V2);
-				on_success();
-			}
-			else if (std::find(dirs.begin(), dirs.end(), "client") != dirs.end()) {
-				shvInfo() << "Setting SHV API to ver 3";
-				m_rpcConnection->setShvApiVersion(ShvApiVersion::V3);
-				on_success();
-			}
-			else {
-				if (on_error) {
-					on_error(error);
-				}
-				else {
-					shvError() << "SHV API version cannot be discovered from ls result.";
-				}
-			}
-		}
-	});
-	rpc_call->start();
+	brokerConnection::checkShvApiVersion(m_rpcConnection, context, std::move(on_success), std::move(on_error));
 }
 
 void ShvBrokerNodeItem::createSubscriptions()
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "shvnodeitem.h"
+#include "rpcstatistics.h"
 
 //#include <shv/chainpack/rpcvalue.h>
 
@@ -44,11 +45,17 @@ public:
 	shv::iotqt::rpc::ClientConnection *clientConnection();
 
 	int callNodeRpcMethod(const std::string &calling_node_shv_path, const std::string &method, const shv::chainpack::RpcValue &params, const RequestUserID req_user_id, bool throw_exc = false);
+	void abortRpcRequest(int rqid);
 
 	ShvNodeItem *findNode(const std::string &path);
 
 	int brokerId() const { return m_brokerId; }
 
+	RpcStatistics& rpcStatistics() { return m_rpcStatistics; }
+	const RpcStatistics& rpcStatistics() const { return m_rpcStatistics; }
+	size_t runningRpcRequestCount() const { return m_runningRpcRequests.size(); }
+	shv::chainpack::RpcValue rpcStatisticsSnapshot() const;
+
 	Q_SIGNAL void subscriptionAdded(const std::string &path, const std::string &method, const std::string& source);
 	Q_SIGNAL void subscriptionAddError(const std::string &shv_path, const std::string &error_msg);
 
@@ -69,6 +76,7 @@ private:
 	OpenStatus m_openStatus = OpenStatus::Disconnected;
 	struct RpcRequestInfo;
 	std::map<int, RpcRequestInfo> m_runningRpcRequests;
+	RpcStatistics m_rpcStatistics;
 	std::string m_shvRoot;
 	int m_brokerLoginErrorCount = 0;
 };
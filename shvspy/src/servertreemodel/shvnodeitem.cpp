@@ -1,7 +1,8 @@
 #include "shvnodeitem.h"
 #include "shvbrokernodeitem.h"
 #include "servertreemodel.h"
-//#include "../theapp.h"
+#include "../theapp.h"
+#include "../callhistory.h"
 
 #include <shv/iotqt/rpc/clientconnection.h>
 #include <shv/chainpack/cponreader.h>
@@ -10,6 +11,7 @@
 
 #include <shv/core/assert.h>
 
+#include <QDateTime>
 #include <QIcon>
 #include <QVariant>
 
@@ -186,12 +188,19 @@ void ShvNodeItem::processRpcMessage(const shv::chainpack::RpcMessage &msg)
 {
 	if(msg.isResponse()) {
 		RpcResponse resp(msg);
-		if (resp.delay().has_value()) {
-			// Ignore delay messages for now, they should prolongue method call timeout,
-			// but it is also not implemented yet.
+		int rqid = resp.requestId().toInt();
+		if (auto delay = resp.delay(); delay.has_value()) {
+			// request timeout is prolonged by broker node, just show the progress
+			for (int i = 0; i < m_methods.count(); ++i) {
+				ShvMetaMethod &mtd = m_methods[i];
+				if(mtd.rpcRequestId == rqid) {
+					mtd.progress = delay;
+					emit rpcMethodCallProgress(i);
+					break;
+				}
+			}
 			return;
 		}
-		int rqid = resp.requestId().toInt();
 		if(rqid == m_loadChildrenRqId) {
 			m_loadChildrenRqId = 0;
 			m_childrenLoaded = true;
@@ -225,7 +234,20 @@ void ShvNodeItem::processRpcMessage(const shv::chainpack::RpcMessage &msg)
 				ShvMetaMethod &mtd = m_methods[i];
 				if(mtd.rpcRequestId == rqid) {
 					mtd.rpcRequestId = 0;
+					mtd.progress.reset();
 					mtd.response = resp;
+					mtd.history.append(resp, mtd.rpcCallTimer.elapsed());
+					if (auto params = CallHistory::paramsToCpon(mtd.params); params.has_value()) {
+						TheApp::instance()->callHistory()->record(CallHistory::Entry{
+							serverNode()->nodeId(),
+							shvPath(),
+							mtd.metamethod.name(),
+							std::move(params.value()),
+							QDateTime::currentMSecsSinceEpoch() - mtd.rpcCallTimer.elapsed(),
+							mtd.rpcCallTimer.elapsed(),
+							resp.isError()? -1: CallHistory::resultSize(resp.result()),
+						});
+					}
 					emit rpcMethodCallFinished(i);
 					break;
 				}
@@ -291,12 +313,29 @@ unsigned ShvNodeItem::callMethod(int method_ix, bool throw_exc)
 	if(mtd.metamethod.name().empty() || (mtd.isSignal() && !mtd.isGetter()))
 		return 0;
 	mtd.response = RpcResponse();
+	mtd.progress.reset();
 	ShvBrokerNodeItem *srv_nd = serverNode();
 	auto request_user_id = (mtd.metamethod.flags() & shv::chainpack::MetaMethod::Flag::UserIDRequired) != 0 ? RequestUserID::Yes : RequestUserID::No;
+	mtd.rpcCallTimer.start();
 	mtd.rpcRequestId = srv_nd->callNodeRpcMethod(shvPath(), mtd.metamethod.name(), mtd.params, request_user_id, throw_exc);
 	return mtd.rpcRequestId;
 }
 
+void ShvNodeItem::abortMethodCall(int method_ix)
+{
+	if(method_ix < 0 || method_ix >= m_methods.count())
+		return;
+	ShvMetaMethod &mtd = m_methods[method_ix];
+	if(mtd.rpcRequestId == 0)
+		return;
+	serverNode()->abortRpcRequest(mtd.rpcRequestId);
+	mtd.rpcRequestId = 0;
+	mtd.progress.reset();
+	mtd.response = RpcResponse();
+	mtd.response.setError(RpcResponse::Error::create(RpcResponse::Error::MethodCallCancelled, "Method call aborted."));
+	emit rpcMethodCallFinished(method_ix);
+}
+
 void ShvNodeItem::reload()
 {
 	deleteChildren();
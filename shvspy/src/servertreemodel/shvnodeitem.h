@@ -1,14 +1,19 @@
 #pragma once
 
+#include "methodcallhistory.h"
+
 #include <shv/core/utils.h>
 #include <shv/chainpack/rpcmessage.h>
 #include <shv/chainpack/rpcvalue.h>
 #include <shv/chainpack/metamethod.h>
 
+#include <QElapsedTimer>
 #include <QObject>
 #include <QVector>
 #include <QVariant>
 
+#include <optional>
+
 class ShvBrokerNodeItem;
 class ServerTreeModel;
 
@@ -19,6 +24,10 @@ struct ShvMetaMethod
 	shv::chainpack::RpcValue params;
 	shv::chainpack::RpcResponse response;
 	int rpcRequestId = 0;
+	/// progress of running call reported by peer in delay responses, 0 - 1
+	std::optional<double> progress;
+	QElapsedTimer rpcCallTimer;
+	MethodCallHistory history;
 
 	std::string flagsStr() const;
 	std::string accessLevelStr() const;
@@ -56,6 +65,7 @@ public:
 	const QVector<ShvMetaMethod>& methods() const {return m_methods;}
 	void setMethodParams(int method_ix, const shv::chainpack::RpcValue &params);
 	unsigned callMethod(int method_ix, bool throw_exc = false);
+	void abortMethodCall(int method_ix);
 
 	void reload();
 
@@ -74,6 +84,7 @@ public:
 	Q_SIGNAL void methodsLoaded();
 
 	Q_SIGNAL void rpcMethodCallFinished(int method_ix);
+	Q_SIGNAL void rpcMethodCallProgress(int method_ix);
 
 	void processRpcMessage(const shv::chainpack::RpcMessage &msg);
 protected:
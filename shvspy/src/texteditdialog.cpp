@@ -1,15 +1,29 @@
 #include "texteditdialog.h"
 #include "ui_texteditdialog.h"
+#include "cponreformatter.h"
+#include "cponvalidator.h"
+#include "hexview.h"
+#include "textview.h"
 
-#include <shv/chainpack/rpcvalue.h>
-
+#include <QFile>
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QProgressDialog>
 #include <QPushButton>
+#include <QScrollBar>
 #include <QSettings>
+#include <QTemporaryFile>
+#include <QTextBlock>
+#include <QTextStream>
+#include <QThread>
 #include <QTimer>
 
-namespace cp = shv::chainpack;
+#include <algorithm>
+
+namespace {
+// search is started after user stops typing
+constexpr int SEARCH_DELAY_MSEC = 300;
+}
 
 //=========================================================
 // TextEditDialog
@@ -17,6 +31,8 @@ namespace cp = shv::chainpack;
 TextEditDialog::TextEditDialog(QWidget *parent)
 	: Super(parent)
 	, ui(new Ui::TextEditDialog)
+	, m_textSearch(new TextSearch(this))
+	, m_searchTimer(new QTimer(this))
 {
 	ui->setupUi(this);
 	ui->lblError->hide();
@@ -30,13 +46,31 @@ TextEditDialog::TextEditDialog(QWidget *parent)
 
 	ui->plainTextEdit->setFocus();
 	ui->searchWidget->hide();
+	ui->chkSearchHex->hide();
 	ui->plainTextEdit->installEventFilter(this);
 	ui->searchEdit->installEventFilter(this);
 	installEventFilter(this);
-	connect(ui->closeToolButton, &QToolButton::clicked, ui->searchWidget, &QWidget::hide);
+	connect(ui->closeToolButton, &QToolButton::clicked, this, &TextEditDialog::hideSearch);
 	connect(ui->nextToolButton, &QToolButton::clicked, this, &TextEditDialog::search);
 	connect(ui->prevToolButton, &QToolButton::clicked, this, &TextEditDialog::searchBack);
 	connect(ui->btSaveToFile, &QPushButton::clicked, this, &TextEditDialog::saveToFile);
+
+	// all matches are indexed shortly after the search text changes, F3 then only steps through them
+	m_searchTimer->setSingleShot(true);
+	m_searchTimer->setInterval(SEARCH_DELAY_MSEC);
+	connect(m_searchTimer, &QTimer::timeout, this, &TextEditDialog::startTextSearch);
+	connect(ui->searchEdit, &QLineEdit::textEdited, m_searchTimer, QOverload<>::of(&QTimer::start));
+	connect(ui->chkSearchRegExp, &QCheckBox::toggled, m_searchTimer, QOverload<>::of(&QTimer::start));
+	connect(m_textSearch, &TextSearch::finished, this, &TextEditDialog::onTextSearchFinished);
+	connect(ui->plainTextEdit, &QPlainTextEdit::textChanged, this, [this]() {
+		m_textSearch->clear();
+		m_currentMatch = -1;
+		updateSearchHighlights();
+		if (!ui->searchWidget->isHidden()) {
+			m_searchTimer->start();
+		}
+	});
+	connect(ui->plainTextEdit->verticalScrollBar(), &QScrollBar::valueChanged, this, &TextEditDialog::updateSearchHighlights);
 }
 
 TextEditDialog::~TextEditDialog()
@@ -46,11 +80,14 @@ TextEditDialog::~TextEditDialog()
 	delete ui;
 }
 
-void TextEditDialog::setText(const QString &s)
-{
-	ui->plainTextEdit->setPlainText(s);
-}
 namespace {
+constexpr qsizetype REFORMAT_CHUNK_SIZE = 1024 * 1024;
+
+// larger read-only text is shown in TextView, QPlainTextEdit layout does not scale to hundreds of MB
+constexpr qsizetype TEXT_EDIT_MAX_SIZE = 4 * 1024 * 1024;
+// large data is recognized as text by its beginning, validating all of it would block GUI
+constexpr qsizetype TEXT_SAMPLE_SIZE = 1024 * 1024;
+
 bool is_valid_utf8(const QByteArray& data)
 {
 	auto* bytes = reinterpret_cast<const unsigned char*>(data.data());
@@ -83,20 +120,144 @@ bool is_valid_utf8(const QByteArray& data)
 
 	return true;
 }
+
+bool is_text_sample(const QByteArray &sample)
+{
+	if (sample.contains('\0')) {
+		return false;
+	}
+	// sample can end in the middle of multibyte character
+	for (qsizetype cut = 0; cut < 4 && cut < sample.size(); ++cut) {
+		if (is_valid_utf8(sample.left(sample.size() - cut))) {
+			return true;
+		}
+	}
+	return false;
 }
+}
+
+void TextEditDialog::setText(const QString &s)
+{
+	if (ui->plainTextEdit->isReadOnly() && s.size() > TEXT_EDIT_MAX_SIZE) {
+		setBlob(s.toUtf8());
+		return;
+	}
+	ui->plainTextEdit->setPlainText(s);
+}
+
 void TextEditDialog::setBlob(const QByteArray &s)
 {
 	m_blobData = s;
-	if (is_valid_utf8(s)) {
+	if (s.size() <= TEXT_EDIT_MAX_SIZE && is_valid_utf8(s)) {
 		ui->plainTextEdit->setPlainText(QString::fromUtf8(s));
 	}
+	else if (s.size() > TEXT_EDIT_MAX_SIZE && is_text_sample(s.left(TEXT_SAMPLE_SIZE))) {
+		textView()->setData(s);
+		showTextView();
+	}
 	else {
-		ui->plainTextEdit->setPlainText(tr("Binary data"));
+		hexView()->setData(s);
+		showHexView();
 	}
 }
 
+bool TextEditDialog::setBlobFile(const QString &file_name)
+{
+	m_blobData.clear();
+	QFile file(file_name);
+	if (!file.open(QFile::ReadOnly)) {
+		ui->plainTextEdit->setPlainText(tr("Cannot open file %1: %2").arg(file_name, file.errorString()));
+		return false;
+	}
+	if (file.size() <= TEXT_EDIT_MAX_SIZE) {
+		if (auto data = file.readAll(); is_valid_utf8(data)) {
+			ui->plainTextEdit->setPlainText(QString::fromUtf8(data));
+			return true;
+		}
+	}
+	else if (is_text_sample(file.read(TEXT_SAMPLE_SIZE))) {
+		auto *text_view = textView();
+		if (!text_view->setFile(file_name)) {
+			ui->plainTextEdit->setPlainText(tr("Cannot open file %1: %2").arg(file_name, text_view->errorString()));
+			return false;
+		}
+		showTextView();
+		return true;
+	}
+	auto *hex_view = hexView();
+	if (!hex_view->setFile(file_name)) {
+		ui->plainTextEdit->setPlainText(tr("Cannot open file %1: %2").arg(file_name, hex_view->errorString()));
+		return false;
+	}
+	showHexView();
+	return true;
+}
+
+HexView *TextEditDialog::hexView()
+{
+	if (!m_hexView) {
+		m_hexView = new HexView(this);
+		m_hexView->hide();
+		m_hexView->installEventFilter(this);
+		ui->verticalLayout_2->insertWidget(ui->verticalLayout_2->indexOf(ui->plainTextEdit) + 1, m_hexView);
+	}
+	return m_hexView;
+}
+
+void TextEditDialog::showHexView()
+{
+	ui->plainTextEdit->hide();
+	ui->chkSearchHex->show();
+	ui->chkSearchHex->setChecked(true);
+	ui->chkSearchRegExp->hide();
+	ui->lblSearchStatus->clear();
+	m_hexView->show();
+	m_hexView->setFocus();
+}
+
+bool TextEditDialog::isHexViewVisible() const
+{
+	return m_hexView && !m_hexView->isHidden();
+}
+
+TextView *TextEditDialog::textView()
+{
+	if (!m_textView) {
+		m_textView = new TextView(this);
+		m_textView->hide();
+		m_textView->installEventFilter(this);
+		ui->verticalLayout_2->insertWidget(ui->verticalLayout_2->indexOf(ui->plainTextEdit) + 1, m_textView);
+	}
+	return m_textView;
+}
+
+void TextEditDialog::showTextView()
+{
+	ui->plainTextEdit->hide();
+	ui->chkSearchRegExp->hide();
+	ui->lblSearchStatus->clear();
+	m_textView->show();
+	m_textView->setFocus();
+}
+
+bool TextEditDialog::isTextViewVisible() const
+{
+	return m_textView && !m_textView->isHidden();
+}
+
+QByteArray TextEditDialog::searchPattern() const
+{
+	if (ui->chkSearchHex->isChecked()) {
+		return QByteArray::fromHex(ui->searchEdit->text().toLatin1());
+	}
+	return ui->searchEdit->text().toUtf8();
+}
+
 QString TextEditDialog::text() const
 {
+	if (isTextViewVisible()) {
+		return QString::fromUtf8(m_textView->data());
+	}
 	return ui->plainTextEdit->toPlainText();
 }
 
@@ -109,13 +270,17 @@ void TextEditDialog::setReadOnly(bool ro)
 
 bool TextEditDialog::eventFilter(QObject *o, QEvent *e)
 {
+	if (o == ui->plainTextEdit && e->type() == QEvent::Resize) {
+		updateSearchHighlights();
+	}
 	if (e->type() == QEvent::KeyPress) {
 		auto *ke = static_cast<QKeyEvent *>(e);
-		if (o == ui->plainTextEdit || o == this) {
+		if (o == ui->plainTextEdit || o == this || (m_hexView && o == m_hexView) || (m_textView && o == m_textView)) {
 			if ((ke->key() == Qt::Key_F && ke->modifiers() == Qt::CTRL) ||
 				(ke->key() == Qt::Key_Slash && ke->modifiers() == Qt::NoModifier && ui->plainTextEdit->isReadOnly())) {
 				ui->searchWidget->show();
 				ui->searchEdit->setFocus();
+				updateSearchHighlights();
 				return true;
 			}
 		}
@@ -123,6 +288,12 @@ bool TextEditDialog::eventFilter(QObject *o, QEvent *e)
 			if ((ke->key() == Qt::Key_Enter || ke->key() == Qt::Key_Return)) {
 				if (ui->searchEdit->isModified()) {
 					ui->plainTextEdit->moveCursor(QTextCursor::MoveOperation::Start);
+					if (m_hexView) {
+						m_hexView->clearSelection();
+					}
+					if (m_textView) {
+						m_textView->clearSelection();
+					}
 					ui->searchEdit->setModified(false);
 				}
 				switch (ke->modifiers()) {
@@ -137,7 +308,7 @@ bool TextEditDialog::eventFilter(QObject *o, QEvent *e)
 				}
 			}
 			if (ke->key() == Qt::Key_Escape && ke->modifiers() == Qt::NoModifier) {
-				ui->searchWidget->hide();
+				hideSearch();
 				return true;
 			}
 			if (ke->key() == Qt::Key_F3) {
@@ -155,14 +326,177 @@ bool TextEditDialog::eventFilter(QObject *o, QEvent *e)
 	return Super::eventFilter(o, e);
 }
 
+namespace {
+// HexView and TextView search raw bytes from current selection
+template<typename View>
+void find_in_view(View *view, const QByteArray &pattern, bool backward)
+{
+	qint64 offset;
+	if (backward) {
+		offset = view->findBackward(pattern, view->selectionStart() < 0? view->size(): view->selectionStart());
+	}
+	else {
+		offset = view->find(pattern, view->selectionStart() + 1);
+	}
+	if (offset >= 0) {
+		view->setSelection(offset, pattern.size());
+	}
+}
+}
+
 void TextEditDialog::search()
 {
-	ui->plainTextEdit->find(ui->searchEdit->text());
+	if (isHexViewVisible()) {
+		find_in_view(m_hexView, searchPattern(), false);
+	}
+	else if (isTextViewVisible()) {
+		find_in_view(m_textView, searchPattern(), false);
+	}
+	else {
+		goToMatch(false);
+	}
 }
 
 void TextEditDialog::searchBack()
 {
-	ui->plainTextEdit->find(ui->searchEdit->text(), QTextDocument::FindFlag::FindBackward);
+	if (isHexViewVisible()) {
+		find_in_view(m_hexView, searchPattern(), true);
+	}
+	else if (isTextViewVisible()) {
+		find_in_view(m_textView, searchPattern(), true);
+	}
+	else {
+		goToMatch(true);
+	}
+}
+
+TextSearch::Options TextEditDialog::textSearchOptions() const
+{
+	TextSearch::Options options;
+	options.pattern = ui->searchEdit->text();
+	options.isRegExp = ui->chkSearchRegExp->isChecked();
+	return options;
+}
+
+void TextEditDialog::hideSearch()
+{
+	ui->searchWidget->hide();
+	updateSearchHighlights();
+}
+
+void TextEditDialog::startTextSearch()
+{
+	m_searchTimer->stop();
+	if (ui->plainTextEdit->isHidden()) {
+		return;
+	}
+	m_currentMatch = -1;
+	m_textSearch->start(text(), textSearchOptions());
+	updateSearchStatus();
+}
+
+void TextEditDialog::onTextSearchFinished()
+{
+	updateSearchStatus();
+	updateSearchHighlights();
+	if (m_pendingMatchStep != 0) {
+		const bool backward = m_pendingMatchStep < 0;
+		m_pendingMatchStep = 0;
+		goToMatch(backward);
+	}
+}
+
+void TextEditDialog::goToMatch(bool backward)
+{
+	if (!m_textSearch->isStartedFor(textSearchOptions())) {
+		startTextSearch();
+	}
+	if (m_textSearch->isRunning()) {
+		m_pendingMatchStep = backward? -1: 1;
+		return;
+	}
+	const auto &matches = m_textSearch->matches();
+	if (matches.empty()) {
+		updateSearchStatus();
+		return;
+	}
+	const int n = static_cast<int>(matches.size());
+	QTextCursor cursor = ui->plainTextEdit->textCursor();
+	const bool is_on_current_match = m_currentMatch >= 0 && m_currentMatch < n
+			&& cursor.selectionStart() == matches[static_cast<size_t>(m_currentMatch)].position
+			&& cursor.selectionEnd() == matches[static_cast<size_t>(m_currentMatch)].position + matches[static_cast<size_t>(m_currentMatch)].length;
+	if (is_on_current_match) {
+		m_currentMatch = (m_currentMatch + (backward? n - 1: 1)) % n;
+	}
+	else if (backward) {
+		m_currentMatch = m_textSearch->previousMatch(cursor.selectionStart());
+	}
+	else {
+		m_currentMatch = m_textSearch->nextMatch(cursor.hasSelection()? cursor.selectionStart() + 1: cursor.position());
+	}
+	const auto &match = matches[static_cast<size_t>(m_currentMatch)];
+	cursor.setPosition(static_cast<int>(match.position));
+	cursor.setPosition(static_cast<int>(match.position + match.length), QTextCursor::KeepAnchor);
+	ui->plainTextEdit->setTextCursor(cursor);
+	updateSearchStatus();
+}
+
+void TextEditDialog::updateSearchStatus()
+{
+	QString status;
+	if (ui->searchEdit->text().isEmpty() || !m_textSearch->isStartedFor(textSearchOptions())) {
+		status = QString();
+	}
+	else if (m_textSearch->isRunning()) {
+		status = tr("Searching ...");
+	}
+	else if (!m_textSearch->errorString().isEmpty()) {
+		status = m_textSearch->errorString();
+	}
+	else if (m_textSearch->matches().empty()) {
+		status = tr("No match");
+	}
+	else {
+		auto count = QString::number(m_textSearch->matches().size()) + (m_textSearch->isTruncated()? QStringLiteral("+"): QString());
+		status = m_currentMatch < 0? tr("%1 matches").arg(count): tr("%1 of %2").arg(m_currentMatch + 1).arg(count);
+	}
+	ui->lblSearchStatus->setText(status);
+}
+
+void TextEditDialog::updateSearchHighlights()
+{
+	m_searchSelections.clear();
+	if (!ui->searchWidget->isHidden() && !m_textSearch->isRunning() && m_textSearch->isStartedFor(textSearchOptions())) {
+		// only matches in viewport are highlighted, there can be millions of them in the document
+		auto *edit = ui->plainTextEdit;
+		const QTextBlock first_block = edit->cursorForPosition(QPoint(0, 0)).block();
+		const QTextBlock last_block = edit->cursorForPosition(QPoint(edit->viewport()->width() - 1, edit->viewport()->height() - 1)).block();
+		const auto [first, last] = m_textSearch->matchesInRange(first_block.position(), last_block.position() + last_block.length());
+		QTextCharFormat format;
+		format.setBackground(QColor(255, 255, 0, 128));
+		const auto &matches = m_textSearch->matches();
+		for (int i = first; i < last; ++i) {
+			const auto &match = matches[static_cast<size_t>(i)];
+			QTextEdit::ExtraSelection selection;
+			selection.cursor = QTextCursor(edit->document());
+			selection.cursor.setPosition(static_cast<int>(match.position));
+			selection.cursor.setPosition(static_cast<int>(match.position + match.length), QTextCursor::KeepAnchor);
+			selection.format = format;
+			m_searchSelections << selection;
+		}
+	}
+	applyExtraSelections();
+}
+
+void TextEditDialog::setErrorSelections(const QList<QTextEdit::ExtraSelection> &selections)
+{
+	m_errorSelections = selections;
+	applyExtraSelections();
+}
+
+void TextEditDialog::applyExtraSelections()
+{
+	ui->plainTextEdit->setExtraSelections(m_searchSelections + m_errorSelections);
 }
 
 void TextEditDialog::saveToFile()
@@ -177,6 +511,13 @@ void TextEditDialog::saveToFile()
 		if (!m_blobData.isEmpty()) {
 			f.write(m_blobData);
 		}
+		else if (m_textView && m_textView->size() > 0) {
+			// written straight from mapped file
+			f.write(m_textView->data());
+		}
+		else if (m_hexView && m_hexView->size() > 0) {
+			f.write(m_hexView->data());
+		}
 		else {
 			f.write(text().toUtf8());
 		}
@@ -192,59 +533,225 @@ CponEditDialog::CponEditDialog(QWidget *parent)
 	ui->btFormatCpon->show();
 	ui->btCompactCpon->show();
 
-	connect(ui->plainTextEdit, &QPlainTextEdit::textChanged, this, &CponEditDialog::validateContentDeferred);
 	connect(ui->btCompactCpon, &QPushButton::clicked, this, &CponEditDialog::onBtCompactCponClicked);
 	connect(ui->btFormatCpon, &QPushButton::clicked, this, &CponEditDialog::onBtFormatCponClicked);
 }
 
-void CponEditDialog::setValidateContent(bool b)
+CponEditDialog::~CponEditDialog()
 {
-	m_isValidateContent = b;
+	if (m_reformatThread) {
+		*m_reformatCancelled = true;
+		m_reformatThread->wait();
+		delete m_reformatThread;
+	}
 }
 
-void CponEditDialog::validateContentDeferred()
+void CponEditDialog::setValidateContent(bool b)
 {
-	if(!m_isValidateContent)
-		return;
-	if(!m_validateTimer) {
-		m_validateTimer = new QTimer(this);
-		m_validateTimer->setSingleShot(true);
-		m_validateTimer->setInterval(1000);
-		connect(m_validateTimer, &QTimer::timeout, this, &CponEditDialog::validateContent);
+	if (b && !m_validator) {
+		m_validator = new CponValidator(ui->plainTextEdit->document(), this);
+		connect(m_validator, &CponValidator::validated, this, &CponEditDialog::showValidationResult);
+	}
+	else if (!b && m_validator) {
+		delete m_validator;
+		m_validator = nullptr;
+		showValidationResult({}, -1, -1);
 	}
-	m_validateTimer->start();
 }
 
-cp::RpcValue CponEditDialog::validateContent()
+void CponEditDialog::showValidationResult(const QString &error, int line, int column)
 {
-	QString txt = text().trimmed();
-	std::string err;
-	cp::RpcValue rv = cp::RpcValue::fromCpon(txt.toStdString(), &err);
-	if(txt.isEmpty() || err.empty()) {
+	QList<QTextEdit::ExtraSelection> selections;
+	if (error.isEmpty()) {
 		ui->lblError->setVisible(false);
-		return rv;
 	}
+	else {
+		ui->lblError->setText(tr("Malformed Cpon at line %1, column %2: %3").arg(line + 1).arg(column + 1).arg(error));
+		ui->lblError->setVisible(true);
 
-	ui->lblError->setText(tr("Malformed Cpon: ") + QString::fromStdString(err));
-	ui->lblError->setVisible(true);
-	return cp::RpcValue();
+		QTextCursor cursor(ui->plainTextEdit->document()->findBlockByNumber(line));
+		QTextEdit::ExtraSelection line_selection;
+		line_selection.cursor = cursor;
+		line_selection.format.setBackground(QColor(255, 0, 0, 40));
+		line_selection.format.setProperty(QTextFormat::FullWidthSelection, true);
+		selections << line_selection;
+
+		QTextEdit::ExtraSelection error_selection;
+		cursor.movePosition(QTextCursor::Right, QTextCursor::MoveAnchor, column);
+		cursor.movePosition(QTextCursor::Right, QTextCursor::KeepAnchor);
+		error_selection.cursor = cursor;
+		error_selection.format.setUnderlineStyle(QTextCharFormat::WaveUnderline);
+		error_selection.format.setUnderlineColor(Qt::red);
+		selections << error_selection;
+	}
+	setErrorSelections(selections);
 }
 
 void CponEditDialog::onBtCompactCponClicked()
 {
-	shv::chainpack::RpcValue rv = validateContent();
-	if(rv.isValid()) {
-		std::string cpon = rv.toCpon();
-		setText(QString::fromStdString(cpon));
-	}
+	reformatContent(false);
 }
 
 void CponEditDialog::onBtFormatCponClicked()
 {
-	shv::chainpack::RpcValue rv = validateContent();
-	if(rv.isValid()) {
-		std::string cpon = rv.toCpon("  ");
-		setText(QString::fromStdString(cpon));
+	reformatContent(true);
+}
+
+void CponEditDialog::reformatContent(bool is_pretty)
+{
+	if (m_reformatThread) {
+		return;
 	}
+	auto *output_file = new QTemporaryFile(this);
+	if (!output_file->open()) {
+		ui->lblError->setText(tr("Cannot create temporary file: %1").arg(output_file->errorString()));
+		ui->lblError->setVisible(true);
+		delete output_file;
+		return;
+	}
+	// worker writes it through its own QFile
+	output_file->close();
+	m_reformatFile = output_file;
+	ui->btCompactCpon->setEnabled(false);
+	ui->btFormatCpon->setEnabled(false);
+	auto cancelled = std::make_shared<std::atomic_bool>(false);
+	m_reformatCancelled = cancelled;
+	m_reformatProgress = new QProgressDialog(is_pretty? tr("Formatting Cpon ..."): tr("Compacting Cpon ..."), tr("Cancel"), 0, 100, this);
+	m_reformatProgress->setMinimumDuration(500);
+	connect(m_reformatProgress, &QProgressDialog::canceled, this, [cancelled]() {
+		*cancelled = true;
+	});
+	auto *progress_dlg = m_reformatProgress;
+	// text view data is read in place, editor text has to be copied once, worker cannot read QTextDocument
+	const bool is_text_view = isTextViewVisible();
+	const QByteArray utf8_input = is_text_view? m_textView->data(): QByteArray();
+	const QString text_input = is_text_view? QString(): ui->plainTextEdit->toPlainText();
+	// text is formatted in chunks without building RpcValue, first pass only validates it, so malformed input
+	// is reported and the document is left as it is, second pass writes formatted chunks to temporary file
+	m_reformatThread = QThread::create([this, is_text_view, utf8_input, text_input, output_file_name = output_file->fileName(), is_pretty, cancelled, progress_dlg]() {
+		const qsizetype input_size = is_text_view? utf8_input.size(): text_input.size();
+		QFile output(output_file_name);
+		QString error;
+		int last_percent = 0;
+		for (int pass = 0; pass < 2 && error.isEmpty(); ++pass) {
+			const bool is_writing = pass == 1;
+			if (is_writing && !output.open(QFile::WriteOnly | QFile::Truncate)) {
+				error = output.errorString();
+				break;
+			}
+			CponReformatter reformatter(is_pretty);
+			std::string out;
+			bool ok = true;
+			for (qsizetype pos = 0; ok && pos < input_size; ) {
+				if (*cancelled) {
+					return;
+				}
+				auto n = std::min<qsizetype>(REFORMAT_CHUNK_SIZE, input_size - pos);
+				out.clear();
+				if (is_text_view) {
+					// reformatter works on bytes, UTF-8 sequence split between chunks is fine
+					ok = reformatter.feed(utf8_input.constData() + pos, static_cast<size_t>(n), out);
+				}
+				else {
+					if (pos + n < input_size && text_input.at(pos + n - 1).isHighSurrogate()) {
+						n--;
+					}
+					const QByteArray chunk = QStringView(text_input).mid(pos, n).toUtf8();
+					ok = reformatter.feed(chunk.constData(), static_cast<size_t>(chunk.size()), out);
+				}
+				pos += n;
+				if (ok && is_writing && output.write(out.data(), static_cast<qint64>(out.size())) != static_cast<qint64>(out.size())) {
+					error = output.errorString();
+					break;
+				}
+				if (int percent = static_cast<int>((pass * input_size + pos) * 50 / input_size); percent != last_percent) {
+					last_percent = percent;
+					QMetaObject::invokeMethod(progress_dlg, [progress_dlg, percent]() {
+						progress_dlg->setValue(percent);
+					}, Qt::QueuedConnection);
+				}
+			}
+			if (!error.isEmpty()) {
+				break;
+			}
+			out.clear();
+			ok = ok && reformatter.finish(out);
+			if (!ok) {
+				error = tr("Malformed Cpon: ") + QString::fromStdString(reformatter.errorString());
+			}
+			else if (is_writing && output.write(out.data(), static_cast<qint64>(out.size())) != static_cast<qint64>(out.size())) {
+				error = output.errorString();
+			}
+		}
+		output.close();
+		QMetaObject::invokeMethod(this, [this, error, cancelled]() {
+			if (*cancelled) {
+				return;
+			}
+			if (error.isEmpty()) {
+				loadReformattedContent();
+			}
+			else {
+				ui->lblError->setText(error);
+				ui->lblError->setVisible(true);
+			}
+		}, Qt::QueuedConnection);
+	});
+	connect(m_reformatThread, &QThread::finished, this, [this]() {
+		m_reformatThread->deleteLater();
+		m_reformatThread = nullptr;
+		m_reformatProgress->deleteLater();
+		m_reformatProgress = nullptr;
+		// not taken by loadReformattedContent() when reformat failed or was cancelled
+		delete m_reformatFile;
+		m_reformatFile = nullptr;
+		ui->btCompactCpon->setEnabled(true);
+		ui->btFormatCpon->setEnabled(true);
+	});
+	m_reformatThread->start();
 }
 
+void CponEditDialog::loadReformattedContent()
+{
+	QTemporaryFile *file = m_reformatFile;
+	m_reformatFile = nullptr;
+	m_blobData.clear();
+	if (isTextViewVisible() || (ui->plainTextEdit->isReadOnly() && file->size() > TEXT_EDIT_MAX_SIZE)) {
+		// text view maps the file, it is kept until next reformat or dialog close
+		if (!textView()->setFile(file->fileName())) {
+			ui->lblError->setText(tr("Cannot open file %1: %2").arg(file->fileName(), m_textView->errorString()));
+			ui->lblError->setVisible(true);
+			delete file;
+			return;
+		}
+		showTextView();
+		delete m_reformattedFile;
+		m_reformattedFile = file;
+		return;
+	}
+	if (!file->open()) {
+		ui->lblError->setText(tr("Cannot open file %1: %2").arg(file->fileName(), file->errorString()));
+		ui->lblError->setVisible(true);
+		delete file;
+		return;
+	}
+	// document is rebuilt chunk by chunk, so formatted text is never held in memory as a whole,
+	// undo stack would keep whole old text, so it is cleared like by setPlainText()
+	QTextDocument *doc = ui->plainTextEdit->document();
+	doc->setUndoRedoEnabled(false);
+	QTextCursor cursor(doc);
+	cursor.beginEditBlock();
+	cursor.select(QTextCursor::Document);
+	cursor.removeSelectedText();
+	QTextStream in(file);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+	in.setCodec("UTF-8");
+#endif
+	while (!in.atEnd()) {
+		cursor.insertText(in.read(REFORMAT_CHUNK_SIZE));
+	}
+	cursor.endEditBlock();
+	doc->setUndoRedoEnabled(true);
+	ui->plainTextEdit->moveCursor(QTextCursor::Start);
+	delete file;
+}
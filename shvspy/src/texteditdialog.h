@@ -1,8 +1,20 @@
 #pragma once
 
+#include "textsearch.h"
+
 #include <QDialog>
+#include <QTextEdit>
+
+#include <atomic>
+#include <memory>
 
-namespace shv::chainpack { class RpcValue; }
+class CponValidator;
+class HexView;
+class TextView;
+class QProgressDialog;
+class QTemporaryFile;
+class QThread;
+class QTimer;
 
 namespace Ui {
 class TextEditDialog;
@@ -19,6 +31,8 @@ public:
 
 	void setText(const QString &s);
 	void setBlob(const QByteArray &s);
+	/// Shows file content, large or binary files are mapped to memory and shown in hex view.
+	bool setBlobFile(const QString &file_name);
 	QString text() const;
 
 	void setReadOnly(bool ro);
@@ -27,9 +41,37 @@ protected:
 	void search();
 	void searchBack();
 	void saveToFile();
+	HexView* hexView();
+	void showHexView();
+	bool isHexViewVisible() const;
+	TextView* textView();
+	void showTextView();
+	bool isTextViewVisible() const;
+	QByteArray searchPattern() const;
+	/// Selections marking errors, they are shown together with search highlights.
+	void setErrorSelections(const QList<QTextEdit::ExtraSelection> &selections);
 
 	Ui::TextEditDialog *ui;
 	QByteArray m_blobData;
+	HexView *m_hexView = nullptr;
+	TextView *m_textView = nullptr;
+private:
+	TextSearch::Options textSearchOptions() const;
+	void hideSearch();
+	void startTextSearch();
+	void onTextSearchFinished();
+	void goToMatch(bool backward);
+	void updateSearchStatus();
+	void updateSearchHighlights();
+	void applyExtraSelections();
+private:
+	TextSearch *m_textSearch;
+	QTimer *m_searchTimer;
+	int m_currentMatch = -1;
+	/// Navigation requested before search finished, 1 forward, -1 backward.
+	int m_pendingMatchStep = 0;
+	QList<QTextEdit::ExtraSelection> m_errorSelections;
+	QList<QTextEdit::ExtraSelection> m_searchSelections;
 };
 
 class CponEditDialog : public TextEditDialog
@@ -39,15 +81,23 @@ class CponEditDialog : public TextEditDialog
 	using Super = TextEditDialog;
 public:
 	explicit CponEditDialog(QWidget *parent = nullptr);
+	~CponEditDialog() override;
 
 	void setValidateContent(bool b);
 private slots:
 	void onBtCompactCponClicked();
 	void onBtFormatCponClicked();
 private:
-	void validateContentDeferred();
-	shv::chainpack::RpcValue validateContent();
+	void showValidationResult(const QString &error, int line, int column);
+	void reformatContent(bool is_pretty);
+	void loadReformattedContent();
 private:
-	bool m_isValidateContent = false;
-	QTimer *m_validateTimer = nullptr;
+	CponValidator *m_validator = nullptr;
+	QThread *m_reformatThread = nullptr;
+	QProgressDialog *m_reformatProgress = nullptr;
+	/// Output of running reformat.
+	QTemporaryFile *m_reformatFile = nullptr;
+	/// Reformatted content mapped by text view.
+	QTemporaryFile *m_reformattedFile = nullptr;
+	std::shared_ptr<std::atomic_bool> m_reformatCancelled;
 };
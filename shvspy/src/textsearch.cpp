@@ -0,0 +1,190 @@
+#include "textsearch.h"
+
+#include <QRegularExpression>
+#include <QStringMatcher>
+#include <QThread>
+
+#include <algorithm>
+
+namespace {
+// cancellation is checked after every window, regular expression matches cannot span windows
+constexpr qsizetype SEARCH_WINDOW_SIZE = 1024 * 1024;
+constexpr size_t MAX_MATCH_COUNT = 1000 * 1000;
+
+struct SearchResult
+{
+	std::vector<TextSearch::Match> matches;
+	bool isTruncated = false;
+	QString errorString;
+};
+
+bool add_match(SearchResult &result, qsizetype position, qsizetype length)
+{
+	if (result.matches.size() >= MAX_MATCH_COUNT) {
+		result.isTruncated = true;
+		return false;
+	}
+	result.matches.push_back(TextSearch::Match{position, length});
+	return true;
+}
+
+bool find_plain(const QString &text, const QString &pattern, const std::atomic_bool &cancelled, SearchResult &result)
+{
+	// Boyer-Moore matcher, Qt compares UTF-16 with SIMD where the CPU supports it
+	const QStringMatcher matcher(pattern, Qt::CaseInsensitive);
+	const qsizetype size = text.size();
+	const qsizetype pattern_size = pattern.size();
+	qsizetype from = 0;
+	while (from <= size - pattern_size) {
+		if (cancelled) {
+			return false;
+		}
+		const qsizetype window_end = std::min(size, from + SEARCH_WINDOW_SIZE);
+		// only matches starting before window end are found
+		const qsizetype window_size = std::min(size, window_end + pattern_size - 1);
+		const qsizetype pos = matcher.indexIn(text.constData(), window_size, from);
+		if (pos < 0) {
+			from = window_end;
+			continue;
+		}
+		if (!add_match(result, pos, pattern_size)) {
+			break;
+		}
+		from = pos + pattern_size;
+	}
+	return true;
+}
+
+bool find_regexp(const QString &text, const QString &pattern, const std::atomic_bool &cancelled, SearchResult &result)
+{
+	const QRegularExpression rx(pattern, QRegularExpression::CaseInsensitiveOption);
+	if (!rx.isValid()) {
+		result.errorString = rx.errorString();
+		return true;
+	}
+	const qsizetype size = text.size();
+	qsizetype from = 0;
+	while (from < size) {
+		if (cancelled) {
+			return false;
+		}
+		// windows end at line end, so only multi-line matches can be missed
+		qsizetype window_end = text.indexOf('\n', std::min(size - 1, from + SEARCH_WINDOW_SIZE));
+		window_end = window_end < 0? size: window_end + 1;
+		auto it = rx.globalMatch(text.mid(from, window_end - from));
+		while (it.hasNext()) {
+			const auto m = it.next();
+			if (m.capturedLength() > 0 && !add_match(result, from + m.capturedStart(), m.capturedLength())) {
+				return true;
+			}
+		}
+		from = window_end;
+	}
+	return true;
+}
+
+bool match_position_less(const TextSearch::Match &m, qsizetype position)
+{
+	return m.position < position;
+}
+}
+
+TextSearch::TextSearch(QObject *parent)
+	: Super(parent)
+{
+}
+
+TextSearch::~TextSearch()
+{
+	cancel();
+}
+
+void TextSearch::cancel()
+{
+	if (m_thread) {
+		*m_cancelled = true;
+		m_thread->wait();
+		m_thread = nullptr;
+	}
+}
+
+void TextSearch::clear()
+{
+	cancel();
+	m_generation++;
+	m_isStarted = false;
+	m_options = {};
+	m_matches.clear();
+	m_isTruncated = false;
+	m_errorString.clear();
+}
+
+void TextSearch::start(const QString &text, const Options &options)
+{
+	clear();
+	m_isStarted = true;
+	m_options = options;
+	if (options.pattern.isEmpty()) {
+		emit finished();
+		return;
+	}
+	auto cancelled = std::make_shared<std::atomic_bool>(false);
+	m_cancelled = cancelled;
+	const int generation = m_generation;
+	m_thread = QThread::create([this, text, options, cancelled, generation]() {
+		SearchResult result;
+		const bool is_complete = options.isRegExp
+				? find_regexp(text, options.pattern, *cancelled, result)
+				: find_plain(text, options.pattern, *cancelled, result);
+		if (!is_complete) {
+			return;
+		}
+		QMetaObject::invokeMethod(this, [this, result = std::move(result), generation]() mutable {
+			if (generation != m_generation) {
+				return;
+			}
+			// posting the result is the last thing worker does, so isRunning() must be false in finished() handlers
+			if (m_thread) {
+				m_thread->wait();
+				m_thread = nullptr;
+			}
+			m_matches = std::move(result.matches);
+			m_isTruncated = result.isTruncated;
+			m_errorString = result.errorString;
+			emit finished();
+		}, Qt::QueuedConnection);
+	});
+	m_thread->setParent(this);
+	connect(m_thread, &QThread::finished, this, [this, thread = m_thread]() {
+		if (m_thread == thread) {
+			m_thread = nullptr;
+		}
+		thread->deleteLater();
+	});
+	m_thread->start();
+}
+
+int TextSearch::nextMatch(qsizetype position) const
+{
+	if (m_matches.empty()) {
+		return -1;
+	}
+	auto it = std::lower_bound(m_matches.cbegin(), m_matches.cend(), position, match_position_less);
+	return it == m_matches.cend()? 0: static_cast<int>(it - m_matches.cbegin());
+}
+
+int TextSearch::previousMatch(qsizetype position) const
+{
+	if (m_matches.empty()) {
+		return -1;
+	}
+	auto it = std::lower_bound(m_matches.cbegin(), m_matches.cend(), position, match_position_less);
+	return it == m_matches.cbegin()? static_cast<int>(m_matches.size()) - 1: static_cast<int>(it - m_matches.cbegin()) - 1;
+}
+
+std::pair<int, int> TextSearch::matchesInRange(qsizetype from, qsizetype to) const
+{
+	auto first = std::lower_bound(m_matches.cbegin(), m_matches.cend(), from, match_position_less);
+	auto last = std::lower_bound(first, m_matches.cend(), to, match_position_less);
+	return {static_cast<int>(first - m_matches.cbegin()), static_cast<int>(last - m_matches.cbegin())};
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class QThread;
+
+/// Finds all pattern matches in text on worker thread. Matches are sorted by position,
+/// so stepping through them is constant time and matches in visible range are found by bisection.
+class TextSearch : public QObject
+{
+	Q_OBJECT
+
+	using Super = QObject;
+public:
+	struct Options
+	{
+		QString pattern;
+		bool isRegExp = false;
+
+		bool operator==(const Options &o) const {return pattern == o.pattern && isRegExp == o.isRegExp;}
+		bool operator!=(const Options &o) const {return !(*this == o);}
+	};
+	struct Match
+	{
+		qsizetype position;
+		qsizetype length;
+	};
+
+	explicit TextSearch(QObject *parent = nullptr);
+	~TextSearch() override;
+
+	/// Cancels running search and starts new one over text.
+	void start(const QString &text, const Options &options);
+	void clear();
+
+	bool isRunning() const {return m_thread != nullptr;}
+	/// True when matches for options are available or being searched.
+	bool isStartedFor(const Options &options) const {return m_isStarted && m_options == options;}
+	QString errorString() const {return m_errorString;}
+	const std::vector<Match>& matches() const {return m_matches;}
+	/// Search stopped at MAX_MATCH_COUNT matches.
+	bool isTruncated() const {return m_isTruncated;}
+
+	/// Index of first match at or after position, wraps to the first one, -1 when there is no match.
+	int nextMatch(qsizetype position) const;
+	/// Index of last match before position, wraps to the last one, -1 when there is no match.
+	int previousMatch(qsizetype position) const;
+	/// Indexes [first, last) of matches starting in range [from, to).
+	std::pair<int, int> matchesInRange(qsizetype from, qsizetype to) const;
+
+	Q_SIGNAL void finished();
+private:
+	void cancel();
+private:
+	QThread *m_thread = nullptr;
+	std::shared_ptr<std::atomic_bool> m_cancelled;
+	int m_generation = 0;
+	bool m_isStarted = false;
+	Options m_options;
+	std::vector<Match> m_matches;
+	bool m_isTruncated = false;
+	QString m_errorString;
+};
@@ -0,0 +1,297 @@
+#include "textview.h"
+#include "bytesearch.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QFontDatabase>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QThread>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+// line index is published in batches, so the view can be scrolled while indexing continues
+constexpr qint64 INDEX_BATCH_SIZE = 16 * 1024 * 1024;
+// longer lines are painted truncated
+constexpr qint64 MAX_PAINTED_LINE_LENGTH = 64 * 1024;
+constexpr int TAB_SIZE = 4;
+}
+
+TextView::TextView(QWidget *parent)
+	: Super(parent)
+{
+	setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+	setFocusPolicy(Qt::StrongFocus);
+}
+
+TextView::~TextView()
+{
+	cancelIndexing();
+}
+
+void TextView::cancelIndexing()
+{
+	m_generation++;
+	if (m_indexThread) {
+		*m_indexCancelled = true;
+		m_indexThread->wait();
+		m_indexThread = nullptr;
+	}
+}
+
+void TextView::reset()
+{
+	// worker reads the data, it must be stopped before data is released
+	cancelIndexing();
+	m_file.close();
+	m_data.clear();
+	m_bytes = nullptr;
+	m_size = 0;
+	m_errorString.clear();
+	m_lineStarts.clear();
+	m_maxLineLength = 0;
+	m_selectionStart = -1;
+	m_selectionSize = 0;
+}
+
+void TextView::setData(const QByteArray &data)
+{
+	reset();
+	m_data = data;
+	m_bytes = m_data.constData();
+	m_size = m_data.size();
+	startIndexing();
+}
+
+bool TextView::setFile(const QString &file_name)
+{
+	reset();
+	if (!m_file.open(file_name)) {
+		m_errorString = m_file.errorString();
+		return false;
+	}
+	m_bytes = m_file.data();
+	m_size = m_file.size();
+	startIndexing();
+	return true;
+}
+
+QByteArray TextView::data() const
+{
+	if (!m_data.isEmpty()) {
+		return m_data;
+	}
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+	return QByteArray::fromRawData(m_bytes, static_cast<int>(m_size));
+#else
+	return QByteArray::fromRawData(m_bytes, m_size);
+#endif
+}
+
+void TextView::startIndexing()
+{
+	if (m_size > 0) {
+		m_lineStarts.push_back(0);
+	}
+	verticalScrollBar()->setValue(0);
+	horizontalScrollBar()->setValue(0);
+	updateScrollBars();
+	viewport()->update();
+	if (m_size == 0) {
+		return;
+	}
+	auto cancelled = std::make_shared<std::atomic_bool>(false);
+	m_indexCancelled = cancelled;
+	const int generation = m_generation;
+	m_indexThread = QThread::create([this, bytes = m_bytes, size = m_size, cancelled, generation]() {
+		qint64 line_start = 0;
+		qint64 pos = 0;
+		while (pos < size) {
+			if (*cancelled) {
+				return;
+			}
+			std::vector<qint64> line_starts;
+			qint64 max_line_length = 0;
+			const qint64 batch_end = std::min(size, pos + INDEX_BATCH_SIZE);
+			while (pos < batch_end) {
+				const auto *nl = static_cast<const char*>(std::memchr(bytes + pos, '\n', static_cast<size_t>(batch_end - pos)));
+				if (!nl) {
+					pos = batch_end;
+					break;
+				}
+				pos = nl - bytes + 1;
+				max_line_length = std::max(max_line_length, pos - 1 - line_start);
+				line_start = pos;
+				if (pos < size) {
+					line_starts.push_back(pos);
+				}
+			}
+			// line not terminated yet counts as well, so it can be scrolled to
+			max_line_length = std::max(max_line_length, pos - line_start);
+			QMetaObject::invokeMethod(this, [this, line_starts = std::move(line_starts), max_line_length, generation]() {
+				if (generation != m_generation) {
+					return;
+				}
+				m_lineStarts.insert(m_lineStarts.end(), line_starts.cbegin(), line_starts.cend());
+				m_maxLineLength = std::max(m_maxLineLength, max_line_length);
+				updateScrollBars();
+				viewport()->update();
+			}, Qt::QueuedConnection);
+		}
+	});
+	m_indexThread->setParent(this);
+	connect(m_indexThread, &QThread::finished, this, [this, thread = m_indexThread]() {
+		if (m_indexThread == thread) {
+			m_indexThread = nullptr;
+			emit indexingFinished();
+		}
+		thread->deleteLater();
+	});
+	m_indexThread->start();
+}
+
+qint64 TextView::find(const QByteArray &pattern, qint64 from) const
+{
+	return byteSearch::find(m_bytes, m_size, pattern, from);
+}
+
+qint64 TextView::findBackward(const QByteArray &pattern, qint64 from) const
+{
+	return byteSearch::findBackward(m_bytes, m_size, pattern, from);
+}
+
+qint64 TextView::lineAt(qint64 offset) const
+{
+	auto it = std::upper_bound(m_lineStarts.cbegin(), m_lineStarts.cend(), offset);
+	return std::max<qint64>(it - m_lineStarts.cbegin() - 1, 0);
+}
+
+std::pair<qint64, qint64> TextView::lineRange(qint64 line) const
+{
+	const qint64 start = m_lineStarts[static_cast<size_t>(line)];
+	qint64 end = m_size;
+	if (line + 1 < lineCount()) {
+		end = m_lineStarts[static_cast<size_t>(line + 1)] - 1;
+	}
+	else if (const auto *nl = static_cast<const char*>(std::memchr(m_bytes + start, '\n', static_cast<size_t>(m_size - start)))) {
+		// last indexed line while indexing is still running
+		end = nl - m_bytes;
+	}
+	if (end > start && m_bytes[end - 1] == '\r') {
+		end--;
+	}
+	return {start, end};
+}
+
+QString TextView::decode(qint64 from, qint64 to) const
+{
+	auto s = QString::fromUtf8(m_bytes + from, static_cast<int>(std::min(to - from, MAX_PAINTED_LINE_LENGTH)));
+	s.replace(QLatin1Char('\t'), QString(TAB_SIZE, QLatin1Char(' ')));
+	return s;
+}
+
+void TextView::setSelection(qint64 offset, qint64 size)
+{
+	m_selectionStart = offset;
+	m_selectionSize = offset < 0? 0: size;
+	if (offset >= 0 && !m_lineStarts.empty()) {
+		auto *sb = verticalScrollBar();
+		auto line = lineAt(offset);
+		if (line < sb->value() || line >= sb->value() + sb->pageStep()) {
+			sb->setValue(static_cast<int>(std::min<qint64>(std::max<qint64>(line - sb->pageStep() / 2, 0), sb->maximum())));
+		}
+		auto *hsb = horizontalScrollBar();
+		const int x = QFontMetrics(font()).horizontalAdvance(decode(m_lineStarts[static_cast<size_t>(line)], offset));
+		if (x < hsb->value() || x >= hsb->value() + viewport()->width()) {
+			hsb->setValue(std::max(x - viewport()->width() / 3, 0));
+		}
+	}
+	viewport()->update();
+}
+
+void TextView::updateScrollBars()
+{
+	QFontMetrics fm(font());
+	auto page = std::max(viewport()->height() / fm.height(), 1);
+	auto lines = std::min<qint64>(lineCount(), std::numeric_limits<int>::max());
+	verticalScrollBar()->setRange(0, std::max(static_cast<int>(lines) - page, 0));
+	verticalScrollBar()->setPageStep(page);
+	auto width = std::min<qint64>(std::min(m_maxLineLength, MAX_PAINTED_LINE_LENGTH) * fm.horizontalAdvance(QLatin1Char('0')), std::numeric_limits<int>::max());
+	horizontalScrollBar()->setRange(0, std::max(static_cast<int>(width) - viewport()->width(), 0));
+	horizontalScrollBar()->setPageStep(viewport()->width());
+}
+
+void TextView::resizeEvent(QResizeEvent *event)
+{
+	Super::resizeEvent(event);
+	updateScrollBars();
+}
+
+void TextView::paintEvent(QPaintEvent *event)
+{
+	Q_UNUSED(event)
+	QPainter painter(viewport());
+	QFontMetrics fm(font());
+	const int line_height = fm.height();
+	const qint64 selection_end = m_selectionStart + m_selectionSize;
+
+	painter.translate(-horizontalScrollBar()->value(), 0);
+	const qint64 first_line = verticalScrollBar()->value();
+	const int visible_lines = viewport()->height() / line_height + 1;
+	for (int i = 0; i < visible_lines; ++i) {
+		const qint64 line = first_line + i;
+		if (line >= lineCount()) {
+			break;
+		}
+		const auto [start, end] = lineRange(line);
+		const int y = i * line_height;
+		if (m_selectionStart < end && selection_end > start) {
+			const qint64 sel_from = std::max(m_selectionStart, start);
+			const qint64 sel_to = std::min(selection_end, end);
+			const int x1 = fm.horizontalAdvance(decode(start, sel_from));
+			const int x2 = x1 + fm.horizontalAdvance(decode(sel_from, sel_to));
+			painter.fillRect(x1, y, x2 - x1, line_height, palette().highlight());
+		}
+		painter.drawText(0, y + fm.ascent(), decode(start, end));
+	}
+}
+
+void TextView::mousePressEvent(QMouseEvent *event)
+{
+	if (event->button() == Qt::LeftButton && !m_lineStarts.empty()) {
+		// click selects whole line, so it can be copied
+		const qint64 line = verticalScrollBar()->value() + event->pos().y() / QFontMetrics(font()).height();
+		if (line < lineCount()) {
+			const auto [start, end] = lineRange(line);
+			setSelection(start, end - start);
+		}
+		else {
+			clearSelection();
+		}
+	}
+	Super::mousePressEvent(event);
+}
+
+void TextView::keyPressEvent(QKeyEvent *event)
+{
+	if (event->matches(QKeySequence::Copy)) {
+		if (m_selectionStart >= 0) {
+			QApplication::clipboard()->setText(QString::fromUtf8(m_bytes + m_selectionStart, static_cast<int>(std::min<qint64>(m_selectionSize, std::numeric_limits<int>::max()))));
+		}
+		return;
+	}
+	if (event->key() == Qt::Key_Home && event->modifiers() == Qt::ControlModifier) {
+		verticalScrollBar()->setValue(0);
+		return;
+	}
+	if (event->key() == Qt::Key_End && event->modifiers() == Qt::ControlModifier) {
+		verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+		return;
+	}
+	Super::keyPressEvent(event);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "mappedfile.h"
+
+#include <QAbstractScrollArea>
+#include <QByteArray>
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class QThread;
+
+/// Read-only view of large UTF-8 text, for example logs of hundreds of MB.
+/// Text is kept as bytes held in memory or mapped from file, line start offsets are indexed
+/// on worker thread and only visible lines are decoded and painted.
+class TextView : public QAbstractScrollArea
+{
+	Q_OBJECT
+
+	using Super = QAbstractScrollArea;
+public:
+	explicit TextView(QWidget *parent = nullptr);
+	~TextView() override;
+
+	/// Data is shared, not copied.
+	void setData(const QByteArray &data);
+	bool setFile(const QString &file_name);
+	QString errorString() const {return m_errorString;}
+
+	qint64 size() const {return m_size;}
+	/// Data is not copied, it is valid as long as the view.
+	QByteArray data() const;
+	/// Lines indexed so far, the count grows until indexing is finished.
+	qint64 lineCount() const {return static_cast<qint64>(m_lineStarts.size());}
+	bool isIndexing() const {return m_indexThread != nullptr;}
+
+	/// Returns offset of the first pattern occurrence at or after from, or -1.
+	qint64 find(const QByteArray &pattern, qint64 from) const;
+	/// Returns offset of the last pattern occurrence before from, or -1.
+	qint64 findBackward(const QByteArray &pattern, qint64 from) const;
+
+	qint64 selectionStart() const {return m_selectionStart;}
+	qint64 selectionSize() const {return m_selectionSize;}
+	void setSelection(qint64 offset, qint64 size);
+	void clearSelection() {setSelection(-1, 0);}
+
+	Q_SIGNAL void indexingFinished();
+protected:
+	void paintEvent(QPaintEvent *event) override;
+	void resizeEvent(QResizeEvent *event) override;
+	void mousePressEvent(QMouseEvent *event) override;
+	void keyPressEvent(QKeyEvent *event) override;
+private:
+	void reset();
+	void cancelIndexing();
+	void startIndexing();
+	void updateScrollBars();
+	qint64 lineAt(qint64 offset) const;
+	/// Line byte range without line end characters.
+	std::pair<qint64, qint64> lineRange(qint64 line) const;
+	QString decode(qint64 from, qint64 to) const;
+private:
+	QByteArray m_data;
+	MappedFile m_file;
+	const char *m_bytes = nullptr;
+	qint64 m_size = 0;
+	QString m_errorString;
+	std::vector<qint64> m_lineStarts;
+	qint64 m_maxLineLength = 0;
+	QThread *m_indexThread = nullptr;
+	std::shared_ptr<std::atomic_bool> m_indexCancelled;
+	int m_generation = 0;
+	qint64 m_selectionStart = -1;
+	qint64 m_selectionSize = 0;
+};
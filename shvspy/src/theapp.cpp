@@ -2,11 +2,14 @@
 #include "servertreemodel/servertreemodel.h"
 #include "attributesmodel/attributesmodel.h"
 #include "log/rpcnotificationsmodel.h"
+#include "transfermanager.h"
+#include "callhistory.h"
 
 #include <shv/coreqt/log.h>
 #include <shv/visu/errorlogmodel.h>
 
 #include <QSettings>
+#include <QStandardPaths>
 #ifdef Q_OS_WIN
 #include <QStyleFactory>
 #endif
@@ -14,7 +17,6 @@
 TheApp::TheApp(int &argc, char **argv, AppCliOptions *cli_opts)
 	: Super(argc, argv)
 	, m_cliOptions(cli_opts)
-	, m_crypt(shv::core::utils::Crypt::createGenerator(17456, 3148, 2147483647))
 {
 #ifdef Q_OS_WIN
 	// set default style to fusion to overcome ugly look on some Windows installations
@@ -28,11 +30,19 @@ TheApp::TheApp(int &argc, char **argv, AppCliOptions *cli_opts)
 	m_serverTreeModel = new ServerTreeModel(this);
 	m_attributesModel = new AttributesModel(this);
 	m_rpcNotificationsModel = new RpcNotificationsModel(this);
+	m_transferManager = new TransferManager(this);
+	m_callHistory = new CallHistory(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/callhistory.chpk", this);
 	m_errorLogModel = new shv::visu::ErrorLogModel(this);
 }
 
 TheApp::~TheApp() = default;
 
+const shv::core::utils::Crypt& TheApp::crypt()
+{
+	static const shv::core::utils::Crypt crypt(shv::core::utils::Crypt::createGenerator(17456, 3148, 2147483647));
+	return crypt;
+}
+
 void TheApp::saveSettings(QSettings &settings)
 {
 	m_serverTreeModel->saveSettings(settings);
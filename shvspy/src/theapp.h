@@ -10,6 +10,8 @@
 class ServerTreeModel;
 class AttributesModel;
 class RpcNotificationsModel;
+class TransferManager;
+class CallHistory;
 class AppCliOptions;
 class QSettings;
 
@@ -30,8 +32,11 @@ public:
 	ServerTreeModel* serverTreeModel() {return m_serverTreeModel;}
 	AttributesModel* attributesModel() {return m_attributesModel;}
 	RpcNotificationsModel* rpcNotificationsModel() {return m_rpcNotificationsModel;}
+	TransferManager* transferManager() {return m_transferManager;}
+	CallHistory* callHistory() {return m_callHistory;}
 	shv::visu::ErrorLogModel* errorLogModel() {return m_errorLogModel;}
-	const shv::core::utils::Crypt& crypt() {return m_crypt;}
+	/// Available without application instance, headless mode decrypts passwords of saved connections.
+	static const shv::core::utils::Crypt& crypt();
 
 	void saveSettings(QSettings &settings);
 
@@ -40,9 +45,10 @@ private:
 	ServerTreeModel *m_serverTreeModel = nullptr;
 	AttributesModel *m_attributesModel = nullptr;
 	RpcNotificationsModel *m_rpcNotificationsModel = nullptr;
+	TransferManager *m_transferManager = nullptr;
+	CallHistory *m_callHistory = nullptr;
 	shv::visu::ErrorLogModel *m_errorLogModel = nullptr;
 	AppCliOptions* m_cliOptions = nullptr;
-	shv::core::utils::Crypt m_crypt;
 };
 
 #endif // THEAPP_H
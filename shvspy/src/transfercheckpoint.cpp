@@ -0,0 +1,137 @@
+#include "transfercheckpoint.h"
+
+#include <shv/chainpack/rpcvalue.h>
+#include <shv/coreqt/log.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+namespace cp = shv::chainpack;
+
+namespace {
+constexpr qint64 HASH_READ_BLOCK_SIZE = 1024 * 1024;
+constexpr qint64 SAVE_INTERVAL_MSEC = 1000;
+
+const auto KEY_KEY = "key";
+const auto KEY_SIZE = "size";
+const auto KEY_OFFSET = "offset";
+const auto KEY_SHA1 = "sha1";
+}
+
+TransferCheckpoint::TransferCheckpoint(const QString &key)
+	: m_key(key)
+	, m_hash(QCryptographicHash::Sha1)
+{
+}
+
+QString TransferCheckpoint::fileName() const
+{
+	auto id = QCryptographicHash::hash(m_key.toUtf8(), QCryptographicHash::Sha1).toHex();
+	return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/transfers/" + QString::fromLatin1(id) + ".cpon";
+}
+
+void TransferCheckpoint::reset()
+{
+	m_offset = 0;
+	m_hash.reset();
+	m_confirmedChunks.clear();
+}
+
+bool TransferCheckpoint::restore(qint64 file_size)
+{
+	reset();
+	m_fileSize = file_size;
+	if (m_key.isEmpty() || !m_localReader) {
+		return false;
+	}
+	QFile f(fileName());
+	if (!f.open(QFile::ReadOnly)) {
+		return false;
+	}
+	std::string err;
+	auto rv = cp::RpcValue::fromCpon(f.readAll().toStdString(), &err);
+	if (!err.empty() || !rv.isMap()) {
+		shvWarning() << "Invalid transfer checkpoint:" << f.fileName() << err;
+		return false;
+	}
+	const auto &m = rv.asMap();
+	qint64 offset = m.value(KEY_OFFSET).toInt64();
+	if (m.value(KEY_KEY).asString() != m_key.toStdString() || m.value(KEY_SIZE).toInt64() != file_size || offset <= 0 || offset > file_size) {
+		return false;
+	}
+	for (qint64 pos = 0; pos < offset; pos += HASH_READ_BLOCK_SIZE) {
+		auto size = std::min(HASH_READ_BLOCK_SIZE, offset - pos);
+		auto data = m_localReader(pos, size);
+		if (data.size() != size) {
+			reset();
+			return false;
+		}
+		m_hash.addData(data);
+	}
+	if (m_hash.result().toHex().toStdString() != m.value(KEY_SHA1).asString()) {
+		shvInfo() << "Transfer checkpoint hash mismatch, starting from zero:" << m_key;
+		reset();
+		return false;
+	}
+	m_offset = offset;
+	shvInfo() << "Resuming transfer:" << m_key << "from offset:" << m_offset;
+	return true;
+}
+
+void TransferCheckpoint::confirm(qint64 offset, qint64 size)
+{
+	if (offset + size <= m_offset) {
+		return;
+	}
+	m_confirmedChunks[offset] = size;
+	for (auto it = m_confirmedChunks.begin(); it != m_confirmedChunks.end() && it->first <= m_offset; it = m_confirmedChunks.erase(it)) {
+		auto end = it->first + it->second;
+		if (end > m_offset) {
+			if (m_localReader) {
+				m_hash.addData(m_localReader(m_offset, end - m_offset));
+			}
+			m_offset = end;
+		}
+	}
+	if (!m_key.isEmpty() && (!m_lastSave.isValid() || m_lastSave.elapsed() > SAVE_INTERVAL_MSEC)) {
+		save();
+	}
+}
+
+void TransferCheckpoint::save()
+{
+	if (m_key.isEmpty() || m_offset == 0) {
+		return;
+	}
+	m_lastSave.start();
+	auto file_name = fileName();
+	QDir().mkpath(QFileInfo(file_name).absolutePath());
+	cp::RpcValue::Map m;
+	m[KEY_KEY] = m_key.toStdString();
+	m[KEY_SIZE] = static_cast<int64_t>(m_fileSize);
+	m[KEY_OFFSET] = static_cast<int64_t>(m_offset);
+	m[KEY_SHA1] = m_hash.result().toHex().toStdString();
+	QFile f(file_name);
+	if (!f.open(QFile::WriteOnly | QFile::Truncate)) {
+		shvWarning() << "Cannot write transfer checkpoint:" << file_name << f.errorString();
+		return;
+	}
+	f.write(QByteArray::fromStdString(cp::RpcValue(m).toCpon()));
+}
+
+void TransferCheckpoint::remove()
+{
+	if (!m_key.isEmpty()) {
+		QFile::remove(fileName());
+	}
+}
+
+void TransferCheckpoint::discard()
+{
+	remove();
+	reset();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QString>
+
+#include <functional>
+#include <map>
+
+/// Confirmed contiguous prefix of a file transfer together with SHA1 of its content.
+/// Chunks can be confirmed in any order, prefix advances when the gap before them is filled.
+/// Checkpoint with non empty key is persisted, so the transfer can continue after restart.
+class TransferCheckpoint
+{
+public:
+	using LocalReader = std::function<QByteArray (qint64 offset, qint64 size)>;
+
+	explicit TransferCheckpoint(const QString &key = {});
+
+	void setKey(const QString &key) {m_key = key;}
+	void setLocalReader(LocalReader &&reader) {m_localReader = std::move(reader);}
+	const LocalReader& localReader() const {return m_localReader;}
+
+	/// Loads stored checkpoint and verifies that local content still matches its hash.
+	/// Returns false and starts from zero when there is nothing to resume.
+	bool restore(qint64 file_size);
+
+	qint64 offset() const {return m_offset;}
+	/// SHA1 of confirmed prefix, valid only with local reader set.
+	QByteArray sha1() const {return m_hash.result();}
+	void confirm(qint64 offset, qint64 size);
+	/// Forgets chunks confirmed beyond the contiguous prefix.
+	void rewind() {m_confirmedChunks.clear();}
+
+	void save();
+	void remove();
+	/// Removes stored checkpoint and starts from zero.
+	void discard();
+private:
+	QString fileName() const;
+	void reset();
+private:
+	QString m_key;
+	LocalReader m_localReader;
+	qint64 m_fileSize = 0;
+	qint64 m_offset = 0;
+	QCryptographicHash m_hash;
+	std::map<qint64, qint64> m_confirmedChunks;
+	QElapsedTimer m_lastSave;
+};
@@ -0,0 +1,340 @@
+#include "transfermanager.h"
+#include "fileloader.h"
+
+#include <shv/chainpack/rpc.h>
+#include <shv/chainpack/rpcvalue.h>
+#include <shv/core/utils.h>
+#include <shv/coreqt/log.h>
+#include <shv/iotqt/rpc/clientconnection.h>
+#include <shv/iotqt/rpc/rpccall.h>
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+
+namespace cp = shv::chainpack;
+
+namespace {
+constexpr int DEFAULT_MAX_CONCURRENT_PER_BROKER = 3;
+
+const auto Key_maxConcurrentPerBroker = QStringLiteral("transfers/maxConcurrentPerBroker");
+const auto Key_bandwidthLimit = QStringLiteral("transfers/bandwidthLimit");
+
+// remote node name becomes local file name, it must not escape target directory
+bool is_safe_file_name(const QString &name)
+{
+	return !name.isEmpty() && name != QLatin1String(".") && name != QLatin1String("..")
+			&& !name.contains('/') && !name.contains('\\');
+}
+}
+
+TransferManager::TransferManager(QObject *parent)
+	: Super(parent)
+{
+	QSettings settings;
+	m_maxConcurrentPerBroker = settings.value(Key_maxConcurrentPerBroker, DEFAULT_MAX_CONCURRENT_PER_BROKER).toInt();
+	m_bandwidthLimiter.setBytesPerSec(settings.value(Key_bandwidthLimit, 0).toLongLong());
+}
+
+void TransferManager::setMaxConcurrentPerBroker(int n)
+{
+	m_maxConcurrentPerBroker = std::max(n, 1);
+	QSettings().setValue(Key_maxConcurrentPerBroker, m_maxConcurrentPerBroker);
+	schedule();
+}
+
+void TransferManager::setBandwidthLimit(qint64 bytes_per_sec)
+{
+	m_bandwidthLimiter.setBytesPerSec(bytes_per_sec);
+	QSettings().setValue(Key_bandwidthLimit, m_bandwidthLimiter.bytesPerSec());
+}
+
+qint64 TransferManager::totalBytesPerSec() const
+{
+	qint64 ret = 0;
+	for (const auto &[id, transfer] : m_transfers) {
+		if (transfer.status == Status::Running) {
+			ret += transfer.bytesPerSec;
+		}
+	}
+	return ret;
+}
+
+void TransferManager::addDownload(shv::iotqt::rpc::ClientConnection *conn, const QString &broker_name, const QString &shv_path, const QString &local_path)
+{
+	Transfer transfer;
+	transfer.direction = Direction::Download;
+	transfer.connection = conn;
+	transfer.brokerName = broker_name;
+	transfer.shvPath = shv_path;
+	transfer.localPath = local_path;
+	addTransfer(std::move(transfer));
+}
+
+void TransferManager::addUpload(shv::iotqt::rpc::ClientConnection *conn, const QString &broker_name, const QString &local_path, const QString &shv_path)
+{
+	Transfer transfer;
+	transfer.direction = Direction::Upload;
+	transfer.connection = conn;
+	transfer.brokerName = broker_name;
+	transfer.shvPath = shv_path;
+	transfer.localPath = local_path;
+	addTransfer(std::move(transfer));
+}
+
+void TransferManager::addRemoteDirectory(shv::iotqt::rpc::ClientConnection *conn, const QString &broker_name, const QString &shv_path, const QString &local_dir)
+{
+	listDirectory(conn, broker_name, shv_path, local_dir, 0);
+}
+
+int TransferManager::addTransfer(Transfer &&transfer)
+{
+	int id = m_nextTransferId++;
+	m_transfers[id] = std::move(transfer);
+	emit transfersChanged();
+	schedule();
+	return id;
+}
+
+void TransferManager::listDirectory(shv::iotqt::rpc::ClientConnection *conn, const QString &broker_name, const QString &shv_path, const QString &local_dir, int depth)
+{
+	addListingRequest(ListingRequest{ListingRequest::Type::List, conn, broker_name, shv_path, local_dir, depth});
+}
+
+void TransferManager::addListingRequest(ListingRequest &&request)
+{
+	m_runningListingCount++;
+	m_listingQueue.push_back(std::move(request));
+	emit transfersChanged();
+	schedule();
+}
+
+void TransferManager::startListing(ListingRequest &&request)
+{
+	auto *conn = request.connection.data();
+	m_listingCalls[conn]++;
+	const int generation = m_listingGeneration;
+	auto *rpc_call = shv::iotqt::rpc::RpcCall::create(conn)->setShvPath(request.shvPath.toStdString());
+	if (request.type == ListingRequest::Type::List) {
+		rpc_call->setMethod(cp::Rpc::METH_LS);
+	}
+	else {
+		rpc_call->setMethod(cp::Rpc::METH_DIR)->setParams("read");
+	}
+	connect(rpc_call, &shv::iotqt::rpc::RpcCall::maybeResult, this, [this, conn, request = std::move(request), generation](const cp::RpcValue &result, const cp::RpcError &error) {
+		if (generation != m_listingGeneration) {
+			return;
+		}
+		m_runningListingCount--;
+		if (auto it = m_listingCalls.find(conn); it != m_listingCalls.end() && --it->second <= 0) {
+			m_listingCalls.erase(it);
+		}
+		if (request.type == ListingRequest::Type::Probe) {
+			onProbed(request, result, error.isValid()? QString::fromStdString(error.toString()): QString());
+		}
+		else if (error.isValid()) {
+			addListingError(tr("List directory %1 error: %2").arg(request.shvPath, QString::fromStdString(error.toString())));
+		}
+		else {
+			onListed(request, result);
+		}
+		emit transfersChanged();
+		schedule();
+	});
+	rpc_call->start();
+}
+
+void TransferManager::onListed(const ListingRequest &request, const cp::RpcValue &result)
+{
+	const auto local_dir = QDir::cleanPath(request.localPath);
+	const auto local_prefix = local_dir.endsWith('/')? local_dir: local_dir + '/';
+	for (const auto &child : result.asList()) {
+		auto name = QString::fromStdString(child.asString());
+		auto child_path = QString::fromStdString(shv::core::utils::joinPath(request.shvPath.toStdString(), name.toStdString()));
+		auto child_local_path = QDir::cleanPath(local_prefix + name);
+		if (!is_safe_file_name(name) || !child_local_path.startsWith(local_prefix)) {
+			addListingError(tr("List directory %1: node name '%2' is not valid local file name, skipped").arg(request.shvPath, name));
+			continue;
+		}
+		m_runningListingCount++;
+		m_listingQueue.push_back(ListingRequest{ListingRequest::Type::Probe, request.connection, request.brokerName, child_path, child_local_path, request.depth});
+	}
+}
+
+void TransferManager::onProbed(const ListingRequest &request, const cp::RpcValue &result, const QString &error)
+{
+	if (error.isEmpty() && AbstractFileLoader::isMethodPresent(result, "read")) {
+		addDownload(request.connection, request.brokerName, request.shvPath, request.localPath);
+	}
+	else if (request.depth < MAX_LIST_DEPTH) {
+		listDirectory(request.connection, request.brokerName, request.shvPath, request.localPath, request.depth + 1);
+	}
+	else {
+		addListingError(tr("List directory %1: nested deeper than %2 levels, skipped").arg(request.shvPath).arg(MAX_LIST_DEPTH));
+	}
+}
+
+void TransferManager::addListingError(const QString &error)
+{
+	shvWarning() << error;
+	if (m_listingErrors.size() >= MAX_LISTING_ERRORS) {
+		m_listingErrors.removeFirst();
+	}
+	m_listingErrors << error;
+}
+
+void TransferManager::schedule()
+{
+	if (m_isScheduling) {
+		m_isScheduleNeeded = true;
+		return;
+	}
+	m_isScheduling = true;
+	do {
+		m_isScheduleNeeded = false;
+		scheduleOnce();
+	} while (m_isScheduleNeeded);
+	m_isScheduling = false;
+}
+
+void TransferManager::scheduleOnce()
+{
+	std::map<shv::iotqt::rpc::ClientConnection*, int> running = m_listingCalls;
+	for (const auto &[id, transfer] : m_transfers) {
+		if (transfer.status == Status::Running) {
+			running[transfer.connection.data()]++;
+		}
+	}
+	// listing goes first, it finds files to be transferred
+	std::deque<ListingRequest> waiting;
+	while (!m_listingQueue.empty()) {
+		auto request = std::move(m_listingQueue.front());
+		m_listingQueue.pop_front();
+		if (!request.connection) {
+			m_runningListingCount--;
+			addListingError(tr("List directory %1: broker connection was removed.").arg(request.shvPath));
+			emit transfersChanged();
+			continue;
+		}
+		if (int &n = running[request.connection.data()]; n < m_maxConcurrentPerBroker) {
+			n++;
+			startListing(std::move(request));
+		}
+		else {
+			waiting.push_back(std::move(request));
+		}
+	}
+	m_listingQueue = std::move(waiting);
+	for (auto &[id, transfer] : m_transfers) {
+		if (transfer.status != Status::Queued) {
+			continue;
+		}
+		if (!transfer.connection) {
+			transfer.status = Status::Failed;
+			transfer.error = tr("Broker connection was removed.");
+			emit transfersChanged();
+			continue;
+		}
+		if (int &n = running[transfer.connection.data()]; n < m_maxConcurrentPerBroker) {
+			n++;
+			startTransfer(id);
+		}
+	}
+}
+
+void TransferManager::startTransfer(int id)
+{
+	Transfer &transfer = m_transfers.at(id);
+	AbstractFileLoader *loader = nullptr;
+	if (transfer.direction == Direction::Download) {
+		QDir().mkpath(QFileInfo(transfer.localPath).absolutePath());
+		auto *downloader = new FileDownloader(transfer.connection, transfer.shvPath, this);
+		downloader->setTargetFile(transfer.localPath);
+		loader = downloader;
+	}
+	else {
+		loader = new FileUploader(transfer.connection, transfer.shvPath, transfer.localPath, this);
+	}
+	loader->setBandwidthLimiter(&m_bandwidthLimiter);
+	loader->setBrokerName(transfer.brokerName);
+	connect(loader, &AbstractFileLoader::transferProgress, this, [this, id](qint64 bytes, qint64 total, qint64 bytes_per_sec) {
+		if (auto it = m_transfers.find(id); it != m_transfers.end()) {
+			it->second.bytes = bytes;
+			it->second.total = total;
+			it->second.bytesPerSec = bytes_per_sec;
+		}
+	});
+	connect(loader, &AbstractFileLoader::finished, this, [this, id](const QByteArray &, const QString &error) {
+		onTransferFinished(id, error);
+	});
+	transfer.loader = loader;
+	transfer.status = Status::Running;
+	emit transfersChanged();
+	loader->start();
+}
+
+void TransferManager::onTransferFinished(int id, const QString &error)
+{
+	if (auto it = m_transfers.find(id); it != m_transfers.end()) {
+		Transfer &transfer = it->second;
+		transfer.status = error.isEmpty()? Status::Finished: Status::Failed;
+		transfer.error = error;
+		transfer.bytesPerSec = 0;
+		if (!error.isEmpty()) {
+			shvWarning() << "File transfer:" << transfer.shvPath << "error:" << error;
+		}
+		emit transfersChanged();
+	}
+	schedule();
+}
+
+void TransferManager::abort(int id)
+{
+	auto it = m_transfers.find(id);
+	if (it == m_transfers.end()) {
+		return;
+	}
+	Transfer &transfer = it->second;
+	if (transfer.status == Status::Running && transfer.loader) {
+		transfer.loader->abort();
+	}
+	if (transfer.status == Status::Running || transfer.status == Status::Queued) {
+		transfer.status = Status::Aborted;
+		transfer.bytesPerSec = 0;
+		emit transfersChanged();
+		// next queued transfer can take the free slot
+		schedule();
+	}
+}
+
+void TransferManager::abortAll()
+{
+	m_listingGeneration++;
+	m_listingQueue.clear();
+	m_listingCalls.clear();
+	m_runningListingCount = 0;
+	for (auto &[id, transfer] : m_transfers) {
+		if (transfer.status == Status::Running && transfer.loader) {
+			transfer.loader->abort();
+		}
+		if (transfer.status == Status::Running || transfer.status == Status::Queued) {
+			transfer.status = Status::Aborted;
+			transfer.bytesPerSec = 0;
+		}
+	}
+	emit transfersChanged();
+}
+
+void TransferManager::clearFinished()
+{
+	for (auto it = m_transfers.begin(); it != m_transfers.end(); ) {
+		if (it->second.status == Status::Queued || it->second.status == Status::Running) {
+			++it;
+		}
+		else {
+			it = m_transfers.erase(it);
+		}
+	}
+	m_listingErrors.clear();
+	emit transfersChanged();
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "bandwidthlimiter.h"
+
+#include <QObject>
+#include <QPointer>
+#include <QStringList>
+
+#include <deque>
+#include <map>
+
+namespace shv::chainpack { class RpcValue; }
+namespace shv::iotqt::rpc { class ClientConnection; }
+
+class AbstractFileLoader;
+
+/// Queue of file transfers, runs limited number of them concurrently per broker connection
+/// and keeps their total rate under common bandwidth cap. Calls listing remote directories
+/// share the per broker limit with transfers.
+class TransferManager : public QObject
+{
+	Q_OBJECT
+
+	using Super = QObject;
+public:
+	enum class Direction {Download, Upload};
+	enum class Status {Queued, Running, Finished, Failed, Aborted};
+
+	struct Transfer
+	{
+		Direction direction = Direction::Download;
+		QPointer<shv::iotqt::rpc::ClientConnection> connection;
+		QString brokerName;
+		QString shvPath;
+		QString localPath;
+		Status status = Status::Queued;
+		qint64 bytes = 0;
+		qint64 total = -1;
+		qint64 bytesPerSec = 0;
+		QString error;
+		QPointer<AbstractFileLoader> loader;
+	};
+
+	static constexpr int MAX_LIST_DEPTH = 4;
+	static constexpr int MAX_LISTING_ERRORS = 100;
+
+	explicit TransferManager(QObject *parent = nullptr);
+
+	void addDownload(shv::iotqt::rpc::ClientConnection *conn, const QString &broker_name, const QString &shv_path, const QString &local_path);
+	void addUpload(shv::iotqt::rpc::ClientConnection *conn, const QString &broker_name, const QString &local_path, const QString &shv_path);
+	/// Lists remote directory recursively and queues download of every file node found,
+	/// directories nested deeper than MAX_LIST_DEPTH levels and nodes which names
+	/// are not safe local file names are skipped and reported in listingErrors().
+	void addRemoteDirectory(shv::iotqt::rpc::ClientConnection *conn, const QString &broker_name, const QString &shv_path, const QString &local_dir);
+
+	const std::map<int, Transfer>& transfers() const {return m_transfers;}
+	/// Listing calls queued or waiting for response.
+	int runningListingCount() const {return m_runningListingCount;}
+	/// Last MAX_LISTING_ERRORS errors of remote directory listing, cleared by clearFinished().
+	const QStringList& listingErrors() const {return m_listingErrors;}
+	qint64 totalBytesPerSec() const;
+
+	int maxConcurrentPerBroker() const {return m_maxConcurrentPerBroker;}
+	void setMaxConcurrentPerBroker(int n);
+	qint64 bandwidthLimit() const {return m_bandwidthLimiter.bytesPerSec();}
+	void setBandwidthLimit(qint64 bytes_per_sec);
+
+	void abort(int id);
+	/// Aborts all transfers and stops listing of remote directories.
+	void abortAll();
+	void clearFinished();
+
+	Q_SIGNAL void transfersChanged();
+private:
+	struct ListingRequest
+	{
+		/// List directory, or probe node with dir to find out if it is a file.
+		enum class Type {List, Probe};
+		Type type = Type::List;
+		QPointer<shv::iotqt::rpc::ClientConnection> connection;
+		QString brokerName;
+		QString shvPath;
+		QString localPath;
+		int depth = 0;
+	};
+
+	int addTransfer(Transfer &&transfer);
+	void schedule();
+	void scheduleOnce();
+	void startTransfer(int id);
+	void onTransferFinished(int id, const QString &error);
+	void listDirectory(shv::iotqt::rpc::ClientConnection *conn, const QString &broker_name, const QString &shv_path, const QString &local_dir, int depth);
+	void addListingRequest(ListingRequest &&request);
+	void startListing(ListingRequest &&request);
+	void onListed(const ListingRequest &request, const shv::chainpack::RpcValue &result);
+	void onProbed(const ListingRequest &request, const shv::chainpack::RpcValue &result, const QString &error);
+	void addListingError(const QString &error);
+private:
+	std::map<int, Transfer> m_transfers;
+	int m_nextTransferId = 1;
+	std::deque<ListingRequest> m_listingQueue;
+	/// Listing calls waiting for response per connection.
+	std::map<shv::iotqt::rpc::ClientConnection*, int> m_listingCalls;
+	int m_runningListingCount = 0;
+	QStringList m_listingErrors;
+	// loader can finish synchronously in start() and its finished handler schedules again
+	bool m_isScheduling = false;
+	bool m_isScheduleNeeded = false;
+	// listing responses of older generation are ignored after abortAll()
+	int m_listingGeneration = 0;
+	int m_maxConcurrentPerBroker;
+	BandwidthLimiter m_bandwidthLimiter;
+};